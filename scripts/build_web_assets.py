@@ -0,0 +1,96 @@
+"""
+Web asset pipeline - gzip web/*.html into src/web_assets.h
+
+Runs as a PlatformIO pre-build script (extra_scripts = pre:...) and can
+also be run by hand: python3 scripts/build_web_assets.py
+
+Each asset becomes a PROGMEM byte array plus a StaticAsset descriptor
+(see src/static_asset.h) with a content-hash ETag. The output is only
+rewritten when it changes, so incremental builds stay incremental.
+"""
+
+import gzip
+import hashlib
+import os
+import re
+
+ASSETS = [
+    # (source file, C identifier, content type)
+    ("dashboard.html", "DASHBOARD", "text/html"),
+    ("setup.html", "SETUP", "text/html"),
+]
+
+
+def project_dir():
+    try:
+        Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+        return env["PROJECT_DIR"]  # noqa: F821
+    except NameError:
+        return os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def minify_html(text):
+    # Conservative: drop leading indentation and blank lines only
+    lines = [line.strip() for line in text.splitlines()]
+    return "\n".join(line for line in lines if line) + "\n"
+
+
+def c_bytes(data, per_line=20):
+    rows = []
+    for i in range(0, len(data), per_line):
+        rows.append("    " + ",".join("0x%02x" % b for b in data[i:i + per_line]) + ",")
+    return "\n".join(rows)
+
+
+def build(root):
+    web_dir = os.path.join(root, "web")
+    out_path = os.path.join(root, "src", "web_assets.h")
+
+    parts = [
+        "/*",
+        " * Generated by scripts/build_web_assets.py from web/ - do not edit",
+        " */",
+        "",
+        "#ifndef WEB_ASSETS_H",
+        "#define WEB_ASSETS_H",
+        "",
+        '#include "static_asset.h"',
+        "",
+    ]
+
+    for filename, ident, content_type in ASSETS:
+        with open(os.path.join(web_dir, filename), "r", encoding="utf-8") as f:
+            raw = minify_html(f.read()).encode("utf-8")
+
+        # mtime=0 keeps the output (and the ETag) reproducible
+        packed = gzip.compress(raw, compresslevel=9, mtime=0)
+        etag = '\\"%s\\"' % hashlib.sha1(raw).hexdigest()[:16]
+
+        parts += [
+            "// %s: %d bytes raw, %d bytes gzip" % (filename, len(raw), len(packed)),
+            "const uint8_t %s_GZ[] PROGMEM = {" % ident,
+            c_bytes(packed),
+            "};",
+            "",
+            "const StaticAsset %s_ASSET = {" % ident,
+            "    %s_GZ, sizeof(%s_GZ), %d, \"%s\", \"%s\"" % (ident, ident, len(raw), etag, content_type),
+            "};",
+            "",
+        ]
+
+    parts += ["#endif // WEB_ASSETS_H", ""]
+    output = "\n".join(parts)
+
+    if os.path.exists(out_path):
+        with open(out_path, "r", encoding="utf-8") as f:
+            if f.read() == output:
+                return
+
+    with open(out_path, "w", encoding="utf-8") as f:
+        f.write(output)
+
+    for line in re.findall(r"^// (.*gzip)$", output, re.M):
+        print("web asset: " + line)
+
+
+build(project_dir())
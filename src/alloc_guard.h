@@ -0,0 +1,194 @@
+/*
+ * Allocation Guard - Counts heap allocations after the "ready" point
+ * Keyless mode is meant to run for months without touching the heap; the
+ * guard makes any regression visible. Debug builds only (env:esp32dev-allocguard):
+ * -DALLOC_GUARD=1 plus -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc
+ * route every malloc/calloc/realloc/operator new in the image through
+ * onAlloc() (allocations IDF makes with heap_caps_* directly are not seen).
+ *
+ * After markReady() each allocation is attributed to the calling task and
+ * the last ALLOC_GUARD_RECENT call sites are kept for addr2line. The
+ * keyless tasks (loop, bleScan, resolve, diag) must stay at zero. The
+ * network task is shown but not counted: WebServer builds Strings for
+ * every request (arguments, headers), as do the WiFi, lwIP and Bluedroid
+ * tasks per packet/advert.
+ */
+
+#ifndef ALLOC_GUARD_H
+#define ALLOC_GUARD_H
+
+#include <Arduino.h>
+#include <esp_attr.h>
+#include <stdarg.h>
+
+#ifndef ALLOC_GUARD
+#define ALLOC_GUARD 0
+#endif
+
+#define ALLOC_GUARD_MAX_TASKS 16
+#define ALLOC_GUARD_RECENT 8
+#define ALLOC_GUARD_APP_TASKS 4         // loop, bleScan, resolve, diag
+#define ALLOC_GUARD_SETTLE_MS 30000     // Keyless start -> ready (WiFi, NTP, first scans)
+#define ALLOC_GUARD_REPORT_MS 60000     // Serial warning cadence while app tasks allocate
+
+class AllocGuard {
+private:
+    struct TaskCount {
+        TaskHandle_t task;
+        uint32_t count;
+        uint32_t bytes;
+    };
+
+    struct Site {
+        TaskHandle_t task;
+        void* caller;
+        uint32_t size;
+    };
+
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+    volatile bool ready = false;
+    uint32_t beforeReady = 0;
+    uint32_t afterReady = 0;
+    TaskCount tasks[ALLOC_GUARD_MAX_TASKS];
+    int taskCount = 0;
+    uint32_t untracked = 0;             // Task table full
+    Site recent[ALLOC_GUARD_RECENT];
+    uint32_t recentHead = 0;
+
+    TaskHandle_t appTasks[ALLOC_GUARD_APP_TASKS] = {nullptr, nullptr, nullptr, nullptr};
+    TaskHandle_t networkTask = nullptr;     // Informational only
+    uint32_t lastReportedApp = 0;
+    uint32_t lastReport = 0;
+
+    // Serial.printf() mallocs for lines over 64 bytes; format on the stack
+    static void printLine(const char* format, ...) {
+        char line[128];
+        va_list args;
+        va_start(args, format);
+        vsnprintf(line, sizeof(line), format, args);
+        va_end(args);
+        Serial.print(line);
+    }
+
+public:
+    // From the malloc wrappers; may run with the flash cache disabled
+    void IRAM_ATTR onAlloc(size_t size, void* caller) {
+        portENTER_CRITICAL_SAFE(&mux);
+        if (!ready) {
+            beforeReady++;
+        } else {
+            afterReady++;
+            TaskHandle_t task = xTaskGetCurrentTaskHandle();
+            int i = 0;
+            while (i < taskCount && tasks[i].task != task) i++;
+            if (i == taskCount && taskCount < ALLOC_GUARD_MAX_TASKS) {
+                tasks[taskCount++] = {task, 0, 0};
+            }
+            if (i < taskCount) {
+                tasks[i].count++;
+                tasks[i].bytes += size;
+            } else {
+                untracked++;
+            }
+            recent[recentHead % ALLOC_GUARD_RECENT] = {task, caller, (uint32_t)size};
+            recentHead++;
+        }
+        portEXIT_CRITICAL_SAFE(&mux);
+    }
+
+    // Tasks whose allocations count as regressions, and the network task
+    // (labelled in the report, not counted)
+    void setAppTasks(TaskHandle_t loop, TaskHandle_t scan, TaskHandle_t resolve, TaskHandle_t diagTask,
+                     TaskHandle_t network) {
+        appTasks[0] = loop;
+        appTasks[1] = scan;
+        appTasks[2] = resolve;
+        appTasks[3] = diagTask;
+        networkTask = network;
+    }
+
+    void markReady() {
+        if (ready) return;
+        ready = true;
+        Serial.printf("ALLOC guard ready (%lu allocations during startup)\n", (unsigned long)beforeReady);
+    }
+
+    bool isReady() {
+        return ready;
+    }
+
+    bool isEnabled() {
+        return ALLOC_GUARD;
+    }
+
+    // Allocations after ready from the application tasks
+    uint32_t getAppCount() {
+        uint32_t n = 0;
+        portENTER_CRITICAL(&mux);
+        for (int i = 0; i < taskCount; i++) {
+            for (int a = 0; a < ALLOC_GUARD_APP_TASKS; a++) {
+                if (appTasks[a] && tasks[i].task == appTasks[a]) n += tasks[i].count;
+            }
+        }
+        portEXIT_CRITICAL(&mux);
+        return n;
+    }
+
+    uint32_t getTotalCount() {
+        return afterReady;
+    }
+
+    // Network task: warn (rate limited) when application tasks allocated
+    void update() {
+        if (!ALLOC_GUARD || !ready) return;
+        uint32_t now = millis();
+        if (now - lastReport < ALLOC_GUARD_REPORT_MS) return;
+        lastReport = now;
+
+        uint32_t app = getAppCount();
+        if (app != lastReportedApp) {
+            printLine("ALLOC %lu new allocations in app tasks (%lu total), 'a' for details\n",
+                (unsigned long)(app - lastReportedApp), (unsigned long)app);
+            lastReportedApp = app;
+        }
+    }
+
+    // Per-task counts and the most recent call sites (addr2line -e firmware.elf <addr>)
+    void printReport() {
+        if (!ALLOC_GUARD) {
+            Serial.println("ALLOC guard not built in (pio run -e esp32dev-allocguard)");
+            return;
+        }
+        TaskCount copy[ALLOC_GUARD_MAX_TASKS];
+        Site sites[ALLOC_GUARD_RECENT];
+        portENTER_CRITICAL(&mux);
+        int n = taskCount;
+        memcpy(copy, tasks, sizeof(copy));
+        memcpy(sites, recent, sizeof(sites));
+        uint32_t head = recentHead;
+        uint32_t total = afterReady;
+        uint32_t lost = untracked;
+        portEXIT_CRITICAL(&mux);
+
+        printLine("ALLOC %s: %lu after ready, %lu before, %lu untracked\n",
+            ready ? "ready" : "not ready", (unsigned long)total, (unsigned long)beforeReady, (unsigned long)lost);
+        for (int i = 0; i < n; i++) {
+            bool app = false;
+            for (int a = 0; a < ALLOC_GUARD_APP_TASKS; a++) app |= appTasks[a] && copy[i].task == appTasks[a];
+            bool network = networkTask && copy[i].task == networkTask;
+            printLine("ALLOC %-16s %8lu allocs %10lu bytes%s\n", pcTaskGetName(copy[i].task),
+                (unsigned long)copy[i].count, (unsigned long)copy[i].bytes,
+                app ? "  <- app" : network ? "  (web requests, not counted)" : "");
+        }
+        uint32_t shown = min(head, (uint32_t)ALLOC_GUARD_RECENT);
+        for (uint32_t k = 0; k < shown; k++) {
+            const Site& site = sites[(head - shown + k) % ALLOC_GUARD_RECENT];
+            printLine("ALLOC recent %-16s %5lu bytes from %p\n", pcTaskGetName(site.task),
+                (unsigned long)site.size, site.caller);
+        }
+    }
+};
+
+extern AllocGuard allocGuard;
+
+#endif // ALLOC_GUARD_H
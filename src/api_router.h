@@ -0,0 +1,208 @@
+/*
+ * API Router - Parameterized route table for the REST API
+ * One RequestHandler with fixed-size route storage instead of one
+ * heap-allocated handler per URI. Routes are bucketed by method, segment
+ * count and literal prefix, so dispatch cost does not depend on the number
+ * of devices or routes.
+ */
+
+#ifndef API_ROUTER_H
+#define API_ROUTER_H
+
+#include <WebServer.h>
+
+// Configuration
+#define MAX_ROUTES 16
+#define MAX_ROUTE_PARAMS 2
+#define ROUTE_PARAM_MAX_DIGITS 9   // Always fits an int; longer ids do not match
+#define ROUTE_BUCKETS 16   // Power of two
+
+// Numeric path parameters extracted from "{...}" segments, in order
+// (0 to 999999999)
+struct RouteParams {
+    uint8_t count;
+    long values[MAX_ROUTE_PARAMS];
+};
+
+template <typename Owner>
+class ApiRouter : public RequestHandler {
+public:
+    typedef void (Owner::*Handler)(const RouteParams& params);
+    typedef void (*HandledHook)(uint32_t handlerUs);
+
+private:
+    struct Route {
+        const char* pattern;    // e.g. "/api/devices/{id}/name" (static string)
+        Handler handler;
+        uint8_t method;
+        int8_t next;            // Next route in the same bucket (-1 = end)
+    };
+
+    Owner* owner = nullptr;
+    Route routes[MAX_ROUTES];
+    int8_t buckets[ROUTE_BUCKETS];
+    uint8_t routeCount = 0;
+
+    // Match state from canHandle(), consumed by handle() of the same request
+    int8_t matchedRoute = -1;
+    RouteParams matchedParams;
+
+    // Dispatch timing (route lookup only, not the handler body)
+    uint32_t lastDispatchUs = 0;
+    uint32_t maxDispatchUs = 0;
+    HandledHook handledHook = nullptr;
+
+    // Hash of the first two segments ("/api/devices") plus segment count.
+    // Returns the segment count, or -1 if a parameter sits inside the prefix.
+    static int scanPath(const char* path, uint32_t* prefixHash) {
+        uint32_t hash = 2166136261u;  // FNV-1a
+        int segments = 0;
+        const char* p = path;
+
+        while (*p) {
+            while (*p == '/') p++;
+            if (!*p) break;
+
+            segments++;
+            if (segments <= 2 && *p == '{') return -1;
+
+            while (*p && *p != '/') {
+                if (segments <= 2) {
+                    hash ^= (uint8_t)*p;
+                    hash *= 16777619u;
+                }
+                p++;
+            }
+            if (segments <= 2) {
+                hash ^= '/';
+                hash *= 16777619u;
+            }
+        }
+
+        *prefixHash = hash;
+        return segments;
+    }
+
+    static uint8_t bucketFor(uint8_t method, int segments, uint32_t prefixHash) {
+        uint32_t key = prefixHash ^ ((uint32_t)method * 31u) ^ ((uint32_t)segments << 8);
+        key ^= key >> 16;
+        return key & (ROUTE_BUCKETS - 1);
+    }
+
+    static bool matchRoute(const char* pattern, const char* uri, RouteParams& params) {
+        const char* p = pattern;
+        const char* u = uri;
+        params.count = 0;
+
+        for (;;) {
+            while (*p == '/') p++;
+            while (*u == '/') u++;
+            if (!*p || !*u) break;
+
+            const char* pEnd = p;
+            while (*pEnd && *pEnd != '/') pEnd++;
+            const char* uEnd = u;
+            while (*uEnd && *uEnd != '/') uEnd++;
+
+            if (*p == '{') {
+                // Parameter segment: must be all digits, at most 9 of them
+                if (params.count >= MAX_ROUTE_PARAMS || u == uEnd) return false;
+                if (uEnd - u > ROUTE_PARAM_MAX_DIGITS) return false;
+                long value = 0;
+                for (const char* c = u; c < uEnd; c++) {
+                    if (*c < '0' || *c > '9') return false;
+                    value = value * 10 + (*c - '0');
+                }
+                params.values[params.count++] = value;
+            } else {
+                size_t len = pEnd - p;
+                if ((size_t)(uEnd - u) != len || strncmp(p, u, len) != 0) return false;
+            }
+
+            p = pEnd;
+            u = uEnd;
+        }
+
+        return !*p && !*u;
+    }
+
+    int8_t findRoute(uint8_t method, const char* uri, RouteParams& params) {
+        uint32_t prefixHash;
+        int segments = scanPath(uri, &prefixHash);
+        if (segments < 0) return -1;
+
+        int8_t i = buckets[bucketFor(method, segments, prefixHash)];
+        while (i >= 0) {
+            if (routes[i].method == method && matchRoute(routes[i].pattern, uri, params)) {
+                return i;
+            }
+            i = routes[i].next;
+        }
+        return -1;
+    }
+
+public:
+    ApiRouter() {
+        for (int i = 0; i < ROUTE_BUCKETS; i++) buckets[i] = -1;
+        matchedParams.count = 0;
+    }
+
+    void begin(Owner* ownerPtr) {
+        owner = ownerPtr;
+    }
+
+    // Register a route; pattern must outlive the router (use string literals)
+    bool on(HTTPMethod method, const char* pattern, Handler handler) {
+        if (routeCount >= MAX_ROUTES) return false;
+
+        uint32_t prefixHash;
+        int segments = scanPath(pattern, &prefixHash);
+        if (segments < 0) return false;
+
+        uint8_t bucket = bucketFor((uint8_t)method, segments, prefixHash);
+        Route& r = routes[routeCount];
+        r.pattern = pattern;
+        r.handler = handler;
+        r.method = (uint8_t)method;
+        r.next = buckets[bucket];
+        buckets[bucket] = routeCount;
+        routeCount++;
+        return true;
+    }
+
+    bool canHandle(HTTPMethod method, String uri) override {
+        uint32_t start = micros();
+        matchedRoute = findRoute((uint8_t)method, uri.c_str(), matchedParams);
+        lastDispatchUs = micros() - start;
+        if (lastDispatchUs > maxDispatchUs) maxDispatchUs = lastDispatchUs;
+        return matchedRoute >= 0;
+    }
+
+    bool handle(WebServer& server, HTTPMethod requestMethod, String requestUri) override {
+        (void)server;
+        (void)requestMethod;
+        (void)requestUri;
+        if (matchedRoute < 0 || !owner) return false;
+
+        uint32_t start = micros();
+        (owner->*routes[matchedRoute].handler)(matchedParams);
+        if (handledHook) handledHook(micros() - start);
+
+        matchedRoute = -1;
+        return true;
+    }
+
+    // Called after every handler with its duration (e.g. for a histogram)
+    void onHandled(HandledHook hook) {
+        handledHook = hook;
+    }
+
+    uint32_t getLastDispatchUs() { return lastDispatchUs; }
+    uint32_t getMaxDispatchUs() { return maxDispatchUs; }
+    uint8_t getRouteCount() { return routeCount; }
+
+    // Total RAM used by the route table (constant, independent of MAX_DEVICES)
+    size_t getMemoryFootprint() { return sizeof(*this); }
+};
+
+#endif // API_ROUTER_H
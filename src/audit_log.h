@@ -8,6 +8,10 @@
 
 #include <time.h>
 #include "storage.h"
+#include "log_export.h"
+#include "metrics.h"
+#include "trace.h"
+#include "diag.h"
 
 // Action types
 #define ACTION_LOCK   0
@@ -16,11 +20,28 @@
 class AuditLog {
 private:
     Storage* storage;
+    Rollup* rollup = nullptr;       // Usage aggregates, fed with every event
 
-    // NTP synchronization state
-    time_t ntpSyncTime = 0;         // Unix time when NTP synced
-    uint32_t ntpSyncMillis = 0;     // millis() when NTP synced
+    // NTP synchronization state (written from the SNTP callback, lwIP task)
+    portMUX_TYPE timeMux = portMUX_INITIALIZER_UNLOCKED;
+    int64_t ntpSyncUnixMs = 0;      // Unix time (ms) at the last sync
+    uint32_t ntpSyncMillis = 0;     // millis() at the last sync
     bool ntpSynced = false;
+    uint32_t ntpSyncCount = 0;
+    int32_t lastDriftMs = 0;        // Correction applied by the last resync
+
+    // Unix time in ms for a millis() value of this boot, up to ~49 days
+    // old (caller checks ntpSynced). Goes through now: the sync and
+    // `logMillis` are both in the past, so both offsets are unsigned
+    // elapsed times, where a signed offset from the sync would break 24.8
+    // days after it (and for entries logged before a resync).
+    int64_t millisToUnixMs(uint32_t logMillis) {
+        portENTER_CRITICAL(&timeMux);
+        uint32_t now = millis();
+        int64_t unixMs = ntpSyncUnixMs + (uint32_t)(now - ntpSyncMillis) - (int64_t)(uint32_t)(now - logMillis);
+        portEXIT_CRITICAL(&timeMux);
+        return unixMs;
+    }
 
 public:
     void begin(Storage* storagePtr) {
@@ -28,12 +49,40 @@ public:
         storage->loadLog();
     }
 
-    // Called after NTP sync succeeds
-    void setNtpSync(time_t unixTime) {
-        ntpSyncTime = unixTime;
-        ntpSyncMillis = millis();
+    void setRollup(Rollup* rollupPtr) {
+        rollup = rollupPtr;
+    }
+
+    // Called after every successful NTP sync (first sync and periodic resyncs)
+    void setNtpSync(time_t unixTime, uint32_t usec = 0) {
+        uint32_t nowMillis = millis();
+        int64_t unixMs = (int64_t)unixTime * 1000 + usec / 1000;
+
+        portENTER_CRITICAL(&timeMux);
+        bool firstSync = !ntpSynced;
+        if (ntpSynced) {
+            int64_t predicted = ntpSyncUnixMs + (uint32_t)(nowMillis - ntpSyncMillis);
+            lastDriftMs = (int32_t)(unixMs - predicted);
+        }
+        ntpSyncUnixMs = unixMs;
+        ntpSyncMillis = nowMillis;
         ntpSynced = true;
-        Serial.printf("NTP synced: %ld at millis %lu\n", (long)unixTime, ntpSyncMillis);
+        ntpSyncCount++;
+        portEXIT_CRITICAL(&timeMux);
+
+        // Entries logged since boot get their wall-clock time now
+        if (firstSync) storage->backfillUnixTime(nowMillis, (uint32_t)(unixMs / 1000));
+
+        DIAG_INFO("NTP synced: %ld at millis %lu (drift %ldms)",
+            (long)unixTime, (unsigned long)nowMillis, (long)lastDriftMs);
+    }
+
+    uint32_t getNtpSyncCount() {
+        return ntpSyncCount;
+    }
+
+    int32_t getLastDriftMs() {
+        return lastDriftMs;
     }
 
     bool isNtpSynced() {
@@ -44,8 +93,12 @@ public:
     time_t millisToRealTime(uint32_t logMillis) {
         if (!ntpSynced) return 0;
 
-        int32_t diff = (int32_t)(logMillis - ntpSyncMillis);
-        return ntpSyncTime + (diff / 1000);
+        return (time_t)(millisToUnixMs(logMillis) / 1000);
+    }
+
+    // Wall clock now in seconds, 0 before the first NTP sync
+    uint32_t unixNow() {
+        return ntpSynced ? (uint32_t)(millisToUnixMs(millis()) / 1000) : 0;
     }
 
     // Get current time (real or relative)
@@ -55,9 +108,20 @@ public:
 
     // Log an event
     void logEvent(uint8_t deviceIndex, uint8_t action, int8_t rssi) {
-        storage->addLogEntry(deviceIndex, action, rssi, millis());
+        uint32_t start = micros();
+        uint32_t now = millis();
+        uint32_t unixTime = ntpSynced ? (uint32_t)(millisToUnixMs(now) / 1000) : 0;
+        trace.record(TRACE_NVS_START);
+        storage->addLogEntry(deviceIndex, action, rssi, now, unixTime);
+        trace.record(TRACE_NVS_END);
+        metrics.nvsWrite.observe(micros() - start);
+
+        if (rollup) {
+            if (action == ACTION_UNLOCK) rollup->onUnlock(deviceIndex, rssi, unixTime);
+            else rollup->onLock(deviceIndex, unixTime);
+        }
 
-        Serial.printf("LOG: Device %d, Action %s, RSSI %d\n",
+        DIAG_INFO("LOG: Device %d, Action %s, RSSI %d",
             deviceIndex,
             action == ACTION_UNLOCK ? "UNLOCK" : "LOCK",
             rssi);
@@ -76,28 +140,62 @@ public:
             uint32_t hours = minutes / 60;
 
             if (hours > 0) {
-                snprintf(buffer, bufSize, "+%luh%02lum", hours, minutes % 60);
+                snprintf(buffer, bufSize, "+%luh%02lum", (unsigned long)hours, (unsigned long)(minutes % 60));
             } else if (minutes > 0) {
-                snprintf(buffer, bufSize, "+%lum%02lus", minutes, seconds % 60);
+                snprintf(buffer, bufSize, "+%lum%02lus", (unsigned long)minutes, (unsigned long)(seconds % 60));
             } else {
-                snprintf(buffer, bufSize, "+%lus", seconds);
+                snprintf(buffer, bufSize, "+%lus", (unsigned long)seconds);
             }
         }
     }
 
-    // Get formatted log entry for JSON
+    // Get formatted log entry for JSON; "unix" is 0 when the wall-clock
+    // time is unknown (logged before NTP sync in an earlier boot)
     void getLogEntryJson(LogEntry* entry, char* buffer, size_t bufSize, const char* deviceName) {
         char timeStr[16];
-        formatTime(entry->timestamp, timeStr, sizeof(timeStr));
+        if (entry->unixTime != 0) {
+            time_t realTime = entry->unixTime;
+            struct tm* timeinfo = localtime(&realTime);
+            strftime(timeStr, sizeof(timeStr), "%H:%M:%S", timeinfo);
+        } else {
+            formatTime(entry->timestamp, timeStr, sizeof(timeStr));
+        }
 
         snprintf(buffer, bufSize,
-            "{\"time\":\"%s\",\"device\":\"%s\",\"action\":\"%s\",\"rssi\":%d}",
+            "{\"seq\":%lu,\"time\":\"%s\",\"unix\":%lu,\"device\":\"%s\",\"action\":\"%s\",\"rssi\":%d}",
+            (unsigned long)entry->seq,
             timeStr,
+            (unsigned long)entry->unixTime,
             deviceName,
             entry->action == ACTION_UNLOCK ? "Unlock" : "Lock",
             entry->rssi);
     }
 
+    // Fill a binary export record, with absolute time where it is known
+    void getLogEntryRecord(const LogEntry* entry, LogExportRecord* record) {
+        record->seq = entry->seq;
+        record->deviceIndex = entry->deviceIndex;
+        record->action = entry->action;
+        record->rssi = entry->rssi;
+
+        bool thisBoot = entry->seq >= storage->bootSeq;
+        if (thisBoot && ntpSynced) {
+            record->timeMs = (uint64_t)millisToUnixMs(entry->timestamp);
+            record->flags = LOG_RECORD_ABSOLUTE;
+        } else if (entry->unixTime != 0) {
+            // Stamped when it was logged (second resolution)
+            record->timeMs = (uint64_t)entry->unixTime * 1000;
+            record->flags = LOG_RECORD_ABSOLUTE;
+        } else if (!thisBoot) {
+            // millis() from an earlier boot cannot be mapped to wall time
+            record->timeMs = 0;
+            record->flags = LOG_RECORD_PREV_BOOT;
+        } else {
+            record->timeMs = entry->timestamp;
+            record->flags = 0;
+        }
+    }
+
     int getEntryCount() {
         return storage->logCount;
     }
@@ -0,0 +1,144 @@
+/*
+ * Bench Harness - Microbenchmarks for the portable modules (native build)
+ * A case runs its operation `iterations` times per call. The runner warms
+ * it up, calibrates the iteration count to ~BENCH_TARGET_REP_MS per
+ * repetition, then times BENCH_DEFAULT_REPS repetitions and reports
+ * median/min/max ns/op plus heap allocations/op (global operator new).
+ *
+ * Output is one JSON object per case per line (or a table, --format table).
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+
+#define BENCH_MAX_CASES 64
+#define BENCH_MAX_REPS 100
+#define BENCH_DEFAULT_REPS 15
+#define BENCH_WARMUP_MS 50
+#define BENCH_TARGET_REP_MS 20
+
+typedef void (*BenchFn)(uint32_t iterations);
+
+struct BenchCase {
+    const char* name;
+    const char* group;
+    BenchFn fn;
+};
+
+struct BenchResult {
+    uint32_t iterations;        // Per repetition
+    int reps;
+    double nsMedian;
+    double nsMin;
+    double nsMax;
+    double allocsPerOp;
+    double bytesPerOp;
+};
+
+// Defined in bench_main.cpp (operator new hooks)
+extern std::atomic<uint64_t> benchAllocCount;
+extern std::atomic<uint64_t> benchAllocBytes;
+
+// Keeps results observable so the optimizer cannot drop the work
+extern volatile uint32_t benchSink;
+
+class BenchRegistry {
+private:
+    BenchCase cases[BENCH_MAX_CASES];
+    int caseCount = 0;
+
+    static uint64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static uint64_t timeRun(BenchFn fn, uint32_t iterations) {
+        uint64_t start = nowNs();
+        fn(iterations);
+        return nowNs() - start;
+    }
+
+public:
+    static BenchRegistry& instance() {
+        static BenchRegistry registry;
+        return registry;
+    }
+
+    void add(const char* group, const char* name, BenchFn fn) {
+        if (caseCount >= BENCH_MAX_CASES) {
+            fprintf(stderr, "bench: too many cases, %s dropped\n", name);
+            return;
+        }
+        cases[caseCount++] = {name, group, fn};
+    }
+
+    int count() {
+        return caseCount;
+    }
+
+    const BenchCase& get(int i) {
+        return cases[i];
+    }
+
+    static BenchResult run(const BenchCase& c, int reps) {
+        reps = std::max(1, std::min(reps, BENCH_MAX_REPS));
+
+        // Warmup doubles as calibration: grow until one run takes >= 1 ms
+        uint32_t iterations = 1;
+        uint64_t elapsed = 0;
+        uint64_t warmupEnd = nowNs() + BENCH_WARMUP_MS * 1000000ULL;
+        for (;;) {
+            elapsed = timeRun(c.fn, iterations);
+            if (elapsed >= 1000000ULL || iterations >= (1u << 30)) break;
+            iterations *= 2;
+        }
+        while (nowNs() < warmupEnd) c.fn(iterations);
+
+        uint64_t perRep = (uint64_t)iterations * BENCH_TARGET_REP_MS * 1000000ULL / std::max<uint64_t>(elapsed, 1);
+        iterations = (uint32_t)std::max<uint64_t>(1, std::min<uint64_t>(perRep, 1u << 30));
+
+        double ns[BENCH_MAX_REPS];
+        uint64_t allocs = benchAllocCount.load();
+        uint64_t bytes = benchAllocBytes.load();
+        for (int r = 0; r < reps; r++) {
+            ns[r] = (double)timeRun(c.fn, iterations) / iterations;
+        }
+        allocs = benchAllocCount.load() - allocs;
+        bytes = benchAllocBytes.load() - bytes;
+
+        std::sort(ns, ns + reps);
+        BenchResult result;
+        result.iterations = iterations;
+        result.reps = reps;
+        result.nsMedian = (reps % 2) ? ns[reps / 2] : (ns[reps / 2 - 1] + ns[reps / 2]) / 2;
+        result.nsMin = ns[0];
+        result.nsMax = ns[reps - 1];
+        result.allocsPerOp = (double)allocs / ((double)iterations * reps);
+        result.bytesPerOp = (double)bytes / ((double)iterations * reps);
+        return result;
+    }
+};
+
+struct BenchRegistrar {
+    BenchRegistrar(const char* group, const char* name, BenchFn fn) {
+        BenchRegistry::instance().add(group, name, fn);
+    }
+};
+
+// Crowded-RF load ramp (bench_stress.cpp, --stress-ramp)
+int benchStressRamp(double cpuScale, bool table);
+
+// BENCH_CASE(group, name) { for (uint32_t i = 0; i < iterations; i++) ... }
+#define BENCH_CASE(group, name) \
+    static void bench_##group##_##name(uint32_t iterations); \
+    static BenchRegistrar benchRegistrar_##group##_##name(#group, #group "/" #name, bench_##group##_##name); \
+    static void bench_##group##_##name(uint32_t iterations)
+
+#endif // BENCH_H
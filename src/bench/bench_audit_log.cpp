@@ -0,0 +1,57 @@
+/*
+ * Audit Log Benchmarks - Timestamp formatting and JSON entry generation,
+ * both before NTP sync (uptime strings) and after (localtime + strftime)
+ */
+
+#include "bench.h"
+#include "audit_log.h"
+
+static Storage storage;
+static AuditLog unsyncedLog;
+static AuditLog syncedLog;
+
+static bool setup() {
+    storage.begin();
+    unsyncedLog.begin(&storage);
+    syncedLog.begin(&storage);
+    syncedLog.setNtpSync(1767225600);     // 2026-01-01 00:00:00 UTC
+    return true;
+}
+
+static bool ready = setup();
+
+BENCH_CASE(auditlog, format_time_uptime) {
+    char buffer[16];
+    for (uint32_t i = 0; i < iterations; i++) {
+        unsyncedLog.formatTime(3723000 + i, buffer, sizeof(buffer));
+        benchSink += buffer[1];
+    }
+}
+
+BENCH_CASE(auditlog, format_time_ntp) {
+    char buffer[16];
+    for (uint32_t i = 0; i < iterations; i++) {
+        syncedLog.formatTime(3723000 + i, buffer, sizeof(buffer));
+        benchSink += buffer[1];
+    }
+}
+
+BENCH_CASE(auditlog, entry_json_uptime) {
+    LogEntry entry = {42, 3723000, 0, 3, 1, -67, 0};
+    char buffer[128];
+    for (uint32_t i = 0; i < iterations; i++) {
+        entry.timestamp = 3723000 + i;
+        unsyncedLog.getLogEntryJson(&entry, buffer, sizeof(buffer), "Device_04");
+        benchSink += buffer[8];
+    }
+}
+
+BENCH_CASE(auditlog, entry_json_ntp) {
+    LogEntry entry = {42, 3723000, 0, 3, 1, -67, 0};
+    char buffer[128];
+    for (uint32_t i = 0; i < iterations; i++) {
+        entry.timestamp = 3723000 + i;
+        syncedLog.getLogEntryJson(&entry, buffer, sizeof(buffer), "Device_04");
+        benchSink += buffer[8];
+    }
+}
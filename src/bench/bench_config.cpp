@@ -0,0 +1,26 @@
+/*
+ * Config Benchmarks - Threshold snapshot reads on the per-advert path and
+ * publishes from the dashboard (config_snapshot.h)
+ */
+
+#include "bench.h"
+#include "config_snapshot.h"
+#include "keyless_config.h"
+
+static const ProximityConfig config = {-90, -80, 10000, 3};
+static ConfigSnapshot<ProximityConfig> snapshot(config);
+
+BENCH_CASE(config, snapshot_read) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        benchSink += snapshot.read().lockRssi;
+    }
+}
+
+BENCH_CASE(config, snapshot_publish) {
+    ProximityConfig next = config;
+    for (uint32_t i = 0; i < iterations; i++) {
+        next.weakThreshold = 1 + i % KEYLESS_WEAK_MAX;
+        snapshot.publish(next);
+    }
+    benchSink += snapshot.read().weakThreshold;
+}
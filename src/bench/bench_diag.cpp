@@ -0,0 +1,27 @@
+/*
+ * Diag Benchmarks - The cost a DIAG_* call adds to a hot path (record only)
+ * and the deferred formatting the drain task and /api/diag pay per line
+ */
+
+#include "bench.h"
+#include "diag.h"
+
+static const char* const NAMES[] = {"iPhone", "Backup"};
+
+BENCH_CASE(diag, record) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        DIAG_INFO("🔓 %s unlock at %d dBm (%lums)", NAMES[i & 1], -60 - (int)(i & 15), (unsigned long)i);
+    }
+    benchSink += diag.getHead();
+}
+
+BENCH_CASE(diag, format) {
+    DIAG_INFO("🔓 %s unlock at %d dBm (%lums)", NAMES[0], -63, 1234UL);
+    DiagRecord r;
+    uint32_t next;
+    diag.readSince(diag.getHead() - 1, &r, 1, &next);
+    char line[DIAG_LINE_MAX];
+    for (uint32_t i = 0; i < iterations; i++) {
+        benchSink += DiagLog::format(r, line, sizeof(line));
+    }
+}
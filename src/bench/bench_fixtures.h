@@ -0,0 +1,31 @@
+/*
+ * Bench Fixtures - Deterministic device table and RPAs shared by cases
+ */
+
+#ifndef BENCH_FIXTURES_H
+#define BENCH_FIXTURES_H
+
+#include <stdio.h>
+#include "rpa.h"
+#include "storage.h"
+
+// `count` paired devices with fixed IRKs
+inline void benchMakeDevices(StoredDevice* devices, int count = MAX_DEVICES) {
+    for (int d = 0; d < count; d++) {
+        for (int i = 0; i < 16; i++) devices[d].irk[i] = (uint8_t)(d * 31 + i * 7 + 1);
+        snprintf(devices[d].name, sizeof(devices[d].name), "Device_%02d", d + 1);
+        devices[d].active = true;
+    }
+}
+
+// RPA for `irk` from a given prand
+inline void benchMakeRpa(const uint8_t* irk, uint8_t p0, uint8_t p1, uint8_t p2, uint8_t* rpa) {
+    makeRPA(irk, (uint32_t)p0 << 16 | (uint32_t)p1 << 8 | p2, rpa);
+}
+
+// An IRK no paired device uses
+inline void benchForeignIrk(uint8_t* irk) {
+    for (int i = 0; i < 16; i++) irk[i] = (uint8_t)(0xA5 ^ i);
+}
+
+#endif // BENCH_FIXTURES_H
@@ -0,0 +1,147 @@
+/*
+ * Benchmark Runner - Native build entry point (pio run -e native)
+ *
+ *   program                       all cases, JSON lines on stdout
+ *   program --filter rpa          cases whose name contains "rpa"
+ *   program --reps 30             repetitions per case
+ *   program --format table        human-readable table
+ *   program --list                case names only
+ *   program --max-allocs 0        exit 1 if any case allocates more per op
+ *   program --stress-ramp         ingestion under rising advert load
+ *   program --stress-ramp --cpu-scale 20   ... with every advert 20x slower
+ */
+
+#include <stdlib.h>
+#include <new>
+#include "bench.h"
+#include "metrics.h"
+#include "trace.h"
+#include "diag.h"
+
+// Module globals normally defined in main.cpp
+Metrics metrics;
+Trace trace;
+DiagLog diag;
+
+std::atomic<uint64_t> benchAllocCount{0};
+std::atomic<uint64_t> benchAllocBytes{0};
+volatile uint32_t benchSink = 0;
+
+// ========== Allocation counting ==========
+
+void* operator new(size_t size) {
+    benchAllocCount.fetch_add(1, std::memory_order_relaxed);
+    benchAllocBytes.fetch_add(size, std::memory_order_relaxed);
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    free(p);
+}
+
+// ========== Output ==========
+
+static void printJson(const BenchCase& c, const BenchResult& r) {
+    printf("{\"bench\":\"%s\",\"group\":\"%s\",\"iterations\":%lu,\"reps\":%d,"
+           "\"ns_per_op\":%.2f,\"ns_min\":%.2f,\"ns_max\":%.2f,"
+           "\"allocs_per_op\":%.4f,\"bytes_per_op\":%.2f}\n",
+        c.name, c.group, (unsigned long)r.iterations, r.reps,
+        r.nsMedian, r.nsMin, r.nsMax, r.allocsPerOp, r.bytesPerOp);
+}
+
+static void printTableHeader() {
+    printf("%-36s %12s %10s %10s %10s %10s\n", "bench", "iterations", "ns/op", "min", "max", "allocs/op");
+}
+
+static void printTableRow(const BenchCase& c, const BenchResult& r) {
+    printf("%-36s %12lu %10.1f %10.1f %10.1f %10.3f\n",
+        c.name, (unsigned long)r.iterations, r.nsMedian, r.nsMin, r.nsMax, r.allocsPerOp);
+}
+
+static void usage(const char* program) {
+    fprintf(stderr, "usage: %s [--filter SUBSTR] [--reps N] [--format json|table] [--list] [--max-allocs N]\n"
+                    "       %s --stress-ramp [--cpu-scale X] [--format json|table]\n", program, program);
+}
+
+int main(int argc, char** argv) {
+    const char* filter = nullptr;
+    int reps = BENCH_DEFAULT_REPS;
+    bool table = false;
+    bool list = false;
+    double maxAllocs = -1;      // Per op, negative = no limit
+    bool stressRamp = false;
+    double cpuScale = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--filter") && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (!strcmp(argv[i], "--reps") && i + 1 < argc) {
+            reps = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--format") && i + 1 < argc) {
+            table = !strcmp(argv[++i], "table");
+        } else if (!strcmp(argv[i], "--max-allocs") && i + 1 < argc) {
+            maxAllocs = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--list")) {
+            list = true;
+        } else if (!strcmp(argv[i], "--stress-ramp")) {
+            stressRamp = true;
+        } else if (!strcmp(argv[i], "--cpu-scale") && i + 1 < argc) {
+            cpuScale = atof(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (stressRamp) return benchStressRamp(cpuScale > 0 ? cpuScale : 1, table);
+
+    BenchRegistry& registry = BenchRegistry::instance();
+    if (table && !list) printTableHeader();
+
+    int ran = 0;
+    int overBudget = 0;
+    for (int i = 0; i < registry.count(); i++) {
+        const BenchCase& c = registry.get(i);
+        if (filter && !strstr(c.name, filter)) continue;
+        ran++;
+
+        if (list) {
+            printf("%s\n", c.name);
+            continue;
+        }
+
+        BenchResult r = BenchRegistry::run(c, reps);
+        if (table) printTableRow(c, r);
+        else printJson(c, r);
+        fflush(stdout);
+
+        if (maxAllocs >= 0 && r.allocsPerOp > maxAllocs) {
+            fprintf(stderr, "bench: %s allocates %.4f per op (limit %g)\n", c.name, r.allocsPerOp, maxAllocs);
+            overBudget++;
+        }
+    }
+
+    if (ran == 0) {
+        fprintf(stderr, "bench: no case matches\n");
+        return 1;
+    }
+    return overBudget ? 1 : 0;
+}
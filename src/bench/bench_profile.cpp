@@ -0,0 +1,50 @@
+/*
+ * Profile Benchmarks - Per-device RSSI learning on the resolve path: one
+ * sample per resolved advert, the per-advert threshold lookup and the
+ * merge + derive at the end of a session
+ */
+
+#include "bench.h"
+#include "bench_fixtures.h"
+#include "rssi_profile.h"
+
+static const ProximityConfig config = {-90, -80, 10000, 3};
+
+static StoredDevice devices[MAX_DEVICES];
+static ProfileLearner<StoredDevice, MAX_DEVICES> learner;
+
+static bool setup() {
+    benchMakeDevices(devices);
+    learner.begin(devices, MAX_DEVICES);
+    return true;
+}
+
+static bool ready = setup();
+
+BENCH_CASE(profile, sample) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        learner.onSample(i % MAX_DEVICES, -60 - (int)(i & 15), true, i);
+    }
+    benchSink += devices[0].profile.sessions;
+}
+
+// Thresholds for a device with a learned boundary
+BENCH_CASE(profile, config_for) {
+    devices[1].profile.boundary = -84;
+    for (uint32_t i = 0; i < iterations; i++) {
+        benchSink += learner.configFor(1, config).lockRssi;
+    }
+}
+
+// One op: a full near histogram plus tail merged into the profile, derived
+BENCH_CASE(profile, session_end) {
+    RssiProfile copy;
+    for (uint32_t i = 0; i < iterations; i++) {
+        uint32_t t = i * (PROFILE_MIN_SESSION_MS + 1000);
+        for (int s = 0; s < 64; s++) {
+            learner.onSample(2, -58 - s % 24, true, t + s * 500);
+        }
+        learner.onSample(2, -95, false, t + 64 * 500);
+        benchSink += learner.takeDirty(&copy);
+    }
+}
@@ -0,0 +1,49 @@
+/*
+ * Proximity Benchmarks - ProximityTracker decisions per advert and per
+ * proximity loop pass, with MAX_DEVICES tracked
+ */
+
+#include "bench.h"
+#include "proximity.h"
+
+static const ProximityConfig config = {-90, -80, 10000, 3};
+
+BENCH_CASE(proximity, advert_strong_nearby) {
+    static ProximityTracker tracker;
+    static bool init = false;
+    if (!init) {
+        tracker.reset(MAX_DEVICES);
+        init = true;
+    }
+    bool changed;
+    for (uint32_t i = 0; i < iterations; i++) {
+        benchSink += tracker.onAdvert(i % MAX_DEVICES, -60, i, config, &changed);
+    }
+}
+
+// Strong, mid and weak adverts in turn; every third weak run crosses the
+// hysteresis threshold, so UNLOCK/WEAK/GONE paths are all exercised
+BENCH_CASE(proximity, advert_mixed) {
+    static ProximityTracker tracker;
+    static const int8_t pattern[] = {-60, -85, -95, -95, -95, -70, -85, -95};
+    tracker.reset(MAX_DEVICES);
+    bool changed;
+    for (uint32_t i = 0; i < iterations; i++) {
+        benchSink += tracker.onAdvert(i % 3, pattern[i & 7], i * 100, config, &changed);
+    }
+}
+
+// One proximity loop pass: weak decay plus timeout check for every device
+BENCH_CASE(proximity, loop_pass) {
+    static ProximityTracker tracker;
+    tracker.reset(MAX_DEVICES);
+    bool changed;
+    for (int d = 0; d < MAX_DEVICES; d++) tracker.onAdvert(d, -60, 0, config, &changed);
+    for (uint32_t i = 0; i < iterations; i++) {
+        tracker.decayWeakCounters(i);
+        for (int d = 0; d < MAX_DEVICES; d++) {
+            benchSink += tracker.expire(d, i, config);
+        }
+        benchSink += tracker.hasWeakSignals();
+    }
+}
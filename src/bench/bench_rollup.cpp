@@ -0,0 +1,58 @@
+/*
+ * Rollup Benchmarks - Usage aggregates: one event through all three tiers,
+ * the once-a-second presence tick and the /api/stats bucket copy
+ */
+
+#include "bench.h"
+#include "rollup.h"
+
+static const uint32_t T0 = 1760054400;  // A Friday, 00:00 UTC
+
+static UsageRollup<MAX_DEVICES> usage;
+
+static bool setup() {
+    // Deleting a device moves the later ones down with their buckets
+    UsageRollup<3> check;
+    check.begin(3);
+    for (int d = 0; d < 3; d++) {
+        for (int k = 0; k <= d; k++) check.onUnlock(d, -60, T0 + k);
+    }
+    check.removeDevice(1);
+    RollupSeries series;
+    if (!check.getSeries(0, ROLLUP_DAY, T0, &series) || series.buckets[ROLLUP_DAYS - 1].unlocks != 1 ||
+        !check.getSeries(1, ROLLUP_DAY, T0, &series) || series.buckets[ROLLUP_DAYS - 1].unlocks != 3 ||
+        check.getSeries(2, ROLLUP_DAY, T0, &series)) {
+        fprintf(stderr, "bench_rollup: self-check failed\n");
+        abort();
+    }
+
+    usage.begin(MAX_DEVICES);
+    return true;
+}
+
+static bool ready = setup();
+
+// Unlocks an hour apart, so the hour ring keeps advancing
+BENCH_CASE(rollup, event) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        usage.onUnlock(i % MAX_DEVICES, -60, T0 + i * 3600);
+    }
+    benchSink += usage.getPending(0).unlocks;
+}
+
+// Every device nearby, credited one second per op
+BENCH_CASE(rollup, tick) {
+    for (int d = 0; d < MAX_DEVICES; d++) usage.onPresence(d, true, 0, T0);
+    for (uint32_t i = 0; i < iterations; i++) {
+        usage.tick((i + 1) * 1000, T0 + i);
+    }
+    for (int d = 0; d < MAX_DEVICES; d++) usage.onPresence(d, false, (iterations + 1) * 1000, T0 + iterations);
+}
+
+BENCH_CASE(rollup, series_week) {
+    RollupSeries series;
+    for (uint32_t i = 0; i < iterations; i++) {
+        usage.getSeries(i % MAX_DEVICES, ROLLUP_WEEK, T0, &series);
+        benchSink += series.buckets[ROLLUP_WEEKS - 1].presenceS;
+    }
+}
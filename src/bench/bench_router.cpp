@@ -0,0 +1,55 @@
+/*
+ * Router Benchmarks - Route lookup plus handler call for a device path,
+ * as every /api/devices/{id}/... request pays it. The self-check covers
+ * path parameters: in range, too long for an int, not a number.
+ */
+
+#include "bench.h"
+#include "api_router.h"
+
+struct BenchApi {
+    long lastId = -1;
+
+    void onDevice(const RouteParams& params) {
+        lastId = params.values[0];
+    }
+};
+
+static BenchApi api;
+static ApiRouter<BenchApi> router;
+static WebServer server;
+
+static bool dispatch(HTTPMethod method, const char* uri) {
+    api.lastId = -1;
+    return router.canHandle(method, uri) && router.handle(server, method, uri);
+}
+
+static bool setup() {
+    router.begin(&api);
+    router.on(HTTP_GET, "/api/devices", &BenchApi::onDevice);
+    router.on(HTTP_POST, "/api/devices/{id}/name", &BenchApi::onDevice);
+    router.on(HTTP_DELETE, "/api/devices/{id}", &BenchApi::onDevice);
+    router.on(HTTP_GET, "/api/devices/{id}/rssi", &BenchApi::onDevice);
+    router.on(HTTP_GET, "/api/log", &BenchApi::onDevice);
+
+    if (!dispatch(HTTP_DELETE, "/api/devices/3") || api.lastId != 3 ||
+        !dispatch(HTTP_GET, "/api/devices/999999999/rssi") || api.lastId != 999999999 ||
+        dispatch(HTTP_DELETE, "/api/devices/2147483648") ||
+        dispatch(HTTP_DELETE, "/api/devices/0000000001") ||
+        dispatch(HTTP_POST, "/api/devices/99999999999999999999999/name") ||
+        dispatch(HTTP_DELETE, "/api/devices/-1") ||
+        dispatch(HTTP_GET, "/api/devices/1x/rssi")) {
+        fprintf(stderr, "bench_router: self-check failed\n");
+        abort();
+    }
+    return true;
+}
+
+static bool ready = setup();
+
+BENCH_CASE(router, dispatch_device) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        dispatch(HTTP_GET, "/api/devices/3/rssi");
+        benchSink += api.lastId;
+    }
+}
@@ -0,0 +1,93 @@
+/*
+ * RPA Benchmarks - resolveRPA() against a full device table
+ * Cost is dominated by one AES-128 block per device tried, so a miss
+ * (the common case: other people's phones) costs MAX_DEVICES blocks.
+ * The capN cases run the fixed-capacity RpaResolver on full 1-, 10- and
+ * 100-device tables (unrolled up to RPA_UNROLL_MAX).
+ */
+
+#include "bench.h"
+#include "bench_fixtures.h"
+
+static StoredDevice devices[MAX_DEVICES];
+static uint8_t rpaFirst[6];
+static uint8_t rpaLast[6];
+static uint8_t rpaUnknown[6];
+static uint8_t publicAddress[6] = {0xC8, 0x2B, 0x96, 0x11, 0x22, 0x33};
+static StoredDevice devices100[100];
+
+static bool setup() {
+    benchMakeDevices(devices);
+    benchMakeRpa(devices[0].irk, 0x12, 0x34, 0x56, rpaFirst);
+    benchMakeRpa(devices[MAX_DEVICES - 1].irk, 0x65, 0x43, 0x21, rpaLast);
+
+    uint8_t foreignIrk[16];
+    benchForeignIrk(foreignIrk);
+    benchMakeRpa(foreignIrk, 0x0F, 0x1E, 0x2D, rpaUnknown);
+    benchMakeDevices(devices100, 100);
+
+    if (resolveRPA(rpaFirst, devices, MAX_DEVICES) != 0 ||
+        resolveRPA(rpaLast, devices, MAX_DEVICES) != MAX_DEVICES - 1 ||
+        resolveRPA(rpaUnknown, devices, MAX_DEVICES) != -1 ||
+        RpaResolver<MAX_DEVICES>::resolve(rpaLast, devices, MAX_DEVICES) != MAX_DEVICES - 1 ||
+        RpaResolver<100>::resolve(rpaLast, devices100, 100) != MAX_DEVICES - 1 ||
+        RpaResolver<1>::resolve(rpaFirst, devices, 1) != 0) {
+        fprintf(stderr, "bench_rpa: self-check failed\n");
+        abort();
+    }
+    return true;
+}
+
+static bool ready = setup();
+
+BENCH_CASE(rpa, resolve_hit_first) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        benchSink += resolveRPA(rpaFirst, devices, MAX_DEVICES);
+    }
+}
+
+BENCH_CASE(rpa, resolve_hit_last) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        benchSink += resolveRPA(rpaLast, devices, MAX_DEVICES);
+    }
+}
+
+BENCH_CASE(rpa, resolve_miss) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        benchSink += resolveRPA(rpaUnknown, devices, MAX_DEVICES);
+    }
+}
+
+BENCH_CASE(rpa, prefilter_public) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        benchSink += resolveRPA(publicAddress, devices, MAX_DEVICES);
+    }
+}
+
+BENCH_CASE(rpa, resolve_miss_cap1) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        benchSink += RpaResolver<1>::resolve(rpaUnknown, devices, 1);
+    }
+}
+
+BENCH_CASE(rpa, resolve_miss_cap10) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        benchSink += RpaResolver<10>::resolve(rpaUnknown, devices100, 10);
+    }
+}
+
+BENCH_CASE(rpa, resolve_miss_cap100) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        benchSink += RpaResolver<100>::resolve(rpaUnknown, devices100, 100);
+    }
+}
+
+BENCH_CASE(rpa, aes_block) {
+    uint8_t input[16] = {0};
+    uint8_t out[16];
+    for (uint32_t i = 0; i < iterations; i++) {
+        input[15] = (uint8_t)i;
+        aes128_ecb_fast(devices[0].irk, input, out);
+        benchSink += out[0];
+    }
+}
@@ -0,0 +1,32 @@
+/*
+ * RSSI Series Benchmarks - The per-advert append on the resolve path (raw
+ * ring plus both tiers) and the tier copy behind /api/devices/{id}/rssi
+ */
+
+#include "bench.h"
+#include "rssi_series.h"
+
+static RssiSeries<MAX_DEVICES> series;
+
+static bool setup() {
+    series.begin(MAX_DEVICES);
+    return true;
+}
+
+static bool ready = setup();
+
+// Adverts 100ms apart, round-robin over the devices
+BENCH_CASE(rssi_series, add) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        series.add(i % MAX_DEVICES, -60 - (int)(i & 31), i * 100);
+    }
+    benchSink += series.latest(0, -99);
+}
+
+BENCH_CASE(rssi_series, read_coarse) {
+    RssiTierView view;
+    for (uint32_t i = 0; i < iterations; i++) {
+        series.readTier(i % MAX_DEVICES, RSSI_TIER_COARSE, 3600000, &view);
+        benchSink += view.buckets[RSSI_COARSE_BUCKETS - 1].count;
+    }
+}
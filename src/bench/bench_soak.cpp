@@ -0,0 +1,196 @@
+/*
+ * Soak Benchmark - One simulated hour of keyless operation per op
+ * Drives the same modules the firmware runs in keyless mode: RPA
+ * resolution for every advert, proximity decisions with the learned
+ * per-device thresholds, profile learning, RSSI history, event stream
+ * producers, the 50ms proximity loop and diag drain, audit log writes and
+ * usage rollups on unlock/lock, profile and rollup saves, and a dashboard
+ * log poll every 5s. Run with --max-allocs 0 to check the steady state
+ * never allocates.
+ *
+ * Per simulated second: 20 public-address adverts, 3 foreign RPAs, a
+ * paired phone parked at the edge of range (weak, never nearby) and one
+ * that cycles every hour through strong (30 min, unlock), weak (5 min,
+ * lock by hysteresis) and absent (25 min).
+ */
+
+#include "bench.h"
+#include "bench_fixtures.h"
+#include "proximity.h"
+#include "audit_log.h"
+#include "rssi_profile.h"
+#include "rssi_series.h"
+#include "rollup.h"
+#include "event_stream.h"
+#include "diag.h"
+
+#define SOAK_SECONDS_PER_OP 3600
+#define SOAK_LOOP_PERIOD_MS 50
+#define SOAK_RPA_ROTATE_S 900           // iOS rotates its RPA about every 15 min
+#define SOAK_UNIX_START 1767225600
+
+static uint8_t phoneRpa[2][6];
+static uint8_t foreignRpa[3][6];
+static uint8_t publicAddress[6] = {0xC8, 0x2B, 0x96, 0x11, 0x22, 0x33};
+static const ProximityConfig config = {-90, -80, 10000, 3};
+
+static Storage storage;
+static AuditLog auditLog;
+static ProximityTracker tracker;
+static ProfileLearner<StoredDevice, MAX_DEVICES> learner;
+static RssiSeries<MAX_DEVICES> series;
+static Rollup usage;
+static EventStream events;
+static uint32_t simSecond = 0;
+static uint32_t logCursor = 0;
+static bool unlocked = false;           // Firmware locks once per unlock (lockTriggered/pendingLock)
+
+static uint32_t unixAt(uint32_t nowMs) {
+    return SOAK_UNIX_START + nowMs / 1000;
+}
+
+// AuditLog::logEvent on the simulated clock
+static void logEvent(int device, uint8_t action, int rssi, uint32_t nowMs) {
+    storage.addLogEntry(device, action, rssi, nowMs, unixAt(nowMs));
+    if (action == ACTION_UNLOCK) usage.onUnlock(device, rssi, unixAt(nowMs));
+    else usage.onLock(device, unixAt(nowMs));
+    DIAG_INFO("LOG: Device %d, Action %s, RSSI %d", device, action == ACTION_UNLOCK ? "UNLOCK" : "LOCK", rssi);
+}
+
+static void presenceChanged(int device, bool nearby, uint32_t nowMs) {
+    DIAG_INFO("📍 %s %s", storage.devices[device].name, nearby ? "nearby" : "left");
+    events.publishPresence(device, nearby);
+    usage.onPresence(device, nearby, nowMs, unixAt(nowMs));
+}
+
+static void allGone(int device, uint32_t nowMs) {
+    for (int d = 0; d < MAX_DEVICES; d++) {
+        if (!tracker.isNearby(d)) continue;
+        presenceChanged(d, false, nowMs);
+        learner.onDeparture(d);
+    }
+    tracker.clearAll();
+    if (!unlocked) return;
+    unlocked = false;
+    logEvent(device, ACTION_LOCK, series.latest(device, -99), nowMs);
+    events.publishLock(device);
+}
+
+static bool setup() {
+    StoredDevice made[MAX_DEVICES];
+    benchMakeDevices(made);
+    storage.begin();
+    for (int d = 0; d < MAX_DEVICES; d++) storage.addDevice(made[d].irk, made[d].name);
+    auditLog.begin(&storage);
+    auditLog.setNtpSync(SOAK_UNIX_START);
+    tracker.reset(MAX_DEVICES);
+    learner.begin(storage.devices, MAX_DEVICES);
+    series.begin(MAX_DEVICES);
+    usage.begin(MAX_DEVICES);
+    return true;
+}
+
+static bool ready = setup();
+
+static void rotateAddresses(uint32_t epoch) {
+    uint8_t foreignIrk[16];
+    benchForeignIrk(foreignIrk);
+    for (int p = 0; p < 2; p++) {
+        benchMakeRpa(storage.devices[p].irk, (uint8_t)epoch, (uint8_t)(epoch >> 8), (uint8_t)p, phoneRpa[p]);
+    }
+    for (int f = 0; f < 3; f++) {
+        foreignIrk[0] = (uint8_t)f;
+        benchMakeRpa(foreignIrk, (uint8_t)epoch, (uint8_t)f, 0x5A, foreignRpa[f]);
+    }
+}
+
+// Resolve task path: resolve, decide, learn, record; log on unlock/lock
+static void advert(const uint8_t* address, int rssi, uint32_t nowMs) {
+    int device = resolveRPA(address, storage.devices, MAX_DEVICES);
+    if (device < 0) return;
+
+    events.publishRssi(device, rssi);
+    bool changed;
+    ProximityDecision decision = tracker.onAdvert(device, rssi, nowMs, learner.configFor(device, config), &changed);
+    if (changed) presenceChanged(device, tracker.isNearby(device), nowMs);
+    learner.onSample(device, rssi, tracker.isNearby(device), nowMs);
+    series.add(device, rssi, nowMs);
+
+    if (decision == PROX_UNLOCK) {
+        unlocked = true;
+        logEvent(device, ACTION_UNLOCK, rssi, nowMs);
+        events.publishUnlock(device, rssi);
+    } else if (decision == PROX_GONE) {
+        allGone(device, nowMs);
+    }
+}
+
+// Dashboard: GET /api/log?since=<cursor>
+static void pollLog() {
+    LogEntry chunk[10];
+    char json[144];
+    int n;
+    while ((n = storage.readLogSince(logCursor, chunk, 10)) > 0) {
+        for (int i = 0; i < n; i++) {
+            auditLog.getLogEntryJson(&chunk[i], json, sizeof(json), storage.devices[chunk[i].deviceIndex].name);
+            benchSink += json[2];
+        }
+        logCursor = chunk[n - 1].seq;
+    }
+}
+
+// Loop task, once a second: learned profiles and usage to NVS
+static void saveState(uint32_t s, uint32_t nowMs) {
+    RssiProfile profile;
+    int profiled;
+    while ((profiled = learner.takeDirty(&profile)) >= 0) storage.saveProfile(profiled, profile);
+
+    usage.tick(nowMs, unixAt(nowMs));
+    if (s % 3600 == 0) {
+        DeviceRollup blob;
+        int rolled;
+        while ((rolled = usage.takeDirty(&blob)) >= 0) storage.saveRollup(rolled, blob);
+    }
+}
+
+static void simulateSecond(uint32_t s) {
+    if (s % SOAK_RPA_ROTATE_S == 0) rotateAddresses(s / SOAK_RPA_ROTATE_S);
+
+    uint32_t minute = (s / 60) % 60;
+    int phoneRssi = minute < 20 ? -60 : minute < 30 ? -75 : minute < 35 ? -95 : 0;
+
+    for (int tick = 0; tick < 1000 / SOAK_LOOP_PERIOD_MS; tick++) {
+        uint32_t nowMs = s * 1000 + tick * SOAK_LOOP_PERIOD_MS;
+
+        // Adverts spread over the second
+        if (tick < 20) benchSink += resolveRPA(publicAddress, storage.devices, MAX_DEVICES);
+        if (tick < 3) advert(foreignRpa[tick], -75, nowMs);
+        if (tick == 5) advert(phoneRpa[1], -97, nowMs);
+        if (phoneRssi != 0 && (tick == 0 || tick == 10)) advert(phoneRpa[0], phoneRssi, nowMs);
+
+        // Proximity loop pass
+        tracker.decayWeakCounters(nowMs);
+        for (int d = 0; d < MAX_DEVICES; d++) {
+            if (!tracker.expire(d, nowMs, config)) continue;
+            presenceChanged(d, false, nowMs);
+            learner.onDeparture(d);
+            if (!tracker.isAnyNearby()) allGone(d, nowMs);
+        }
+
+        // Diag and network tasks
+        diag.drain();
+        events.update();
+    }
+
+    saveState(s, s * 1000);
+    if (s % 5 == 0) pollLog();
+}
+
+BENCH_CASE(soak, keyless_hour) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        for (uint32_t s = 0; s < SOAK_SECONDS_PER_OP; s++) {
+            simulateSecond(simSecond++);
+        }
+    }
+    benchSink += storage.getNextSeq();
+}
@@ -0,0 +1,105 @@
+/*
+ * Storage Benchmarks - Audit log ring append, cursor reads and indexed
+ * queries. NVS is the in-memory Preferences shim, so add_log_entry
+ * measures the ring and index update and the page copy, not the flash
+ * write (see the device's keyless_nvs_write_seconds histogram for that).
+ */
+
+#include "bench.h"
+#include "storage.h"
+
+#define BENCH_LOG_EPOCH 1700000000    // Unix time of the first entry
+#define BENCH_LOG_SPACING 600           // Seconds between entries
+
+static Storage* setupStorage() {
+    static Storage storage;
+    storage.begin();
+    storage.loadLog();
+    for (int i = 0; i < MAX_LOG_ENTRIES * 2; i++) {
+        storage.addLogEntry(i % MAX_DEVICES, i & 1, -60 - (i % 30), i * 1000,
+            BENCH_LOG_EPOCH + i * BENCH_LOG_SPACING);
+    }
+    return &storage;
+}
+
+// Paging the unlocks two at a time returns the same entries as a
+// full read, and a page never walks the chain above its cursor
+static bool checkPaging(Storage* storage) {
+    LogEntry all[MAX_LOG_ENTRIES], page[2];
+    int expected = storage->readLogSince(0, all, MAX_LOG_ENTRIES);
+    LogQuery q = {LOG_ANY, 1, 0, 0, UINT32_MAX};
+    LogQueryStats stats;
+    bool ok = true;
+    do {
+        int n = storage->queryLog(q, page, 2, &stats);
+        if (stats.examined > 8) ok = false;
+        for (int i = 0; i < n && ok; i++) {
+            while (expected > 0 && all[expected - 1].action != 1) expected--;
+            if (expected == 0 || all[--expected].seq != page[i].seq) ok = false;
+        }
+        q.before = stats.next;
+    } while (ok && stats.next != 0);
+    while (expected > 0 && all[expected - 1].action != 1) expected--;
+    if (!ok || expected != 0) {
+        fprintf(stderr, "bench_storage: paging self-check failed\n");
+        abort();
+    }
+    return true;
+}
+
+static Storage* storage = setupStorage();
+static bool pagingChecked = checkPaging(storage);
+
+BENCH_CASE(storage, add_log_entry) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        storage->addLogEntry(i % MAX_DEVICES, i & 1, -70, i);
+    }
+    benchSink += storage->getNextSeq();
+}
+
+BENCH_CASE(storage, read_log_all) {
+    LogEntry out[MAX_LOG_ENTRIES];
+    for (uint32_t i = 0; i < iterations; i++) {
+        benchSink += storage->readLogSince(0, out, MAX_LOG_ENTRIES);
+    }
+}
+
+// Typical dashboard poll: a few entries newer than the client's cursor
+BENCH_CASE(storage, read_log_tail) {
+    LogEntry out[MAX_LOG_ENTRIES];
+    uint32_t since = storage->getNextSeq() - 4;
+    for (uint32_t i = 0; i < iterations; i++) {
+        benchSink += storage->readLogSince(since, out, MAX_LOG_ENTRIES);
+    }
+}
+
+// One device's unlocks: walks that device's chain, not the ring
+BENCH_CASE(storage, query_device_action) {
+    LogEntry out[MAX_LOG_ENTRIES];
+    LogQuery q = {3, 1, 0, 0, UINT32_MAX};
+    LogQueryStats stats;
+    for (uint32_t i = 0; i < iterations; i++) {
+        benchSink += storage->queryLog(q, out, MAX_LOG_ENTRIES, &stats);
+    }
+}
+
+// Two hours in the middle of the retained history: bucket lookup + window
+BENCH_CASE(storage, query_time_range) {
+    static Storage ranged;
+    static bool init = false;
+    if (!init) {
+        ranged.begin();
+        ranged.loadLog();
+        for (int i = 0; i < MAX_LOG_ENTRIES; i++) {
+            ranged.addLogEntry(i % MAX_DEVICES, i & 1, -70, i * 1000, BENCH_LOG_EPOCH + i * BENCH_LOG_SPACING);
+        }
+        init = true;
+    }
+    LogEntry out[MAX_LOG_ENTRIES];
+    uint32_t from = BENCH_LOG_EPOCH + MAX_LOG_ENTRIES / 2 * BENCH_LOG_SPACING;
+    LogQuery q = {LOG_ANY, LOG_ANY, from, from + 7200, UINT32_MAX};
+    LogQueryStats stats;
+    for (uint32_t i = 0; i < iterations; i++) {
+        benchSink += ranged.queryLog(q, out, MAX_LOG_ENTRIES, &stats);
+    }
+}
@@ -0,0 +1,217 @@
+/*
+ * Stress Benchmarks - Scan ingestion under crowded-RF load
+ * The ingestion path: RPA pre-filter and resolution against a full device
+ * table, then the proximity decision (a "gone" clears presence as
+ * clearAllPresence() does).
+ *
+ * stress/ingest_mixed times one advert of the default mix per op;
+ * stress/pipeline_handoff one stage 1 push + stage 2 pop (pipeline.h).
+ * --stress-ramp offers the mix at doubling rates on a virtual clock that
+ * advances by the measured (and --cpu-scale'd) cost of every advert, and
+ * reports sustained adverts/s, drop rate and unlock latency per rate until
+ * more than half of the adverts are dropped, for both designs:
+ *   single    everything in the scan callback on one core
+ *   pipeline  callback pre-filters and queues (core 0), the resolve stage
+ *             drains the ingest queue on its own clock (core 1)
+ * Drops count at the BLE stack's queue and, for the pipeline, the ingest
+ * queue. Actuation (stage 3) is not part of either.
+ */
+
+#include "bench.h"
+#include "bench_fixtures.h"
+#include "pipeline.h"
+#include "proximity.h"
+#include "stress_gen.h"
+
+#define STRESS_RAMP_START 1000          // Background adverts/s, doubled per level
+#define STRESS_RAMP_MAX 4096000
+#define STRESS_RAMP_LEVEL_US 3000000    // Virtual time per level
+#define STRESS_RAMP_STOP_DROP 0.5
+
+static const StressMix defaultMix = {0, 30, 20, STRESS_PHONES};
+static const ProximityConfig config = {-90, -80, 10000, 3};
+
+static StoredDevice devices[MAX_DEVICES];
+static ProximityTracker tracker;
+static StressGenerator generator;
+
+// Pipeline item plus the virtual time stage 1 queued it
+struct TimedItem {
+    IngestItem item;
+    uint64_t queuedUs;
+    int8_t phone;
+};
+static SpscQueue<TimedItem, PIPELINE_INGEST_DEPTH> stageQueue;
+
+static bool setup() {
+    benchMakeDevices(devices);
+    tracker.reset(MAX_DEVICES);
+    StressMix mix = defaultMix;
+    mix.rate = 1000;
+    generator.begin(mix, devices, 1);
+    return true;
+}
+
+static bool ready = setup();
+
+// Stage 2 (or the tail of the single path)
+static ProximityDecision resolveAndDecide(const uint8_t* address, int rssi, uint64_t timeUs) {
+    int device = RpaResolver<MAX_DEVICES>::resolve(address, devices, MAX_DEVICES);
+    if (device < 0) return PROX_NONE;
+
+    bool changed;
+    ProximityDecision decision = tracker.onAdvert(device, rssi, (unsigned long)(timeUs / 1000), config, &changed);
+    if (decision == PROX_GONE) tracker.clearAll();
+    return decision;
+}
+
+static ProximityDecision ingest(const StressAdvert& a) {
+    if (!isResolvableAddress(a.address)) return PROX_NONE;
+    return resolveAndDecide(a.address, a.rssi, a.timeUs);
+}
+
+// Stage 1: pre-filter and queue; false when the ingest queue is full
+static bool stage1(const StressAdvert& a, uint64_t nowUs) {
+    if (!isResolvableAddress(a.address)) return true;
+    TimedItem t;
+    memcpy(t.item.address, a.address, 6);
+    t.item.rssi = a.rssi;
+    t.item.flags = 0;
+    t.item.advertUs = (uint32_t)a.timeUs;
+    t.queuedUs = nowUs;
+    t.phone = a.phone;
+    return stageQueue.push(t);
+}
+
+BENCH_CASE(stress, ingest_mixed) {
+    StressAdvert a;
+    for (uint32_t i = 0; i < iterations; i++) {
+        generator.next(&a);
+        benchSink += ingest(a);
+    }
+}
+
+BENCH_CASE(stress, pipeline_handoff) {
+    static IngestQueue queue;
+    IngestItem in = {{0x4A, 1, 2, 3, 4, 5}, -60, 0, 0};
+    IngestItem out = {};
+    for (uint32_t i = 0; i < iterations; i++) {
+        in.advertUs = i;
+        queue.push(in);
+        queue.pop(&out);
+        benchSink += out.advertUs;
+    }
+}
+
+// ========== Ramp ==========
+
+static uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint64_t scaledUs(uint64_t startNs, double cpuScale) {
+    return (uint64_t)((nowNs() - startNs) * cpuScale / 1000) + 1;
+}
+
+// Single path: the callback does everything. Returns the level's length.
+static uint64_t runSingle(StressRunner& runner, double cpuScale) {
+    uint64_t elapsedUs = 0;
+    StressAdvert a;
+    while (elapsedUs < STRESS_RAMP_LEVEL_US) {
+        runner.admit(elapsedUs);
+        if (!runner.pop(&a)) {
+            elapsedUs = runner.nextArrivalUs();
+            continue;
+        }
+        uint64_t start = nowNs();
+        ProximityDecision decision = ingest(a);
+        elapsedUs += scaledUs(start, cpuScale);
+        if (decision == PROX_UNLOCK && a.phone >= 0) runner.onUnlock(a.timeUs, elapsedUs);
+    }
+    return elapsedUs;
+}
+
+// Pipeline: two clocks, always advancing the one that is behind so the
+// ingest queue's occupancy is right when stage 1 pushes. Returns the
+// level's length (stage 1 clock) and the ingest queue drops.
+static uint64_t runPipeline(StressRunner& runner, double cpuScale, uint32_t* queueDrops) {
+    uint64_t core0Us = 0;       // Stage 1
+    uint64_t core1Us = 0;       // Stage 2
+    uint32_t dropped = stageQueue.getDropped();
+    stageQueue.clear();
+
+    StressAdvert a;
+    TimedItem t;
+    while (core0Us < STRESS_RAMP_LEVEL_US) {
+        if (core1Us < core0Us) {
+            if (!stageQueue.pop(&t)) {
+                core1Us = core0Us;      // Idle until stage 1 queues more
+                continue;
+            }
+            if (t.queuedUs > core1Us) core1Us = t.queuedUs;
+            uint64_t start = nowNs();
+            ProximityDecision decision = resolveAndDecide(t.item.address, t.item.rssi, t.item.advertUs);
+            core1Us += scaledUs(start, cpuScale);
+            if (decision == PROX_UNLOCK && t.phone >= 0) runner.onUnlock(t.item.advertUs, core1Us);
+            continue;
+        }
+        runner.admit(core0Us);
+        if (!runner.pop(&a)) {
+            core0Us = runner.nextArrivalUs();
+            continue;
+        }
+        uint64_t start = nowNs();
+        stage1(a, core0Us);
+        core0Us += scaledUs(start, cpuScale);
+    }
+    *queueDrops = stageQueue.getDropped() - dropped;
+    return core0Us;
+}
+
+// `processed` counts adverts that got past every queue
+static void runLevel(bool pipeline, uint32_t rate, double cpuScale, StressResult* out) {
+    static StressRunner runner;
+    StressMix mix = defaultMix;
+    mix.rate = rate;
+    runner.begin(mix, devices, rate);
+    tracker.reset(MAX_DEVICES);
+
+    uint32_t queueDrops = 0;
+    uint64_t elapsedUs = pipeline ? runPipeline(runner, cpuScale, &queueDrops) : runSingle(runner, cpuScale);
+    runner.finish(elapsedUs, out);
+    out->dropped += queueDrops;
+    out->processed -= queueDrops;
+}
+
+int benchStressRamp(double cpuScale, bool table) {
+    if (table) {
+        printf("%-9s %12s %12s %8s %8s %10s %10s %10s\n", "design", "offered/s", "sustained/s", "drop%",
+            "unlocks", "p50_us", "p99_us", "max_us");
+    }
+    for (int pipeline = 0; pipeline < 2; pipeline++) {
+        const char* design = pipeline ? "pipeline" : "single";
+        for (uint32_t rate = STRESS_RAMP_START; rate <= STRESS_RAMP_MAX; rate *= 2) {
+            StressResult r;
+            runLevel(pipeline, rate, cpuScale, &r);
+            double seconds = r.durationUs / 1e6;
+            double drop = r.offered ? (double)r.dropped / r.offered : 0;
+
+            if (table) {
+                printf("%-9s %12.0f %12.0f %8.2f %8lu %10lu %10lu %10lu\n", design, r.offered / seconds,
+                    r.processed / seconds, drop * 100, (unsigned long)r.unlocks, (unsigned long)r.latencyP50Us,
+                    (unsigned long)r.latencyP99Us, (unsigned long)r.latencyMaxUs);
+            } else {
+                printf("{\"stress\":\"ramp\",\"design\":\"%s\",\"rate\":%lu,\"cpu_scale\":%.2f,"
+                       "\"offered_per_s\":%.0f,\"sustained_per_s\":%.0f,\"drop_rate\":%.4f,\"unlocks\":%lu,"
+                       "\"unlock_p50_us\":%lu,\"unlock_p99_us\":%lu,\"unlock_max_us\":%lu}\n",
+                    design, (unsigned long)rate, cpuScale, r.offered / seconds, r.processed / seconds, drop,
+                    (unsigned long)r.unlocks, (unsigned long)r.latencyP50Us, (unsigned long)r.latencyP99Us,
+                    (unsigned long)r.latencyMaxUs);
+            }
+            fflush(stdout);
+            if (drop > STRESS_RAMP_STOP_DROP) break;
+        }
+    }
+    return 0;
+}
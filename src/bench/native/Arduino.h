@@ -0,0 +1,148 @@
+/*
+ * Native Arduino Shim - Just enough of the Arduino-ESP32 API to compile
+ * the portable modules (rpa.h, proximity.h, storage.h, audit_log.h) on a
+ * desktop host for the benchmark build (pio run -e native).
+ * Not a simulator: Serial output is discarded, heap figures are zero,
+ * FreeRTOS critical sections are plain spinlocks.
+ */
+
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using std::min;
+using std::max;
+
+#define HEX 16
+#define DEC 10
+
+// ========== Time ==========
+
+inline uint64_t nativeMicros64() {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+inline unsigned long millis() {
+    return (unsigned long)(uint32_t)(nativeMicros64() / 1000);
+}
+
+inline unsigned long micros() {
+    return (unsigned long)(uint32_t)nativeMicros64();
+}
+
+inline void delay(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// ========== String ==========
+
+// Fixed-capacity stand-in (no heap): enough for request URIs
+class String {
+private:
+    char text[128];
+
+public:
+    String(const char* s = "") {
+        strncpy(text, s, sizeof(text) - 1);
+        text[sizeof(text) - 1] = '\0';
+    }
+
+    const char* c_str() const { return text; }
+    unsigned int length() const { return strlen(text); }
+};
+
+// ========== Serial (discarded) ==========
+
+class NativeSerial {
+public:
+    void begin(unsigned long) {}
+    int printf(const char*, ...) { return 0; }
+    template <typename T> size_t print(const T&, int = DEC) { return 0; }
+    template <typename T> size_t println(const T&, int = DEC) { return 0; }
+    size_t println() { return 0; }
+    size_t write(const uint8_t*, size_t len) { return len; }
+    int availableForWrite() { return 4096; }    // Never full
+    int available() { return 0; }
+    int read() { return -1; }
+};
+
+inline NativeSerial Serial;
+
+// ========== ESP ==========
+
+class NativeEsp {
+public:
+    uint32_t getFreeHeap() { return 0; }
+    uint32_t getMinFreeHeap() { return 0; }
+    uint32_t getMaxAllocHeap() { return 0; }
+    uint32_t getCpuFreqMHz() { return 1000; }
+
+    // 1 "cycle" per ns, only used for trace timestamps
+    uint32_t getCycleCount() {
+        return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void restart() { exit(0); }
+};
+
+inline NativeEsp ESP;
+
+inline uint32_t getCpuFrequencyMhz() {
+    return 1000;
+}
+
+// ========== FreeRTOS ==========
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef void* TaskHandle_t;
+
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define portMAX_DELAY 0xFFFFFFFF
+
+inline TickType_t xTaskGetTickCount() {
+    return (TickType_t)millis();
+}
+
+inline BaseType_t xPortGetCoreID() {
+    return 0;
+}
+
+inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) {
+    return 0;
+}
+
+inline void vTaskDelay(TickType_t ticks) {
+    delay(ticks);
+}
+
+struct portMUX_TYPE {
+    int owner;
+};
+
+#define portMUX_INITIALIZER_UNLOCKED {0}
+
+inline void portENTER_CRITICAL(portMUX_TYPE* mux) {
+    while (__atomic_exchange_n(&mux->owner, 1, __ATOMIC_ACQUIRE)) {
+    }
+}
+
+inline void portEXIT_CRITICAL(portMUX_TYPE* mux) {
+    __atomic_store_n(&mux->owner, 0, __ATOMIC_RELEASE);
+}
+
+#endif // NATIVE_ARDUINO_H
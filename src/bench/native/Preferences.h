@@ -0,0 +1,73 @@
+/*
+ * Native Preferences Shim - In-memory NVS stand-in
+ * Values live in a map for the life of the process. Writes cost a map
+ * lookup and a copy, not a flash erase/write: benchmarks that go through
+ * it measure the caller's work, not NVS.
+ */
+
+#ifndef NATIVE_PREFERENCES_H
+#define NATIVE_PREFERENCES_H
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include <vector>
+
+class Preferences {
+private:
+    std::map<std::string, std::vector<uint8_t>> values;
+
+    size_t put(const char* key, const void* value, size_t len) {
+        std::vector<uint8_t>& v = values[key];
+        v.assign((const uint8_t*)value, (const uint8_t*)value + len);
+        return len;
+    }
+
+    template <typename T>
+    T get(const char* key, T defaultValue) {
+        auto it = values.find(key);
+        if (it == values.end() || it->second.size() != sizeof(T)) return defaultValue;
+        T value;
+        memcpy(&value, it->second.data(), sizeof(T));
+        return value;
+    }
+
+public:
+    bool begin(const char*, bool = false) { return true; }
+    void end() {}
+    bool clear() { values.clear(); return true; }
+    bool remove(const char* key) { return values.erase(key) > 0; }
+    bool isKey(const char* key) { return values.count(key) > 0; }
+
+    int8_t getChar(const char* key, int8_t d = 0) { return get(key, d); }
+    uint8_t getUChar(const char* key, uint8_t d = 0) { return get(key, d); }
+    int32_t getInt(const char* key, int32_t d = 0) { return get(key, d); }
+    uint32_t getUInt(const char* key, uint32_t d = 0) { return get(key, d); }
+    bool getBool(const char* key, bool d = false) { return get(key, (uint8_t)d) != 0; }
+
+    size_t putChar(const char* key, int8_t v) { return put(key, &v, sizeof(v)); }
+    size_t putUChar(const char* key, uint8_t v) { return put(key, &v, sizeof(v)); }
+    size_t putInt(const char* key, int32_t v) { return put(key, &v, sizeof(v)); }
+    size_t putUInt(const char* key, uint32_t v) { return put(key, &v, sizeof(v)); }
+    size_t putBool(const char* key, bool v) { uint8_t b = v; return put(key, &b, 1); }
+
+    size_t putBytes(const char* key, const void* value, size_t len) { return put(key, value, len); }
+
+    size_t getBytes(const char* key, void* buf, size_t maxLen) {
+        auto it = values.find(key);
+        if (it == values.end() || it->second.size() > maxLen) return 0;
+        memcpy(buf, it->second.data(), it->second.size());
+        return it->second.size();
+    }
+
+    size_t putString(const char* key, const char* value) { return put(key, value, strlen(value) + 1); }
+
+    size_t getString(const char* key, char* buf, size_t maxLen) {
+        auto it = values.find(key);
+        if (it == values.end() || it->second.size() > maxLen) return 0;
+        memcpy(buf, it->second.data(), it->second.size());
+        return it->second.size();
+    }
+};
+
+#endif // NATIVE_PREFERENCES_H
@@ -0,0 +1,32 @@
+/*
+ * Native WebServer Shim - The request-handler interface api_router.h
+ * plugs into. No sockets: the router benchmarks call canHandle() and
+ * handle() directly.
+ */
+
+#ifndef NATIVE_WEBSERVER_H
+#define NATIVE_WEBSERVER_H
+
+#include <Arduino.h>
+
+enum HTTPMethod {
+    HTTP_ANY,
+    HTTP_GET,
+    HTTP_HEAD,
+    HTTP_POST,
+    HTTP_PUT,
+    HTTP_PATCH,
+    HTTP_DELETE,
+    HTTP_OPTIONS
+};
+
+class WebServer {};
+
+class RequestHandler {
+public:
+    virtual ~RequestHandler() {}
+    virtual bool canHandle(HTTPMethod, String) { return false; }
+    virtual bool handle(WebServer&, HTTPMethod, String) { return false; }
+};
+
+#endif // NATIVE_WEBSERVER_H
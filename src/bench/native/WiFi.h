@@ -0,0 +1,21 @@
+/*
+ * Native WiFi Shim - Disconnected WiFiClient for event_stream.h
+ * No client ever attaches to the event stream in the benchmarks; the
+ * producers still fill its queue as on the device.
+ */
+
+#ifndef NATIVE_WIFI_H
+#define NATIVE_WIFI_H
+
+#include <Arduino.h>
+
+class WiFiClient {
+public:
+    int fd() { return -1; }
+    bool connected() { return false; }
+    void stop() {}
+    void setNoDelay(bool) {}
+    size_t print(const char*) { return 0; }
+};
+
+#endif // NATIVE_WIFI_H
@@ -0,0 +1,14 @@
+/*
+ * Native esp_timer Shim - Monotonic microseconds since start
+ */
+
+#ifndef NATIVE_ESP_TIMER_H
+#define NATIVE_ESP_TIMER_H
+
+#include <Arduino.h>
+
+inline int64_t esp_timer_get_time() {
+    return (int64_t)nativeMicros64();
+}
+
+#endif // NATIVE_ESP_TIMER_H
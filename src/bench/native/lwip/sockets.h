@@ -0,0 +1,11 @@
+/*
+ * Native lwIP Shim - Host BSD sockets
+ */
+
+#ifndef NATIVE_LWIP_SOCKETS_H
+#define NATIVE_LWIP_SOCKETS_H
+
+#include <errno.h>
+#include <sys/socket.h>
+
+#endif // NATIVE_LWIP_SOCKETS_H
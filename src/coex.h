@@ -0,0 +1,175 @@
+/*
+ * Coexistence Scheduler - BLE/WiFi radio sharing policy
+ * The ESP32 has one 2.4 GHz radio; with WiFi associated the BLE scanner
+ * only gets the slots WiFi leaves over. The policy follows proximity state:
+ *
+ *   BLE priority  phone sighted but not yet nearby, or nearby with weak
+ *                 signals / pending lock: prefer BT, max modem sleep,
+ *                 90% scan duty, non-urgent network work deferred
+ *   Balanced      phone nearby and stable (default, 50% scan duty)
+ *   WiFi burst    nobody sighted for COEX_IDLE_AFTER_MS: prefer WiFi,
+ *                 30% scan duty (a sighting switches back immediately)
+ *
+ * Modem sleep is never disabled: ESP-IDF requires it while BT is enabled.
+ */
+
+#ifndef COEX_H
+#define COEX_H
+
+#include <Arduino.h>
+#include <esp_coexist.h>
+#include <esp_wifi.h>
+#include "metrics.h"
+#include "diag.h"
+
+#define COEX_IDLE_AFTER_MS 120000    // No known phone sighted -> WiFi burst
+#define COEX_APPROACH_MS 15000       // Sighting this recent counts as approaching
+#define COEX_MIN_DWELL_MS 2000       // Min time before relaxing a policy
+#define COEX_DEFERRED_NET_PERIOD_MS 25  // Network task period while deferring
+
+enum CoexPolicy {
+    COEX_BALANCED,
+    COEX_BLE_PRIORITY,
+    COEX_WIFI_BURST,
+    COEX_POLICY_COUNT
+};
+
+// Per-policy radio and scan parameters (scan units are 0.625 ms)
+struct CoexProfile {
+    const char* name;
+    esp_coex_prefer_t prefer;
+    wifi_ps_type_t powerSave;
+    uint16_t scanInterval;
+    uint16_t scanWindow;
+};
+
+static const CoexProfile COEX_PROFILES[COEX_POLICY_COUNT] = {
+    {"balanced", ESP_COEX_PREFER_BALANCE, WIFI_PS_MIN_MODEM, 1600, 800},
+    {"ble",      ESP_COEX_PREFER_BT,      WIFI_PS_MAX_MODEM, 1600, 1440},
+    {"wifi",     ESP_COEX_PREFER_WIFI,    WIFI_PS_MIN_MODEM, 1600, 480},
+};
+
+class CoexScheduler {
+private:
+    volatile CoexPolicy policy = COEX_BALANCED;
+    bool applied = false;
+    uint32_t policySince = 0;
+    uint32_t lastUpdate = 0;
+    volatile uint32_t lastSighting = 0;     // millis() of last known-device advert
+    uint32_t switches = 0;
+
+    // Accounting per policy
+    SecondsCounter policyTime[COEX_POLICY_COUNT];
+    SecondsCounter scanTime[COEX_POLICY_COUNT];     // Scan wall time x window/interval
+    Counter adverts[COEX_POLICY_COUNT];
+
+    void apply(CoexPolicy next) {
+        const CoexProfile& p = COEX_PROFILES[next];
+        esp_coex_preference_set(p.prefer);
+        esp_wifi_set_ps(p.powerSave);  // Fails harmlessly while WiFi is off
+
+        DIAG_INFO("Coex policy: %s -> %s", COEX_PROFILES[policy].name, p.name);
+        policy = next;
+        policySince = millis();
+        applied = true;
+        switches++;
+    }
+
+public:
+    // Called from the loop task (proximity decisions). `uncertain`: a phone
+    // is nearby but weak-signal hysteresis is counting or a lock is pending.
+    // Approaching (sighted recently, not nearby yet) is derived here.
+    void update(bool anyNearby, bool uncertain) {
+        uint32_t now = millis();
+        if (lastUpdate) policyTime[policy].addMs(now - lastUpdate);
+        lastUpdate = now;
+
+        uint32_t sinceSighting = now - lastSighting;
+        bool sighted = lastSighting != 0;
+        bool approaching = !anyNearby && sighted && sinceSighting < COEX_APPROACH_MS;
+
+        CoexPolicy next;
+        if (approaching || uncertain) {
+            next = COEX_BLE_PRIORITY;
+        } else if (!anyNearby && (!sighted || sinceSighting > COEX_IDLE_AFTER_MS)) {
+            next = COEX_WIFI_BURST;
+        } else {
+            next = COEX_BALANCED;
+        }
+
+        if (applied && next == policy) return;
+
+        // Escalating to BLE priority is immediate; relaxing waits out the dwell
+        if (applied && next != COEX_BLE_PRIORITY && now - policySince < COEX_MIN_DWELL_MS) return;
+        apply(next);
+    }
+
+    // Scan callback: every advert received
+    void onAdvert() {
+        adverts[policy].inc();
+    }
+
+    // Scan callback: advert resolved to a paired device
+    void onSighting() {
+        lastSighting = millis();
+    }
+
+    // Scan task: one completed scan of `durationUs` under `scanPolicy`
+    void onScanCycle(CoexPolicy scanPolicy, uint32_t durationUs) {
+        const CoexProfile& p = COEX_PROFILES[scanPolicy];
+        scanTime[scanPolicy].addMs((uint32_t)((uint64_t)durationUs / 1000 * p.scanWindow / p.scanInterval));
+    }
+
+    CoexPolicy getPolicy() {
+        return policy;
+    }
+
+    const CoexProfile& getProfile() {
+        return COEX_PROFILES[policy];
+    }
+
+    // Network task holds off full WiFi scans, NTP start and fast polling
+    bool deferNonUrgent() {
+        return policy == COEX_BLE_PRIORITY;
+    }
+
+    // Adverts per second over all time spent in `p` (x100 for two decimals)
+    uint32_t getAdvertRateX100(CoexPolicy p) {
+        uint64_t ms = policyTime[p].getMs();
+        return ms ? (uint32_t)((uint64_t)adverts[p].get() * 100000 / ms) : 0;
+    }
+
+    uint32_t getSwitchCount() {
+        return switches;
+    }
+
+    template <typename Sink>
+    void render(Sink& out) {
+        Metrics::writeHelp(out, "keyless_coex_policy_seconds_total", "counter", "Time spent in each coexistence policy");
+        for (int i = 0; i < COEX_POLICY_COUNT; i++) {
+            writePolicyValue(out, "keyless_coex_policy_seconds_total", i, policyTime[i].getSeconds());
+        }
+        Metrics::writeHelp(out, "keyless_coex_scan_seconds_total", "counter", "Effective BLE scan time (wall time x window/interval)");
+        for (int i = 0; i < COEX_POLICY_COUNT; i++) {
+            writePolicyValue(out, "keyless_coex_scan_seconds_total", i, scanTime[i].getSeconds());
+        }
+        Metrics::writeHelp(out, "keyless_coex_adverts_total", "counter", "BLE advertisements received under each policy");
+        for (int i = 0; i < COEX_POLICY_COUNT; i++) {
+            writePolicyValue(out, "keyless_coex_adverts_total", i, adverts[i].get());
+        }
+        Metrics::writeGauge(out, "keyless_coex_policy", "Current policy (0=balanced, 1=ble, 2=wifi)", policy);
+        Metrics::writeGauge(out, "keyless_coex_switches", "Policy changes since boot", switches);
+    }
+
+private:
+    template <typename Sink>
+    static void writePolicyValue(Sink& out, const char* name, int p, uint32_t value) {
+        char labels[24];
+        snprintf(labels, sizeof(labels), "{policy=\"%s\"}", COEX_PROFILES[p].name);
+        Metrics::writeValue(out, name, labels, value);
+    }
+};
+
+extern CoexScheduler coex;
+
+#endif // COEX_H
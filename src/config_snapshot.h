@@ -0,0 +1,68 @@
+/*
+ * Config Snapshot - Immutable settings published by atomic index swap
+ * Readers (resolve task per advert, web handlers) copy the current
+ * snapshot without a lock and never see a half-applied update; the writer
+ * fills a slot no reader can reach and then publishes it (RCU style):
+ *
+ *   reader  i = current; refs[i]++; current still i? copy slots[i]; refs[i]--
+ *   writer  pick a slot that is not current and has refs == 0, fill it,
+ *           current = slot
+ *
+ * A reader that loses the race with a publish retries on the new slot; a
+ * slot is only rewritten once every reader that could have seen it has
+ * let go (the grace period is one struct copy). One writer at a time.
+ */
+
+#ifndef CONFIG_SNAPSHOT_H
+#define CONFIG_SNAPSHOT_H
+
+#include <Arduino.h>
+#include <atomic>
+
+template <typename T, int Slots = 3>
+class ConfigSnapshot {
+private:
+    static_assert(Slots >= 2, "a snapshot needs a spare slot to fill");
+
+    T slots[Slots];
+    std::atomic<uint32_t> current{0};
+    std::atomic<uint32_t> refs[Slots];
+
+public:
+    explicit ConfigSnapshot(const T& initial) {
+        slots[0] = initial;
+        for (int i = 0; i < Slots; i++) refs[i].store(0);
+    }
+
+    // Any task, lock-free: a complete snapshot as of some publish()
+    T read() {
+        uint32_t i;
+        for (;;) {
+            i = current.load();
+            refs[i].fetch_add(1);
+            if (current.load() == i) break;
+            refs[i].fetch_sub(1);
+        }
+        T copy = slots[i];
+        refs[i].fetch_sub(1, std::memory_order_release);
+        return copy;
+    }
+
+    // Writer: replaces the snapshot; the next read() returns `value`
+    void publish(const T& value) {
+        uint32_t cur = current.load();
+        for (;;) {
+            for (int k = 1; k < Slots; k++) {
+                uint32_t i = (cur + k) % Slots;
+                if (refs[i].load() != 0) continue;
+                slots[i] = value;
+                current.store(i);
+                return;
+            }
+            // Every spare slot is mid-copy in a reader; let a preempted one finish
+            vTaskDelay(1);
+        }
+    }
+};
+
+#endif // CONFIG_SNAPSHOT_H
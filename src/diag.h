@@ -0,0 +1,261 @@
+/*
+ * Diag Module - Deferred diagnostics: a lock-free record ring, formatted later
+ * DIAG_INFO("%s unlock at %d dBm", name, rssi) on a hot path stores the
+ * format pointer and the raw arguments (one fetch_add plus a 40-byte
+ * store, no formatting, no lock, no heap). A low-priority drain task
+ * formats the records and writes them to Serial, and GET /api/diag reads
+ * the same ring remotely.
+ *
+ * Nothing waits for a reader: writers overwrite the oldest record, and the
+ * drain only writes what the Serial TX buffer takes without blocking,
+ * finishing a line next period; records the ring overwrites before a reader
+ * gets to them are counted as missed. Arguments are integers (up to 32 bits),
+ * pointers, or strings that outlive the record (literals, device names in
+ * the static tables) - never String::c_str() or stack buffers. No floats;
+ * length modifiers are accepted, `*` widths are not.
+ *
+ * Levels below DIAG_LEVEL (default DIAG_LEVEL_INFO) compile to nothing:
+ * -DDIAG_LEVEL=4 adds the per-advert DIAG_DEBUG lines, -DDIAG_LEVEL=0
+ * removes every call.
+ */
+
+#ifndef DIAG_H
+#define DIAG_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "metrics.h"
+
+#define DIAG_LEVEL_ERROR 1
+#define DIAG_LEVEL_WARN 2
+#define DIAG_LEVEL_INFO 3
+#define DIAG_LEVEL_DEBUG 4
+
+#ifndef DIAG_LEVEL
+#define DIAG_LEVEL DIAG_LEVEL_INFO
+#endif
+
+#ifndef DIAG_RING_SIZE
+#define DIAG_RING_SIZE 128              // Records, power of two (5 KB)
+#endif
+#define DIAG_MAX_ARGS 6
+#define DIAG_LINE_MAX 160               // Formatted line, longer ones are cut
+
+static_assert((DIAG_RING_SIZE & (DIAG_RING_SIZE - 1)) == 0, "DIAG_RING_SIZE must be a power of two");
+
+static const char DIAG_LEVEL_CHARS[] = "?EWID";
+
+// One argument as captured; the drain picks the member from the conversion
+union DiagArg {
+    int32_t i;
+    uint32_t u;
+    const char* s;
+    const void* p;
+
+    DiagArg() : u(0) {}
+    DiagArg(int v) : i(v) {}
+    DiagArg(unsigned v) : u(v) {}
+    DiagArg(long v) : i((int32_t)v) {}
+    DiagArg(unsigned long v) : u((uint32_t)v) {}
+    DiagArg(const char* v) : s(v) {}
+    DiagArg(const void* v) : p(v) {}
+};
+
+struct DiagRecord {
+    uint32_t seq;           // Global sequence; written last, validates the slot
+    uint32_t ms;            // millis() when recorded
+    const char* format;     // String literal
+    DiagArg args[DIAG_MAX_ARGS];
+    uint8_t level;
+    uint8_t core;
+    uint8_t argCount;
+    uint8_t reserved;
+};
+
+class DiagLog {
+private:
+    DiagRecord ring[DIAG_RING_SIZE];
+    std::atomic<uint32_t> head{0};
+    // Drain task only: next record to format, and the line being written
+    uint32_t serialCursor = 0;
+    char serialLine[DIAG_LINE_MAX + 2];
+    size_t serialLineLen = 0;
+    size_t serialLineSent = 0;
+
+    // Writes as much of the pending line as the TX buffer takes; true once done
+    bool writeSerialLine() {
+        size_t room = (size_t)Serial.availableForWrite();
+        size_t left = serialLineLen - serialLineSent;
+        size_t n = room < left ? room : left;
+        if (n) serialLineSent += Serial.write((const uint8_t*)serialLine + serialLineSent, n);
+        return serialLineSent == serialLineLen;
+    }
+
+public:
+    // Any task (not an ISR); use the DIAG_* macros
+    template <typename... Args>
+    void record(uint8_t level, const char* format, Args... args) {
+        static_assert(sizeof...(Args) <= DIAG_MAX_ARGS, "too many DIAG_* arguments");
+        const DiagArg values[] = {DiagArg(args)..., DiagArg()};
+        uint32_t seq = head.fetch_add(1, std::memory_order_relaxed);
+        DiagRecord& r = ring[seq & (DIAG_RING_SIZE - 1)];
+        r.seq = UINT32_MAX;     // Mark in-flight for concurrent readers
+        std::atomic_thread_fence(std::memory_order_release);
+        r.ms = millis();
+        r.format = format;
+        for (size_t k = 0; k < sizeof...(Args); k++) r.args[k] = values[k];
+        r.level = level;
+        r.core = (uint8_t)xPortGetCoreID();
+        r.argCount = sizeof...(Args);
+        std::atomic_thread_fence(std::memory_order_release);
+        r.seq = seq;
+    }
+
+    uint32_t getHead() {
+        return head.load(std::memory_order_acquire);
+    }
+
+    // Copy out records with seq >= since (oldest first); skips slots a later
+    // lap overwrote and stops at one not written yet, leaving *next on it so
+    // the next read picks it up. Returns the number copied.
+    int readSince(uint32_t since, DiagRecord* out, int maxRecords, uint32_t* next) {
+        uint32_t end = getHead();
+        if (since > end) since = 0;     // Cursor from before a reboot
+        uint32_t first = (end - since > DIAG_RING_SIZE) ? end - DIAG_RING_SIZE : since;
+        int n = 0;
+        uint32_t i = first;
+        for (; i != end && n < maxRecords; i++) {
+            const DiagRecord& slot = ring[i & (DIAG_RING_SIZE - 1)];
+            uint32_t before = slot.seq;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            DiagRecord copy = slot;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint32_t after = slot.seq;
+            if (before == i && after == i) {
+                out[n++] = copy;
+                continue;
+            }
+            // Changed under the copy, or already holding a later lap's seq
+            bool overwritten = before == i || (before != UINT32_MAX && (int32_t)(before - i) > 0);
+            if (!overwritten) break;
+        }
+        *next = i;
+        return n;
+    }
+
+    // printf of a record, one conversion at a time with its captured type
+    static size_t format(const DiagRecord& r, char* out, size_t size) {
+        size_t used = 0;
+        int arg = 0;
+        const char* p = r.format;
+        while (*p && used + 1 < size) {
+            if (*p != '%') {
+                out[used++] = *p++;
+                continue;
+            }
+            if (p[1] == '%') {
+                out[used++] = '%';
+                p += 2;
+                continue;
+            }
+
+            // Flags, width and precision as written; length modifiers dropped
+            char spec[16];
+            size_t s = 0;
+            spec[s++] = *p++;
+            while (*p && strchr("-+ #0123456789.", *p) && s < sizeof(spec) - 2) spec[s++] = *p++;
+            while (*p && strchr("hlzjtL", *p)) p++;
+            char conversion = *p;
+            if (!conversion) break;
+            p++;
+            spec[s++] = conversion;
+            spec[s] = '\0';
+
+            DiagArg a = arg < r.argCount ? r.args[arg] : DiagArg();
+            arg++;
+            int n;
+            switch (conversion) {
+                case 'd':
+                case 'i':
+                case 'c':
+                    n = snprintf(out + used, size - used, spec, (int)a.i);
+                    break;
+                case 's':
+                    n = snprintf(out + used, size - used, spec, a.s ? a.s : "(null)");
+                    break;
+                case 'p':
+                    n = snprintf(out + used, size - used, spec, a.p);
+                    break;
+                default:
+                    n = snprintf(out + used, size - used, spec, (unsigned)a.u);
+                    break;
+            }
+            if (n < 0) break;
+            used += (size_t)n < size - used ? (size_t)n : size - used - 1;
+        }
+        out[used] = '\0';
+        return used;
+    }
+
+    // Drain task: formats everything new to Serial. When the TX buffer is
+    // full it stops and carries on from there next period (a USB CDC port
+    // without a host never drains; the ring then overwrites what waits).
+    void drain() {
+        if (!writeSerialLine()) return;
+        DiagRecord chunk[8];
+        for (;;) {
+            uint32_t next;
+            int n = readSince(serialCursor, chunk, 8, &next);
+            for (int k = 0; k < n; k++) {
+                if (chunk[k].seq != serialCursor) metrics.diagOverwritten.inc(chunk[k].seq - serialCursor);
+                serialCursor = chunk[k].seq + 1;
+
+                serialLineLen = format(chunk[k], serialLine, DIAG_LINE_MAX);
+                serialLine[serialLineLen++] = '\n';
+                serialLineSent = 0;
+                if (!writeSerialLine()) return;
+            }
+            if (next != serialCursor) metrics.diagOverwritten.inc(next - serialCursor);
+            serialCursor = next;
+            if (n == 0) return;
+        }
+    }
+};
+
+extern DiagLog diag;
+
+// Compile-time check of the arguments against the format; never called
+static inline void diagFormatCheck(const char*, ...) __attribute__((format(printf, 1, 2)));
+static inline void diagFormatCheck(const char*, ...) {}
+
+// `"" format` only accepts a string literal, which the record points to
+#define DIAG_RECORD(level, format, ...) do { \
+    if (0) diagFormatCheck(format, ##__VA_ARGS__); \
+    diag.record(level, "" format, ##__VA_ARGS__); \
+} while (0)
+
+#if DIAG_LEVEL >= DIAG_LEVEL_ERROR
+#define DIAG_ERROR(format, ...) DIAG_RECORD(DIAG_LEVEL_ERROR, format, ##__VA_ARGS__)
+#else
+#define DIAG_ERROR(format, ...) do {} while (0)
+#endif
+
+#if DIAG_LEVEL >= DIAG_LEVEL_WARN
+#define DIAG_WARN(format, ...) DIAG_RECORD(DIAG_LEVEL_WARN, format, ##__VA_ARGS__)
+#else
+#define DIAG_WARN(format, ...) do {} while (0)
+#endif
+
+#if DIAG_LEVEL >= DIAG_LEVEL_INFO
+#define DIAG_INFO(format, ...) DIAG_RECORD(DIAG_LEVEL_INFO, format, ##__VA_ARGS__)
+#else
+#define DIAG_INFO(format, ...) do {} while (0)
+#endif
+
+#if DIAG_LEVEL >= DIAG_LEVEL_DEBUG
+#define DIAG_DEBUG(format, ...) DIAG_RECORD(DIAG_LEVEL_DEBUG, format, ##__VA_ARGS__)
+#else
+#define DIAG_DEBUG(format, ...) do {} while (0)
+#endif
+
+#endif // DIAG_H
@@ -0,0 +1,276 @@
+/*
+ * Event Stream Module - Server-Sent Events push channel for the dashboard
+ * Streams lock/unlock, presence and RSSI events to a few long-lived clients.
+ * Producers (BLE callback, main loop) only touch RAM; frames are written
+ * from the web server context with non-blocking sends.
+ */
+
+#ifndef EVENT_STREAM_H
+#define EVENT_STREAM_H
+
+#include <WiFi.h>
+#include <lwip/sockets.h>
+#include "storage.h"
+#include "diag.h"
+
+// Configuration
+#define MAX_EVENT_CLIENTS 2
+#define EVENT_QUEUE_SIZE 16           // Discrete events kept for slow clients
+#define EVENT_RSSI_INTERVAL_MS 500    // Default per-client RSSI rate limit
+#define EVENT_RSSI_MIN_INTERVAL_MS 100
+#define EVENT_KEEPALIVE_MS 15000
+#define EVENT_MAX_PER_UPDATE 4        // Frames written per client per update()
+
+// Event types
+#define EVENT_UNLOCK   0
+#define EVENT_LOCK     1
+#define EVENT_PRESENCE 2
+
+static_assert(MAX_DEVICES <= 32, "RSSI dirty mask holds one bit per device");
+
+class EventStream {
+private:
+    struct Event {
+        uint32_t time;      // millis() at event time
+        uint8_t type;
+        uint8_t device;
+        int8_t value;       // RSSI for lock/unlock, 0/1 for presence
+    };
+
+    struct Client {
+        WiFiClient conn;
+        bool active;
+        uint32_t readSeq;           // Next discrete event to send
+        uint32_t rssiDirty;         // Devices with an unsent RSSI sample
+        uint32_t lastRssiSend;
+        uint32_t lastWrite;
+        uint16_t rssiIntervalMs;
+        uint32_t dropped;           // Events skipped (queue overrun)
+    };
+
+    enum SendResult {
+        SEND_OK,
+        SEND_BLOCKED,               // Socket buffer full, nothing written
+        SEND_FAILED                 // Partial write or connection error
+    };
+
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+
+    Event queue[EVENT_QUEUE_SIZE];
+    uint32_t writeSeq = 0;
+
+    // Latest RSSI per device, coalesced until the client's next RSSI frame
+    int8_t latestRssi[MAX_DEVICES];
+
+    Client clients[MAX_EVENT_CLIENTS];
+
+    void pushEvent(uint8_t type, uint8_t device, int8_t value) {
+        portENTER_CRITICAL(&mux);
+        Event& e = queue[writeSeq % EVENT_QUEUE_SIZE];
+        e.time = millis();
+        e.type = type;
+        e.device = device;
+        e.value = value;
+        writeSeq++;
+        portEXIT_CRITICAL(&mux);
+    }
+
+    // SEND_FAILED: the client must be dropped
+    SendResult sendFrame(Client& c, const char* frame, int len) {
+        int sent = send(c.conn.fd(), frame, len, MSG_DONTWAIT);
+        if (sent == len) {
+            c.lastWrite = millis();
+            return SEND_OK;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return SEND_BLOCKED;
+        return SEND_FAILED;
+    }
+
+    void closeClient(Client& c) {
+        c.conn.stop();
+        c.conn = WiFiClient();
+        c.active = false;
+        DIAG_INFO("Event stream client disconnected");
+    }
+
+    // An event leaves the client's backlog only once its frame is fully
+    // written; a full socket leaves it for the next update(). Only events the
+    // queue overwrote before they could be sent count as dropped.
+    bool flushEvents(Client& c) {
+        char frame[96];
+        int budget = EVENT_MAX_PER_UPDATE;
+
+        while (budget-- > 0) {
+            Event e;
+            portENTER_CRITICAL(&mux);
+            if (c.readSeq == writeSeq) {
+                portEXIT_CRITICAL(&mux);
+                return true;
+            }
+            if (writeSeq - c.readSeq > EVENT_QUEUE_SIZE) {
+                // Client fell behind - skip to the oldest retained event
+                c.dropped += writeSeq - c.readSeq - EVENT_QUEUE_SIZE;
+                c.readSeq = writeSeq - EVENT_QUEUE_SIZE;
+            }
+            e = queue[c.readSeq % EVENT_QUEUE_SIZE];
+            portEXIT_CRITICAL(&mux);
+
+            int len;
+            if (e.type == EVENT_PRESENCE) {
+                len = snprintf(frame, sizeof(frame),
+                    "event: presence\ndata: {\"d\":%u,\"p\":%d,\"t\":%lu}\n\n",
+                    e.device, e.value, (unsigned long)e.time);
+            } else {
+                len = snprintf(frame, sizeof(frame),
+                    "event: %s\ndata: {\"d\":%u,\"r\":%d,\"t\":%lu}\n\n",
+                    e.type == EVENT_UNLOCK ? "unlock" : "lock",
+                    e.device, e.value, (unsigned long)e.time);
+            }
+            SendResult result = sendFrame(c, frame, len);
+            if (result == SEND_FAILED) return false;
+            if (result == SEND_BLOCKED) return true;
+            c.readSeq++;                // Only this task moves the cursor
+        }
+        return true;
+    }
+
+    bool flushRssi(Client& c, uint32_t now) {
+        if (now - c.lastRssiSend < c.rssiIntervalMs) return true;
+
+        uint32_t dirty;
+        int8_t rssi[MAX_DEVICES];
+        portENTER_CRITICAL(&mux);
+        dirty = c.rssiDirty;
+        c.rssiDirty = 0;
+        memcpy(rssi, latestRssi, sizeof(rssi));
+        portEXIT_CRITICAL(&mux);
+
+        if (dirty == 0) return true;
+
+        // One frame carries every device that changed: [[device,rssi],...]
+        char frame[32 + MAX_DEVICES * 10];
+        int len = snprintf(frame, sizeof(frame), "event: rssi\ndata: [");
+        bool first = true;
+        for (int i = 0; i < MAX_DEVICES; i++) {
+            if (!(dirty & (1UL << i))) continue;
+            len += snprintf(frame + len, sizeof(frame) - len, "%s[%d,%d]", first ? "" : ",", i, rssi[i]);
+            first = false;
+        }
+        len += snprintf(frame + len, sizeof(frame) - len, "]\n\n");
+
+        c.lastRssiSend = now;
+        SendResult result = sendFrame(c, frame, len);
+        if (result == SEND_BLOCKED) {
+            // Rate limited anyway: the latest values go with the next frame
+            portENTER_CRITICAL(&mux);
+            c.rssiDirty |= dirty;
+            portEXIT_CRITICAL(&mux);
+        }
+        return result != SEND_FAILED;
+    }
+
+public:
+    EventStream() {
+        for (int i = 0; i < MAX_EVENT_CLIENTS; i++) clients[i].active = false;
+        memset(latestRssi, 0, sizeof(latestRssi));
+    }
+
+    // ========== Producers (any task, non-blocking) ==========
+
+    void publishUnlock(uint8_t device, int8_t rssi) {
+        pushEvent(EVENT_UNLOCK, device, rssi);
+    }
+
+    void publishLock(uint8_t device) {
+        pushEvent(EVENT_LOCK, device, 0);
+    }
+
+    void publishPresence(uint8_t device, bool present) {
+        pushEvent(EVENT_PRESENCE, device, present ? 1 : 0);
+    }
+
+    // RSSI samples are coalesced: only the latest value per device is sent
+    void publishRssi(uint8_t device, int8_t rssi) {
+        if (device >= MAX_DEVICES) return;
+        portENTER_CRITICAL(&mux);
+        latestRssi[device] = rssi;
+        for (int i = 0; i < MAX_EVENT_CLIENTS; i++) {
+            if (clients[i].active) clients[i].rssiDirty |= (1UL << device);
+        }
+        portEXIT_CRITICAL(&mux);
+    }
+
+    // ========== Web server side ==========
+
+    // Take over the connection of the current request. Returns false if full.
+    bool addClient(WiFiClient conn, uint16_t rssiIntervalMs) {
+        for (int i = 0; i < MAX_EVENT_CLIENTS; i++) {
+            Client& c = clients[i];
+            if (c.active) continue;
+
+            if (rssiIntervalMs < EVENT_RSSI_MIN_INTERVAL_MS) rssiIntervalMs = EVENT_RSSI_MIN_INTERVAL_MS;
+
+            conn.setNoDelay(true);
+            conn.print("HTTP/1.1 200 OK\r\n"
+                       "Content-Type: text/event-stream\r\n"
+                       "Cache-Control: no-cache\r\n"
+                       "Connection: keep-alive\r\n\r\n"
+                       "retry: 3000\n\n");
+
+            c.conn = conn;
+
+            portENTER_CRITICAL(&mux);
+            c.readSeq = writeSeq;
+            c.rssiDirty = 0;
+            c.lastRssiSend = 0;
+            c.lastWrite = millis();
+            c.rssiIntervalMs = rssiIntervalMs;
+            c.dropped = 0;
+            c.active = true;
+            portEXIT_CRITICAL(&mux);
+
+            DIAG_INFO("Event stream client connected (slot %d, rssi every %ums)", i, rssiIntervalMs);
+            return true;
+        }
+        return false;
+    }
+
+    // Call from the web server loop
+    void update() {
+        uint32_t now = millis();
+
+        for (int i = 0; i < MAX_EVENT_CLIENTS; i++) {
+            Client& c = clients[i];
+            if (!c.active) continue;
+
+            if (!c.conn.connected()) {
+                closeClient(c);
+                continue;
+            }
+
+            bool ok = flushEvents(c) && flushRssi(c, now);
+
+            if (ok && now - c.lastWrite >= EVENT_KEEPALIVE_MS) {
+                ok = sendFrame(c, ":\n\n", 3) != SEND_FAILED;
+            }
+
+            if (!ok) closeClient(c);
+        }
+    }
+
+    int getClientCount() {
+        int count = 0;
+        for (int i = 0; i < MAX_EVENT_CLIENTS; i++) {
+            if (clients[i].active) count++;
+        }
+        return count;
+    }
+
+    uint32_t getDroppedCount() {
+        uint32_t total = 0;
+        for (int i = 0; i < MAX_EVENT_CLIENTS; i++) total += clients[i].dropped;
+        return total;
+    }
+};
+
+#endif // EVENT_STREAM_H
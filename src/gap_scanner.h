@@ -0,0 +1,118 @@
+/*
+ * GAP Scanner - Passive BLE scanning straight on the Bluedroid GAP API
+ * Replaces BLEScan in keyless mode: BLEScan copies every advert into a
+ * BLEAdvertisedDevice (std::string/std::map members) and keeps a
+ * BLEScanResults map until clearResults(), i.e. heap traffic per advert.
+ * Here the GAP event is handed to the callback as (address, RSSI) with
+ * nothing copied; completion is signalled through a static semaphore.
+ *
+ * Events arrive through BLEDevice::setCustomGapHandler(), so the Arduino
+ * BLE library stays in charge of init/deinit and pairing mode.
+ */
+
+#ifndef GAP_SCANNER_H
+#define GAP_SCANNER_H
+
+#include <Arduino.h>
+#include <BLEDevice.h>
+#include "esp_gap_ble_api.h"
+
+#define GAP_SCAN_TIMEOUT_MARGIN_MS 2000  // Beyond the scan duration before giving up
+
+// Called from the Bluedroid (BTC) task for every advertising report
+typedef void (*GapAdvertHandler)(const uint8_t* address, int rssi, uint32_t entryCycles);
+
+enum GapScanResult {
+    GAP_SCAN_OK,
+    GAP_SCAN_PARAM_FAILED,
+    GAP_SCAN_START_FAILED,
+    GAP_SCAN_TIMEOUT
+};
+
+class GapScanner {
+private:
+    // Shared with the GAP callback (a plain function pointer, no context)
+    struct State {
+        GapAdvertHandler handler;
+        SemaphoreHandle_t done;
+        StaticSemaphore_t doneBuffer;
+        volatile GapScanResult result;
+        volatile uint32_t durationS;
+    };
+
+    static State& state() {
+        static State s;
+        return s;
+    }
+
+    static void finish(GapScanResult result) {
+        state().result = result;
+        xSemaphoreGive(state().done);
+    }
+
+    static void onGapEvent(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t* param) {
+        State& s = state();
+        switch (event) {
+            case ESP_GAP_BLE_SCAN_PARAM_SET_COMPLETE_EVT:
+                if (param->scan_param_cmpl.status != ESP_BT_STATUS_SUCCESS) {
+                    finish(GAP_SCAN_PARAM_FAILED);
+                } else if (esp_ble_gap_start_scanning(s.durationS) != ESP_OK) {
+                    finish(GAP_SCAN_START_FAILED);
+                }
+                break;
+
+            case ESP_GAP_BLE_SCAN_START_COMPLETE_EVT:
+                if (param->scan_start_cmpl.status != ESP_BT_STATUS_SUCCESS) {
+                    finish(GAP_SCAN_START_FAILED);
+                }
+                break;
+
+            case ESP_GAP_BLE_SCAN_RESULT_EVT:
+                if (param->scan_rst.search_evt == ESP_GAP_SEARCH_INQ_RES_EVT) {
+                    if (s.handler) s.handler(param->scan_rst.bda, param->scan_rst.rssi, ESP.getCycleCount());
+                } else if (param->scan_rst.search_evt == ESP_GAP_SEARCH_INQ_CMPL_EVT) {
+                    finish(GAP_SCAN_OK);
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+
+public:
+    // Once, after BLEDevice::init(); allocates nothing afterwards
+    void begin(GapAdvertHandler onAdvert) {
+        State& s = state();
+        if (!s.done) s.done = xSemaphoreCreateBinaryStatic(&s.doneBuffer);
+        s.handler = onAdvert;
+        BLEDevice::setCustomGapHandler(onGapEvent);
+    }
+
+    // Blocking passive scan of `seconds` (interval/window in 0.625 ms units)
+    GapScanResult scan(uint16_t interval, uint16_t window, uint32_t seconds) {
+        State& s = state();
+        esp_ble_scan_params_t params;
+        memset(&params, 0, sizeof(params));
+        params.scan_type = BLE_SCAN_TYPE_PASSIVE;
+        params.own_addr_type = BLE_ADDR_TYPE_PUBLIC;
+        params.scan_filter_policy = BLE_SCAN_FILTER_ALLOW_ALL;
+        params.scan_interval = interval;
+        params.scan_window = window;
+        params.scan_duplicate = BLE_SCAN_DUPLICATE_DISABLE;
+
+        xSemaphoreTake(s.done, 0);      // Drop a completion left over from a timed-out scan
+        s.durationS = seconds;
+        if (esp_ble_gap_set_scan_params(&params) != ESP_OK) return GAP_SCAN_PARAM_FAILED;
+
+        // Scanning starts from the param-set-complete event
+        TickType_t timeout = pdMS_TO_TICKS(seconds * 1000 + GAP_SCAN_TIMEOUT_MARGIN_MS);
+        if (xSemaphoreTake(s.done, timeout) != pdTRUE) {
+            esp_ble_gap_stop_scanning();
+            return GAP_SCAN_TIMEOUT;
+        }
+        return s.result;
+    }
+};
+
+#endif // GAP_SCANNER_H
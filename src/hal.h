@@ -0,0 +1,60 @@
+/*
+ * HAL - Hardware abstraction for the keyless application
+ * main.cpp reaches the clock, GPIO, the BLE advert source, restart and the
+ * task watchdog only through `hal`, so the same setup()/loop() flow builds
+ * for two targets:
+ *
+ *   ESP32 (default)   hal_esp32.h: Arduino core, Bluedroid GAP scanner,
+ *                     esp_task_wdt, NVS
+ *   Linux (-DHAL_LINUX=1, env:linux)
+ *                     hal_linux.h: virtual clock and cooperative tasks
+ *                     (src/sim/native/sim_kernel.h), recorded GPIO, adverts
+ *                     from a simulated feed (src/sim/), restart = re-exec
+ *
+ * Persistent storage is the Preferences API on both: NVS on the ESP32, one
+ * file per namespace under the simulator's state directory on Linux.
+ *
+ * Dispatch is static (one class per target, typedef'd to Hal): the calls
+ * cost what the direct Arduino/ESP-IDF calls did.
+ */
+
+#ifndef HAL_H
+#define HAL_H
+
+#include <Arduino.h>
+
+#ifndef HAL_LINUX
+#define HAL_LINUX 0
+#endif
+
+// Every advertising report heard by the scanner; runs on the BLE stack's
+// task (ESP32) or the scan task (Linux) and must not block
+typedef void (*HalAdvertHandler)(const uint8_t* address, int rssi, uint32_t entryCycles);
+
+enum HalScanResult {
+    HAL_SCAN_OK,
+    HAL_SCAN_PARAM_FAILED,
+    HAL_SCAN_START_FAILED,
+    HAL_SCAN_TIMEOUT
+};
+
+enum HalResetReason {
+    HAL_RESET_POWER_ON,
+    HAL_RESET_SOFTWARE,     // hal.restart()
+    HAL_RESET_WATCHDOG,
+    HAL_RESET_OTHER
+};
+
+static const char* const HAL_RESET_REASON_NAMES[] = {"power-on", "software", "watchdog", "other"};
+
+#if HAL_LINUX
+#include "hal_linux.h"
+typedef LinuxHal Hal;
+#else
+#include "hal_esp32.h"
+typedef Esp32Hal Hal;
+#endif
+
+extern Hal hal;
+
+#endif // HAL_H
@@ -0,0 +1,97 @@
+/*
+ * ESP32 HAL - Arduino core, Bluedroid GAP scanner, esp_task_wdt
+ * Thin forwarding layer, see hal.h. Included through hal.h only.
+ */
+
+#ifndef HAL_ESP32_H
+#define HAL_ESP32_H
+
+#include <Arduino.h>
+#include <BLEDevice.h>
+#include <esp_system.h>
+#include "esp_task_wdt.h"
+#include "gap_scanner.h"
+
+static_assert((int)GAP_SCAN_OK == (int)HAL_SCAN_OK && (int)GAP_SCAN_TIMEOUT == (int)HAL_SCAN_TIMEOUT,
+              "GapScanResult mirrors HalScanResult");
+
+class Esp32Hal {
+private:
+    GapScanner gapScanner;          // Raw GAP scanning, no per-advert copies
+
+public:
+    // ========== Clock ==========
+
+    uint32_t millis() {
+        return ::millis();
+    }
+
+    uint32_t micros() {
+        return ::micros();
+    }
+
+    void delay(uint32_t ms) {
+        ::delay(ms);
+    }
+
+    // ========== GPIO ==========
+
+    void pinMode(uint8_t pin, uint8_t mode) {
+        ::pinMode(pin, mode);
+    }
+
+    void digitalWrite(uint8_t pin, uint8_t level) {
+        ::digitalWrite(pin, level);
+    }
+
+    // ========== Restart / Watchdog ==========
+
+    HalResetReason resetReason() {
+        switch (esp_reset_reason()) {
+            case ESP_RST_POWERON:  return HAL_RESET_POWER_ON;
+            case ESP_RST_SW:       return HAL_RESET_SOFTWARE;
+            case ESP_RST_TASK_WDT:
+            case ESP_RST_INT_WDT:
+            case ESP_RST_WDT:      return HAL_RESET_WATCHDOG;
+            default:               return HAL_RESET_OTHER;
+        }
+    }
+
+    void restart() {
+        ESP.restart();
+    }
+
+    void watchdogBegin(uint32_t timeoutS) {
+        esp_task_wdt_init(timeoutS, true);
+    }
+
+    // Subscribe / feed the calling task
+    void watchdogAdd() {
+        esp_task_wdt_add(NULL);
+    }
+
+    void watchdogReset() {
+        esp_task_wdt_reset();
+    }
+
+    // ========== BLE advert source ==========
+
+    // Leaves pairing mode: restarts the BLE stack as a plain scanner
+    void scannerBegin(HalAdvertHandler onAdvert) {
+        BLEDevice::deinit(true);
+        ::delay(2000);  // Extended delay for complete BLE stack cleanup
+        BLEDevice::init("");
+        ::delay(500);   // Allow BLE stack to initialize
+
+        // Passive GAP scanner (parameters are set per scan from the coex profile)
+        gapScanner.begin(onAdvert);
+        ::delay(1000);  // Let the BLE stack settle before the first scan
+    }
+
+    // Blocking passive scan, adverts go to the scannerBegin() handler
+    HalScanResult scan(uint16_t interval, uint16_t window, uint32_t seconds) {
+        return (HalScanResult)gapScanner.scan(interval, window, seconds);
+    }
+};
+
+#endif // HAL_ESP32_H
@@ -0,0 +1,144 @@
+/*
+ * Linux HAL - Simulated device for the Linux build (env:linux)
+ * Clock and watchdog come from the sim kernel (virtual time), GPIO writes
+ * are recorded and reported to the simulator, and the BLE advert source
+ * replays a feed supplied by the simulator (src/sim/sim_feed.h).
+ * Included through hal.h only.
+ *
+ * Scanning models the radio duty cycle: an advert sent while a scan runs
+ * is heard with probability window/interval; adverts sent between scans
+ * are lost, as on the device.
+ */
+
+#ifndef HAL_LINUX_H
+#define HAL_LINUX_H
+
+#include <Arduino.h>
+#include <stdlib.h>
+#include "sim_kernel.h"
+
+#define HAL_LINUX_PINS 40
+
+// One advertising report, on the device clock (simNowUs())
+struct HalAdvert {
+    uint64_t timeUs;
+    uint8_t address[6];
+    int8_t rssi;
+};
+
+// Simulator hooks. The feed returns adverts in time order, the next one
+// sent at or before `untilUs`, or false if there is none yet.
+typedef bool (*HalAdvertFeed)(uint64_t untilUs, HalAdvert* out);
+typedef void (*HalPinHook)(uint8_t pin, uint8_t level);
+typedef void (*HalRestartHook)(HalResetReason reason);
+
+class LinuxHal {
+private:
+    uint8_t pinLevels[HAL_LINUX_PINS] = {0};
+    HalAdvertHandler handler = NULL;
+    HalAdvertFeed feed = NULL;
+    HalPinHook pinHook = NULL;
+    HalRestartHook restartHook = NULL;
+    HalResetReason bootReason = HAL_RESET_POWER_ON;
+    uint32_t rng = 1;               // xorshift32, scan duty draws
+
+    uint32_t heard = 0;             // Adverts passed to the handler
+
+    uint32_t nextRandom() {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return rng;
+    }
+
+public:
+    // Wired by the simulator before setup()
+    void attach(HalAdvertFeed advertFeed, HalPinHook onPin, HalRestartHook onRestart,
+                HalResetReason reason, uint32_t seed) {
+        feed = advertFeed;
+        pinHook = onPin;
+        restartHook = onRestart;
+        bootReason = reason;
+        rng = seed ? seed : 1;
+    }
+
+    // ========== Clock ==========
+
+    uint32_t millis() {
+        return ::millis();
+    }
+
+    uint32_t micros() {
+        return ::micros();
+    }
+
+    void delay(uint32_t ms) {
+        ::delay(ms);
+    }
+
+    // ========== GPIO ==========
+
+    void pinMode(uint8_t, uint8_t) {
+    }
+
+    void digitalWrite(uint8_t pin, uint8_t level) {
+        if (pin >= HAL_LINUX_PINS || pinLevels[pin] == level) return;
+        pinLevels[pin] = level;
+        if (pinHook) pinHook(pin, level);
+    }
+
+    uint8_t readPin(uint8_t pin) {
+        return pin < HAL_LINUX_PINS ? pinLevels[pin] : LOW;
+    }
+
+    // ========== Restart / Watchdog ==========
+
+    HalResetReason resetReason() {
+        return bootReason;
+    }
+
+    // The simulator re-executes itself; NVS files carry over
+    void restart() {
+        if (restartHook) restartHook(HAL_RESET_SOFTWARE);
+        exit(0);
+    }
+
+    void watchdogBegin(uint32_t timeoutS) {
+        simWatchdogBegin(timeoutS);
+    }
+
+    void watchdogAdd() {
+        simWatchdogAdd();
+    }
+
+    void watchdogReset() {
+        simWatchdogReset();
+    }
+
+    // ========== BLE advert source ==========
+
+    void scannerBegin(HalAdvertHandler onAdvert) {
+        handler = onAdvert;
+    }
+
+    // Sleeps through `seconds` of scanning, delivering feed adverts on time
+    HalScanResult scan(uint16_t interval, uint16_t window, uint32_t seconds) {
+        uint64_t endUs = simNowUs() + (uint64_t)seconds * 1000000;
+        HalAdvert a;
+        while (feed && feed(endUs, &a)) {
+            if (a.timeUs < simNowUs()) continue;           // Sent between scans
+            simSleepUs(a.timeUs - simNowUs());
+            if (nextRandom() % interval >= window) continue;   // Radio off-window (or on WiFi)
+            heard++;
+            if (handler) handler(a.address, a.rssi, ESP.getCycleCount());
+        }
+        if (endUs > simNowUs()) simSleepUs(endUs - simNowUs());
+        return HAL_SCAN_OK;
+    }
+
+    uint32_t getHeard() {
+        return heard;
+    }
+};
+
+#endif // HAL_LINUX_H
@@ -0,0 +1,142 @@
+/*
+ * Keyless Config - Compile-time shape and runtime thresholds of the keyless core
+ *
+ * Compile time (KeylessTraits): device capacity, RSSI filter policy and the
+ * timing constants nobody tunes in the field. The RPA resolver, the device
+ * tables and the proximity engine are sized and specialised from it, so a
+ * 1-, 10- or 100-device build gets fixed-size arrays and constant loop
+ * bounds. Variants derive from the defaults:
+ *
+ *   KeylessCapacity<100>                               100 devices
+ *   KeylessFilter<RssiEma<2>, KeylessCapacity<1> >     1 device, smoothed RSSI
+ *
+ * The firmware uses KeylessTraits with KEYLESS_MAX_DEVICES (-D to change).
+ *
+ * Runtime (ProximityConfig): the thresholds set from the dashboard and NVS,
+ * range-checked by validate() before they take effect.
+ */
+
+#ifndef KEYLESS_CONFIG_H
+#define KEYLESS_CONFIG_H
+
+#include <stdint.h>
+
+#ifndef KEYLESS_MAX_DEVICES
+#define KEYLESS_MAX_DEVICES 10
+#endif
+
+// The one device capacity every fixed-size table is laid out with
+#define MAX_DEVICES KEYLESS_MAX_DEVICES
+
+// Runtime threshold limits (validate())
+#define KEYLESS_RSSI_MIN -100
+#define KEYLESS_RSSI_MAX -30
+#define KEYLESS_TIMEOUT_MIN_S 1
+#define KEYLESS_TIMEOUT_MAX_S 255       // NVS stores seconds in a byte
+#define KEYLESS_WEAK_MIN 1
+#define KEYLESS_WEAK_MAX 20
+
+// ========== RSSI filter policies ==========
+
+// Every advert's RSSI as received
+struct RssiRaw {
+    struct State {
+    };
+
+    static void reset(State&) {
+    }
+
+    static int apply(State&, int rssi) {
+        return rssi;
+    }
+};
+
+// Exponential moving average, new = avg + (rssi - avg) / 2^Shift
+template <int Shift>
+struct RssiEma {
+    static_assert(Shift >= 1 && Shift <= 4, "RssiEma shift 1..4");
+
+    struct State {
+        int16_t avg;                    // dBm * 16
+        bool primed;
+    };
+
+    static void reset(State& s) {
+        s.avg = 0;
+        s.primed = false;
+    }
+
+    static int apply(State& s, int rssi) {
+        if (!s.primed) {
+            s.avg = (int16_t)(rssi * 16);
+            s.primed = true;
+        } else {
+            s.avg = (int16_t)(s.avg + ((rssi * 16 - s.avg) >> Shift));
+        }
+        return s.avg >= 0 ? (s.avg + 8) / 16 : (s.avg - 8) / 16;
+    }
+};
+
+// ========== Compile-time traits ==========
+
+struct KeylessTraits {
+    static const int capacity = KEYLESS_MAX_DEVICES;
+    typedef RssiRaw RssiFilter;
+    static const uint32_t weakResetMs = 5000;   // Weak count starts over after this gap
+    static const uint32_t scanSeconds = 3;      // One blocking scan pass
+};
+
+template <int Capacity, typename Base = KeylessTraits>
+struct KeylessCapacity : Base {
+    static_assert(Capacity >= 1 && Capacity <= 255, "device index must fit a byte (logs, traces)");
+    static const int capacity = Capacity;
+};
+
+template <typename Filter, typename Base = KeylessTraits>
+struct KeylessFilter : Base {
+    typedef Filter RssiFilter;
+};
+
+// ========== Runtime thresholds ==========
+
+// NVS layout of the dashboard settings
+struct KeylessSettings {
+    int8_t rssiUnlockThreshold;   // Default: -90
+    int8_t rssiLockThreshold;     // Default: -80
+    uint8_t proximityTimeout;     // Default: 10 (seconds)
+    uint8_t weakSignalThreshold;  // Default: 3
+};
+
+struct ProximityConfig {
+    int unlockRssi;
+    int lockRssi;
+    unsigned long timeoutMs;
+    int weakThreshold;
+
+    static ProximityConfig fromSettings(const KeylessSettings& s) {
+        ProximityConfig cfg = {s.rssiUnlockThreshold, s.rssiLockThreshold, s.proximityTimeout * 1000UL,
+                               s.weakSignalThreshold};
+        return cfg;
+    }
+
+    // Only meaningful after validate() returned nullptr
+    KeylessSettings toSettings() const {
+        KeylessSettings s = {(int8_t)unlockRssi, (int8_t)lockRssi, (uint8_t)(timeoutMs / 1000),
+                             (uint8_t)weakThreshold};
+        return s;
+    }
+
+    // The first field out of range, or nullptr
+    const char* validate() const {
+        if (unlockRssi < KEYLESS_RSSI_MIN || unlockRssi > KEYLESS_RSSI_MAX) return "rssiUnlock out of range";
+        if (lockRssi < KEYLESS_RSSI_MIN || lockRssi > KEYLESS_RSSI_MAX) return "rssiLock out of range";
+        if (timeoutMs < KEYLESS_TIMEOUT_MIN_S * 1000UL || timeoutMs > KEYLESS_TIMEOUT_MAX_S * 1000UL ||
+            timeoutMs % 1000) {
+            return "timeout out of range";
+        }
+        if (weakThreshold < KEYLESS_WEAK_MIN || weakThreshold > KEYLESS_WEAK_MAX) return "weakCount out of range";
+        return nullptr;
+    }
+};
+
+#endif // KEYLESS_CONFIG_H
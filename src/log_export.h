@@ -0,0 +1,52 @@
+/*
+ * Log Export Format - Fixed-width binary records for bulk log download
+ * Served by GET /api/log/export, decoded by tools/klog_decode.py.
+ * All fields little-endian (native on ESP32).
+ *
+ *   Header (16 bytes)                 Record (16 bytes)
+ *   0  char[4] magic "KLG1"           0  uint64 time (ms, see flags)
+ *   4  uint8   version                8  uint32 seq
+ *   5  uint8   record size           12  uint8  device index
+ *   6  uint16  header flags          13  uint8  action (0=Lock, 1=Unlock)
+ *   8  uint32  record count          14  int8   rssi
+ *  12  uint32  next cursor (seq)     15  uint8  record flags
+ */
+
+#ifndef LOG_EXPORT_H
+#define LOG_EXPORT_H
+
+#include <stdint.h>
+
+#define LOG_EXPORT_MAGIC "KLG1"
+#define LOG_EXPORT_VERSION 1
+
+// Header flags
+#define LOG_EXPORT_NTP_SYNCED   0x0001  // Device clock was NTP-synced at export
+
+// Record flags
+#define LOG_RECORD_ABSOLUTE     0x01    // time = Unix epoch ms
+#define LOG_RECORD_PREV_BOOT    0x02    // Logged before the current boot, time unknown
+                                        // (neither flag: time = ms since current boot)
+
+struct __attribute__((packed)) LogExportHeader {
+    char magic[4];
+    uint8_t version;
+    uint8_t recordSize;
+    uint16_t flags;
+    uint32_t count;
+    uint32_t nextCursor;
+};
+
+struct __attribute__((packed)) LogExportRecord {
+    uint64_t timeMs;
+    uint32_t seq;
+    uint8_t deviceIndex;
+    uint8_t action;
+    int8_t rssi;
+    uint8_t flags;
+};
+
+static_assert(sizeof(LogExportHeader) == 16, "export header must stay 16 bytes");
+static_assert(sizeof(LogExportRecord) == 16, "export record must stay 16 bytes");
+
+#endif // LOG_EXPORT_H
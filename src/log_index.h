@@ -0,0 +1,224 @@
+/*
+ * Log Index - RAM indexes over the audit log ring for filtered queries
+ * Rebuilt from the ring at boot and kept up to date on every append:
+ *
+ *   device chain   per entry, the seq of the previous entry of its device
+ *   action chain   per entry, the seq of the previous entry of its action
+ *   time buckets   (hour, first seq) for every hour that has entries, in
+ *                  seq order, so a Unix time range maps to a seq range by
+ *                  binary search
+ *
+ * Links are sequence numbers, so they need no fix-up when the ring wraps:
+ * a link below the oldest retained seq ends the chain. Entries without a
+ * wall-clock time (logged before NTP sync) are in the chains but in no
+ * bucket. Not thread-safe; Storage calls it under its log lock.
+ */
+
+#ifndef LOG_INDEX_H
+#define LOG_INDEX_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define LOG_BUCKET_SECONDS 3600
+#define LOG_ANY -1                      // LogQuery.device / action wildcard
+
+// Filters of a query; newest matches first, seq < before for paging
+struct LogQuery {
+    int device;                         // LOG_ANY or device index
+    int action;                         // LOG_ANY or ACTION_LOCK / ACTION_UNLOCK
+    uint32_t from;                      // Unix seconds, inclusive (0 = open)
+    uint32_t to;                        // Unix seconds, inclusive (0 = open)
+    uint32_t before;                    // UINT32_MAX = from the newest entry
+
+    bool hasTimeRange() const {
+        return from != 0 || to != 0;
+    }
+};
+
+// How a query was answered
+struct LogQueryStats {
+    uint32_t examined;                  // Entries looked at
+    uint32_t next;                      // Pass as `before` to continue, 0 = done
+    bool chain;                         // Walked a device/action chain, else the seq window
+};
+
+template <int Capacity, int Devices>
+class LogIndex {
+private:
+    struct Bucket {
+        uint32_t hour;                  // unixTime / LOG_BUCKET_SECONDS
+        uint32_t firstSeq;
+    };
+
+    uint32_t prevDevice[Capacity];      // By ring slot
+    uint32_t prevAction[Capacity];
+    uint32_t deviceHead[Devices];       // Newest seq per device, 0 = none
+    uint32_t actionHead[2];
+    uint16_t deviceCount[Devices];      // Retained entries per device
+    uint16_t actionCount[2];
+
+    Bucket buckets[Capacity];           // Ring; an hour needs at least one entry
+    uint32_t bucketNext = 0;            // Total buckets ever added
+
+    static int slotOf(uint32_t seq) {
+        return (seq - 1) % Capacity;
+    }
+
+    // First retained bucket (older ones may still be in the ring)
+    uint32_t bucketFirst() const {
+        return bucketNext > Capacity ? bucketNext - Capacity : 0;
+    }
+
+    const Bucket& bucketAt(uint32_t i) const {
+        return buckets[i % Capacity];
+    }
+
+    // Index of the first bucket with hour > `hour`, or bucketNext
+    uint32_t bucketAfter(uint32_t hour) const {
+        uint32_t lo = bucketFirst(), hi = bucketNext;
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (bucketAt(mid).hour <= hour) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    // Newest node of the chain from `head` below `hi`: follows the chain
+    // down from its head and scans the window down from hi - 1 in
+    // lockstep, whichever gets there first, so a paged query does not pay
+    // for every newer entry of the chain. 0 = none in the window.
+    template <typename Entry>
+    uint32_t chainBelow(const Entry* ring, const uint32_t* links, uint32_t head, uint32_t lo, uint32_t hi,
+                        const LogQuery& q, LogQueryStats* stats) const {
+        uint32_t chain = head, scan = hi - 1;
+        while (chain >= hi) {
+            if (ring[slotOf(chain)].seq != chain) return 0;
+            stats->examined++;
+            chain = links[slotOf(chain)];
+
+            if (scan >= lo && scan != 0) {
+                const Entry& e = ring[slotOf(scan)];
+                stats->examined++;
+                if (links == prevDevice ? e.deviceIndex == q.device : e.action == q.action) return scan;
+                scan--;
+            }
+        }
+        return chain;
+    }
+
+public:
+    void clear() {
+        memset(this, 0, sizeof(*this));
+    }
+
+    // `e` was written to its slot; `evicted` is the entry it replaced (seq 0 = none)
+    template <typename Entry>
+    void add(const Entry& e, const Entry& evicted) {
+        if (evicted.seq != 0) {
+            if (evicted.deviceIndex < Devices && deviceCount[evicted.deviceIndex]) {
+                deviceCount[evicted.deviceIndex]--;
+            }
+            if (evicted.action < 2 && actionCount[evicted.action]) actionCount[evicted.action]--;
+        }
+
+        int slot = slotOf(e.seq);
+        prevDevice[slot] = 0;
+        prevAction[slot] = 0;
+        if (e.deviceIndex < Devices) {
+            prevDevice[slot] = deviceHead[e.deviceIndex];
+            deviceHead[e.deviceIndex] = e.seq;
+            deviceCount[e.deviceIndex]++;
+        }
+        if (e.action < 2) {
+            prevAction[slot] = actionHead[e.action];
+            actionHead[e.action] = e.seq;
+            actionCount[e.action]++;
+        }
+
+        if (e.unixTime != 0) {
+            uint32_t hour = e.unixTime / LOG_BUCKET_SECONDS;
+            // Clock stepped back across an hour: stays in the newer bucket
+            if (bucketNext == 0 || hour > bucketAt(bucketNext - 1).hour) {
+                Bucket& b = buckets[bucketNext % Capacity];
+                b.hour = hour;
+                b.firstSeq = e.seq;
+                bucketNext++;
+            }
+        }
+    }
+
+    // Newest-first matches of `q` among seqs [oldest, next) of `ring`
+    template <typename Entry>
+    int query(const Entry* ring, uint32_t oldest, uint32_t next, const LogQuery& q, Entry* out, int maxOut,
+              LogQueryStats* stats) const {
+        stats->examined = 0;
+        stats->next = 0;
+        stats->chain = false;
+
+        // Seq window [lo, hi) from the time buckets and the paging cursor
+        uint32_t lo = oldest, hi = next;
+        if (q.before < hi) hi = q.before;
+        if (q.hasTimeRange()) {
+            uint32_t fromHour = q.from / LOG_BUCKET_SECONDS;
+            if (fromHour > 0) {
+                uint32_t b = bucketAfter(fromHour - 1);
+                uint32_t seq = b < bucketNext ? bucketAt(b).firstSeq : next;
+                if (seq > lo) lo = seq;
+            }
+            if (q.to != 0) {
+                uint32_t b = bucketAfter(q.to / LOG_BUCKET_SECONDS);
+                if (b < bucketNext && bucketAt(b).firstSeq < hi) hi = bucketAt(b).firstSeq;
+            }
+        }
+        if (lo >= hi) return 0;
+
+        // A chain when it is shorter than the window
+        const uint32_t* links = nullptr;
+        uint32_t seq = hi - 1;
+        if (q.device != LOG_ANY && q.device >= 0 && q.device < Devices) {
+            if (deviceCount[q.device] < hi - lo) {
+                links = prevDevice;
+                seq = deviceHead[q.device];
+            }
+        } else if (q.device != LOG_ANY) {
+            return 0;
+        } else if (q.action == 0 || q.action == 1) {
+            if (actionCount[q.action] < hi - lo) {
+                links = prevAction;
+                seq = actionHead[q.action];
+            }
+        }
+        stats->chain = links != nullptr;
+        if (links && seq >= hi) seq = chainBelow(ring, links, seq, lo, hi, q, stats);
+
+        int n = 0;
+        while (seq >= lo && seq != 0) {
+            const Entry& e = ring[slotOf(seq)];
+            if (e.seq != seq) break;    // Link into an overwritten slot
+            stats->examined++;
+            uint32_t prev = links ? links[slotOf(seq)] : seq - 1;
+
+            bool match = true;
+            if (q.device != LOG_ANY && e.deviceIndex != q.device) match = false;
+            if (q.action != LOG_ANY && e.action != q.action) match = false;
+            if (q.hasTimeRange()) {
+                if (e.unixTime == 0) match = false;
+                if (q.from != 0 && e.unixTime < q.from) match = false;
+                if (q.to != 0 && e.unixTime > q.to) match = false;
+            }
+            if (match) {
+                if (n == maxOut) {
+                    stats->next = seq + 1;
+                    break;
+                }
+                out[n++] = e;
+            }
+            seq = prev;
+        }
+        return n;
+    }
+};
+
+#endif // LOG_INDEX_H
@@ -15,34 +15,56 @@
  */
 
 #include <Arduino.h>
+#include "hal.h"
+#include "EEPROM.h"
+
+#if !HAL_LINUX
 #include <BLEDevice.h>
-#include <BLEScan.h>
-#include <BLEAdvertisedDevice.h>
 #include <BLEServer.h>
 #include <BLEUtils.h>
 #include <BLE2902.h>
 #include <BLEAdvertising.h>
 #include "mbedtls/aes.h"
-#include "esp_task_wdt.h"
 #include "esp_gap_ble_api.h"
 #include "esp_gattc_api.h"
 #include "esp_gatt_defs.h"
 #include "esp_bt_main.h"
 #include "esp_bt_defs.h"
-#include "EEPROM.h"
+#endif
 
 // New modules for Web Dashboard
 #include "storage.h"
 #include "audit_log.h"
+#include "event_stream.h"
+#include "task_config.h"
+#include "metrics.h"
+#include "coex.h"
+#include "trace.h"
+#include "diag.h"
+#include "rpa.h"
+#include "proximity.h"
+#include "rssi_profile.h"
+#include "rssi_series.h"
+#include "config_snapshot.h"
+#include "pipeline.h"
+#include "stress_inject.h"
+
+// Network, pairing and on-target diagnostics: not part of the Linux build
+#if !HAL_LINUX
 #include "wifi_manager.h"
 #include "web_server.h"
+#include "telemetry.h"
+#include "alloc_guard.h"
+#endif
 
 // ========================================
 // CONFIGURATION
 // ========================================
-#define MAX_DEVICES 10
 #define EEPROM_SIZE 512
 #define PAIRING_TIMEOUT_MS 30000  // 30 seconds pairing window
+#define MAX_BOND_DEVICES 15       // CONFIG_BT_SMP_MAX_BONDS default
+#define ROLLUP_TICK_MS 1000       // Ongoing presence credited to the usage rollups
+#define DELETE_PARK_TIMEOUT_MS 1000  // Resolve task to stop before a device delete
 
 // Pin definitions
 const int LED_PIN = 2;
@@ -56,20 +78,12 @@ const int UNLOCK_BUTTON_PIN = 18;
 #define HEART_RATE_SERVICE_UUID     "180D"  // Heart Rate Service (makes it look like fitness tracker)
 #define CHARACTERISTIC_UUID         "2A37"  // Heart Rate Measurement
 
-// Keyless system parameters
-const int SCAN_TIME = 3;
-// Default values - actual values loaded from storage.settings
-unsigned long PROXIMITY_TIMEOUT = 10000;
-int RSSI_UNLOCK_THRESHOLD = -90;  // Öffnen bei schwächerem Signal (größere Reichweite)
-int RSSI_LOCK_THRESHOLD = -80;    // Schließen bei stärkerem Signal (kleinere Reichweite)
+// Keyless system parameters (capacity, scan pass, weak reset: KeylessTraits;
+// thresholds: the keylessConfig snapshot below)
 const unsigned long POWER_OFF_DELAY = 10000;
 const unsigned long UNLOCK_DELAY = 500;
 const unsigned long LOCK_STABILIZATION_DELAY = 10;
 
-// Hysteresis parameters - WEAK_SIGNAL_THRESHOLD loaded from storage.settings
-int WEAK_SIGNAL_THRESHOLD = 3;
-const unsigned long WEAK_SIGNAL_RESET_TIME = 5000;
-
 // ========================================
 // EEPROM STRUCTURE
 // ========================================
@@ -95,9 +109,14 @@ enum SystemMode {
 };
 volatile SystemMode currentMode = MODE_PAIRING;
 
+// Clock, GPIO, BLE scanner, restart and watchdog (ESP32 or Linux, see hal.h)
+Hal hal;
+
 // BLE objects
+#if !HAL_LINUX
 BLEServer* pServer = NULL;
-BLEScan* pBLEScan = NULL;
+#endif
+bool scannerReady = false;
 
 // Pairing state
 bool deviceConnected = false;
@@ -108,10 +127,7 @@ int extractedDeviceCount = 0;
 DeviceEntry knownDevices[MAX_DEVICES];
 int numKnownDevices = 0;
 
-// Keyless system state
-volatile unsigned long lastSeenTime[MAX_DEVICES] = {0};
-volatile bool deviceNearby[MAX_DEVICES] = {false};
-volatile bool anyPhoneNearby = false;
+// Keyless system state (presence per device lives in `proximity`)
 volatile bool keyPowered = false;
 volatile bool lockTriggered = false;
 volatile bool unlockTriggered = false;
@@ -119,13 +135,32 @@ volatile bool pendingLock = false;
 volatile unsigned long keyPowerTime = 0;
 volatile unsigned long lockTriggerTime = 0;
 
-// Hysteresis per device
-struct DeviceHysteresis {
-    volatile int weakSignalCount;
-    volatile unsigned long lastWeakSignalTime;
-    volatile bool isWeak;
-};
-volatile DeviceHysteresis deviceHysteresis[MAX_DEVICES];
+// Presence decisions and weak-signal hysteresis per device (resolve task only)
+ProximityTracker proximity;
+
+// Per-device RSSI sessions; learned profiles live in storage.devices
+ProfileLearner<StoredDevice, KeylessTraits::capacity> profileLearner;
+
+// Recent RSSI per device for the dashboard charts (resolve task writes)
+RssiSeries<MAX_DEVICES> rssiSeries;
+
+// Runtime thresholds: defaults until setup() applies the NVS settings.
+// Unlock at a weaker signal than lock (larger unlock range).
+const ProximityConfig DEFAULT_PROXIMITY_CONFIG = {-90, -80, 10000, 3};
+ConfigSnapshot<ProximityConfig> keylessConfig(DEFAULT_PROXIMITY_CONFIG);
+
+// Any task, lock-free; always a validated, complete set of thresholds
+ProximityConfig proximityConfig() {
+    return keylessConfig.read();
+}
+
+// The only way thresholds change (setup, dashboard): validated as a whole,
+// then published; the resolve task uses it from the next advert on
+const char* applyProximityConfig(const ProximityConfig& cfg) {
+    const char* error = cfg.validate();
+    if (!error) keylessConfig.publish(cfg);
+    return error;
+}
 
 // LED control
 unsigned long lastLedBlink = 0;
@@ -136,32 +171,138 @@ bool ledState = false;
 // ========================================
 Storage storage;
 AuditLog auditLog;
+#if !HAL_LINUX
 WifiManager wifiManager;
 DashboardServer dashboardServer;
+#endif
+EventStream eventStream;
+Rollup rollup;              // Per-device usage aggregates behind /api/stats
+unsigned long lastRollupTick = 0;
+uint32_t rollupSavedHour = 0;   // Wall-clock hour of the last rollup save
 int lastUnlockDevice = -1;  // Track which device triggered last unlock
 
+// Device deletion from the dashboard: every per-device table (resolver,
+// presence, profile sessions, RSSI history, usage) is indexed like
+// storage.devices, so the loop task deletes with the resolve task parked
+// and restarts to rebuild them (deleteRequestedDevice())
+std::atomic<int> deleteRequest{-1};
+std::atomic<bool> resolveParkRequested{false};
+std::atomic<bool> resolveParked{false};
+
+// Network task: queue a delete; false for a bad index or one already queued
+bool requestDeviceDelete(int index) {
+    if (index < 0 || index >= storage.deviceCount) return false;
+    int none = -1;
+    return deleteRequest.compare_exchange_strong(none, index);
+}
+
+bool deviceDeletePending() {
+    return deleteRequest.load() >= 0;
+}
+
+// ========================================
+// TASKS
+// ========================================
+TaskHandle_t netTaskHandle = NULL;
+TaskHandle_t scanTaskHandle = NULL;
+TaskHandle_t resolveTaskHandle = NULL;
+TaskHandle_t diagTaskHandle = NULL;
+TaskHandle_t actTaskHandle = NULL;  // Arduino loop task (stage 3)
+LoopTiming netTiming;        // Gap between web/WiFi service passes
+LoopTiming scanTiming;       // Gap between BLE scan starts
+LoopTiming resolveTiming;    // Gap between resolve passes
+LoopTiming proximityTiming;  // Gap between actuation passes
+
+// ========================================
+// PIPELINE (stage 1 -> 2 -> 3, see pipeline.h)
+// ========================================
+IngestQueue ingestQueue;
+IngestQueue injectQueue;
+DecisionQueue decisionQueue;
+
+// ========================================
+// STRESS INJECTION
+// ========================================
+StressInjector stressInjector;  // Idle unless built with STRESS_INJECT=1
+
+// ========================================
+// METRICS
+// ========================================
+Metrics metrics;
+volatile uint32_t unlockAdvertUs = 0;  // micros() of the advert that caused the unlock
+
+// ========================================
+// RADIO COEXISTENCE
+// ========================================
+CoexScheduler coex;
+
+// ========================================
+// LATENCY TRACING
+// ========================================
+Trace trace;
+DiagLog diag;
+
+// ========================================
+// TELEMETRY
+// ========================================
+#if !HAL_LINUX
+Telemetry telemetry;
+#endif
+
+// ========================================
+// ALLOCATION GUARD
+// ========================================
+#if !HAL_LINUX
+AllocGuard allocGuard;
+#endif
+unsigned long keylessStartTime = 0;  // Ready point = keyless start + ALLOC_GUARD_SETTLE_MS
+
+#if ALLOC_GUARD
+// Linked in with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc (env:esp32dev-allocguard)
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* IRAM_ATTR __wrap_malloc(size_t size) {
+    allocGuard.onAlloc(size, __builtin_return_address(0));
+    return __real_malloc(size);
+}
+
+void* IRAM_ATTR __wrap_calloc(size_t n, size_t size) {
+    allocGuard.onAlloc(n * size, __builtin_return_address(0));
+    return __real_calloc(n, size);
+}
+
+void* IRAM_ATTR __wrap_realloc(void* ptr, size_t size) {
+    allocGuard.onAlloc(size, __builtin_return_address(0));
+    return __real_realloc(ptr, size);
+}
+}
+#endif
+
 // ========================================
 // LED CONTROL FUNCTIONS
 // ========================================
 
 void setLED(bool state) {
-    digitalWrite(LED_PIN, state);
+    hal.digitalWrite(LED_PIN, state);
     ledState = state;
 }
 
 void blinkLED(unsigned long interval) {
-    if (millis() - lastLedBlink >= interval) {
+    if (hal.millis() - lastLedBlink >= interval) {
         setLED(!ledState);
-        lastLedBlink = millis();
+        lastLedBlink = hal.millis();
     }
 }
 
 void blinkPattern(int count, unsigned long onTime, unsigned long offTime) {
     for (int i = 0; i < count; i++) {
         setLED(true);
-        delay(onTime);
+        hal.delay(onTime);
         setLED(false);
-        if (i < count - 1) delay(offTime);
+        if (i < count - 1) hal.delay(offTime);
     }
 }
 
@@ -229,6 +370,16 @@ bool loadDevicesFromEEPROM() {
     return true;
 }
 
+// Legacy array from the NVS device table
+void syncKnownDevices() {
+    numKnownDevices = storage.deviceCount;
+    for (int i = 0; i < numKnownDevices; i++) {
+        memcpy(knownDevices[i].irk, storage.devices[i].irk, 16);
+        strncpy(knownDevices[i].name, storage.devices[i].name, 15);
+        knownDevices[i].name[15] = '\0';
+    }
+}
+
 void addDevice(uint8_t* irk, const char* name) {
     if (numKnownDevices >= MAX_DEVICES) {
         Serial.println("❌ Maximum device limit reached!");
@@ -263,6 +414,7 @@ void addDevice(uint8_t* irk, const char* name) {
 // CRYPTO FUNCTIONS
 // ========================================
 
+#if !HAL_LINUX
 void aes128_ecb_fast(const uint8_t key[16], const uint8_t in[16], uint8_t out[16]) {
     mbedtls_aes_context ctx;
     mbedtls_aes_init(&ctx);
@@ -270,41 +422,21 @@ void aes128_ecb_fast(const uint8_t key[16], const uint8_t in[16], uint8_t out[16
     mbedtls_aes_crypt_ecb(&ctx, MBEDTLS_AES_ENCRYPT, in, out);
     mbedtls_aes_free(&ctx);
 }
+#endif  // Linux: software AES (src/bench/native/aes_soft.cpp)
 
 int verifyRPA(const uint8_t* rpaAddress) {
-    if ((rpaAddress[0] & 0xC0) != 0x40) {
+    if (!isResolvableAddress(rpaAddress)) {
         return -1; // Not a valid RPA
     }
-    
-    uint8_t prand[3] = {rpaAddress[0], rpaAddress[1], rpaAddress[2]};
-    uint8_t rpaHash[3] = {rpaAddress[3], rpaAddress[4], rpaAddress[5]};
-    
-    uint8_t input[16] = {0};
-    input[13] = prand[0];
-    input[14] = prand[1];
-    input[15] = prand[2];
-    
-    for (int deviceIndex = 0; deviceIndex < numKnownDevices; deviceIndex++) {
-        uint8_t aesResult[16];
-        aes128_ecb_fast(knownDevices[deviceIndex].irk, input, aesResult);
-        
-        uint8_t reversedResult[16];
-        for (int i = 0; i < 16; i++) {
-            reversedResult[i] = aesResult[15 - i];
-        }
-        
-        uint8_t computedHash[3] = {reversedResult[0], reversedResult[1], reversedResult[2]};
-        
-        bool matches = (computedHash[0] == rpaHash[2] && 
-                       computedHash[1] == rpaHash[1] && 
-                       computedHash[2] == rpaHash[0]);
-        
-        if (matches) {
-            return deviceIndex;
-        }
-    }
-    
-    return -1;
+    trace.record(TRACE_RPA_START);
+
+    int aesOps = 0;
+    int deviceIndex = RpaResolver<KeylessTraits::capacity>::resolve(rpaAddress, knownDevices, numKnownDevices,
+                                                                    &aesOps);
+    metrics.aesResolutions.inc(aesOps);
+
+    trace.record(TRACE_RPA_END, deviceIndex + 1);
+    return deviceIndex;
 }
 
 // ========================================
@@ -313,67 +445,90 @@ int verifyRPA(const uint8_t* rpaAddress) {
 
 void activateKeyPower() {
     if (!keyPowered) {
-        digitalWrite(KEY_POWER_PIN, HIGH);
+        hal.digitalWrite(KEY_POWER_PIN, HIGH);
+        trace.record(TRACE_KEY_POWER);
         keyPowered = true;
-        keyPowerTime = millis();
-        Serial.println("🔌 Key power activated");
+        keyPowerTime = hal.millis();
+        DIAG_INFO("🔌 Key power activated");
     }
 }
 
 void deactivateKeyPower() {
     if (keyPowered) {
-        digitalWrite(KEY_POWER_PIN, LOW);
+        hal.digitalWrite(KEY_POWER_PIN, LOW);
         keyPowered = false;
-        Serial.println("🔌 Key power deactivated");
+        DIAG_INFO("🔌 Key power deactivated");
     }
 }
 
 void triggerLock() {
-    digitalWrite(LOCK_BUTTON_PIN, HIGH);
-    delay(100);
-    digitalWrite(LOCK_BUTTON_PIN, LOW);
+    hal.digitalWrite(LOCK_BUTTON_PIN, HIGH);
+    trace.record(TRACE_LOCK_EDGE);
+    hal.delay(100);
+    hal.digitalWrite(LOCK_BUTTON_PIN, LOW);
+    metrics.locks.inc();
     lockTriggered = true;
-    lockTriggerTime = millis();
-    Serial.println("🔒 Lock triggered");
+    lockTriggerTime = hal.millis();
+    DIAG_INFO("🔒 Lock triggered");
 
     // Log lock event
     if (lastUnlockDevice >= 0 && lastUnlockDevice < numKnownDevices) {
-        auditLog.logEvent(lastUnlockDevice, ACTION_LOCK, -99);
+        // Last signal heard from the phone before it left (-99 if none)
+        auditLog.logEvent(lastUnlockDevice, ACTION_LOCK, rssiSeries.latest(lastUnlockDevice, -99));
+        eventStream.publishLock(lastUnlockDevice);
     }
 }
 
 void triggerUnlock() {
-    digitalWrite(UNLOCK_BUTTON_PIN, HIGH);
-    delay(100);
-    digitalWrite(UNLOCK_BUTTON_PIN, LOW);
+    hal.digitalWrite(UNLOCK_BUTTON_PIN, HIGH);
+    trace.record(TRACE_UNLOCK_EDGE);
+    metrics.unlocks.inc();
+    metrics.advertToUnlock.observe(hal.micros() - unlockAdvertUs);
+    hal.delay(100);
+    hal.digitalWrite(UNLOCK_BUTTON_PIN, LOW);
     unlockTriggered = true;
-    Serial.println("🔓 Unlock triggered");
+    DIAG_INFO("🔓 Unlock triggered");
 
     // Log unlock event (device and RSSI set by scan callback)
 }
 
-void handleAllPhonesGone(const char* reason) {
-    anyPhoneNearby = false;
+// Resolve task: a device arrived or left (dashboard events and usage time)
+void onPresenceChanged(int device, bool nearby) {
+    DIAG_INFO("📍 %s %s", knownDevices[device].name, nearby ? "nearby" : "left");
+    eventStream.publishPresence(device, nearby);
+    rollup.onPresence(device, nearby, hal.millis(), auditLog.unixNow());
+}
+
+// Resolve task: nobody is nearby any more, start every device over
+void clearAllPresence() {
     for (int i = 0; i < numKnownDevices; i++) {
-        deviceNearby[i] = false;
-        deviceHysteresis[i].weakSignalCount = 0;
-        deviceHysteresis[i].isWeak = false;
+        if (!proximity.isNearby(i)) continue;
+        onPresenceChanged(i, false);
+        profileLearner.onDeparture(i);
     }
-    
+    proximity.clearAll();
+}
+
+// Loop task: presence is already cleared (clearAllPresence())
+void handleAllPhonesGone(const char* reason) {
     setLED(false);
-    Serial.printf("📱 All phones gone (%s)\n", reason);
+    DIAG_INFO("📱 All phones gone (%s)", reason);
     
     if (!lockTriggered && !pendingLock) {
-        lockTriggerTime = millis() + LOCK_STABILIZATION_DELAY;
+        lockTriggerTime = hal.millis() + LOCK_STABILIZATION_DELAY;
         pendingLock = true;
         unlockTriggered = true;
-        Serial.println("🔒 Lock scheduled");
+        DIAG_INFO("🔒 Lock scheduled");
     }
 }
 
 // ========================================
 // BLE PAIRING CLASSES
 // ========================================
+// Pairing needs the real BLE stack: the Linux build starts with paired
+// devices in NVS and only simulates keyless mode
+
+#if !HAL_LINUX
 
 class MyServerCallbacks: public BLEServerCallbacks {
     void onConnect(BLEServer* pServer) {
@@ -387,7 +542,7 @@ class MyServerCallbacks: public BLEServerCallbacks {
     void onDisconnect(BLEServer* pServer) {
         deviceConnected = false;
         Serial.println("=== DEVICE DISCONNECTED ===");
-        delay(500);
+        hal.delay(500);
         if (currentMode == MODE_PAIRING) {
             pServer->startAdvertising();
             Serial.println("🔄 Restarting advertising...");
@@ -435,9 +590,10 @@ class MySecurity : public BLESecurityCallbacks {
             Serial.println();
             
             // Extract IRK
-            int dev_num = esp_ble_get_bond_device_num();
+            // Static list: the stack never holds more than MAX_BOND_DEVICES bonds
+            static esp_ble_bond_dev_t bond_device_list[MAX_BOND_DEVICES];
+            int dev_num = min(esp_ble_get_bond_device_num(), MAX_BOND_DEVICES);
             if (dev_num > 0) {
-                esp_ble_bond_dev_t *bond_device_list = (esp_ble_bond_dev_t *)malloc(sizeof(esp_ble_bond_dev_t) * dev_num);
                 esp_ble_get_bond_device_list(&dev_num, bond_device_list);
                 
                 for (int i = 0; i < dev_num; i++) {
@@ -479,12 +635,11 @@ class MySecurity : public BLESecurityCallbacks {
                         
                         Serial.println("🔑 IRK successfully extracted and saved!");
                         Serial.println("🔄 Restarting ESP32 for clean BLE initialization...");
-                        delay(2000);
-                        ESP.restart(); // Clean restart for proper BLE mode switching
+                        hal.delay(2000);
+                        hal.restart(); // Clean restart for proper BLE mode switching
                         break;
                     }
                 }
-                free(bond_device_list);
             }
         } else {
             Serial.printf("❌ PAIRING FAILED! Reason: %d\n", cmpl.fail_reason);
@@ -493,92 +648,306 @@ class MySecurity : public BLESecurityCallbacks {
         Serial.println("=======================================");
     }
 };
+#endif
 
 // ========================================
-// BLE KEYLESS SCAN CALLBACK
+// PIPELINE STAGE 1: BLE KEYLESS SCAN CALLBACK
 // ========================================
 
-class MyAdvertisedDeviceCallbacks: public BLEAdvertisedDeviceCallbacks {
-    void onResult(BLEAdvertisedDevice advertisedDevice) {
-        if (currentMode != MODE_KEYLESS) return;
-        
-        esp_bd_addr_t* addr = advertisedDevice.getAddress().getNative();
-        
-        if (((*addr)[0] & 0xC0) == 0x40) { // RPA check
-            int matchedDevice = verifyRPA((uint8_t*)(*addr));
-            if (matchedDevice >= 0) {
-                int rssi = advertisedDevice.getRSSI();
-                const char* deviceName = knownDevices[matchedDevice].name;
-                
-                // Check for unlock (more sensitive, longer range)
-                if (rssi > RSSI_UNLOCK_THRESHOLD) {
-                    lastSeenTime[matchedDevice] = millis();
-                    deviceHysteresis[matchedDevice].weakSignalCount = 0;
-                    deviceHysteresis[matchedDevice].isWeak = false;
-                    
-                    bool wasAnyPhoneNearby = anyPhoneNearby;
-                    deviceNearby[matchedDevice] = true;
-                    
-                    // Update overall status
-                    anyPhoneNearby = false;
-                    for (int i = 0; i < numKnownDevices; i++) {
-                        if (deviceNearby[i]) {
-                            anyPhoneNearby = true;
-                            break;
-                        }
-                    }
-                    
-                    // Removed frequent serial output to prevent TX buffer blocking WiFi
-
-                    // Immediate unlock on first strong signal
-                    if (!wasAnyPhoneNearby && anyPhoneNearby) {
-                        setLED(true);
-                        activateKeyPower();
-                        lockTriggered = false;
-                        unlockTriggered = false;
-                        pendingLock = false;
-                        lastUnlockDevice = matchedDevice;  // Track device for logging
-                        auditLog.logEvent(matchedDevice, ACTION_UNLOCK, rssi);  // Log unlock
-                        Serial.println("🔓 Welcome! Activating unlock sequence...");
-                    }
-                } else if (rssi <= RSSI_LOCK_THRESHOLD) {
-                    // Check for lock (less sensitive, shorter range)
-                    // Weak signal hysteresis
-                    if (millis() - deviceHysteresis[matchedDevice].lastWeakSignalTime > WEAK_SIGNAL_RESET_TIME) {
-                        deviceHysteresis[matchedDevice].weakSignalCount = 0;
-                    }
-                    deviceHysteresis[matchedDevice].lastWeakSignalTime = millis();
-                    
-                    if (++deviceHysteresis[matchedDevice].weakSignalCount >= WEAK_SIGNAL_THRESHOLD) {
-                        deviceHysteresis[matchedDevice].isWeak = true;
-                        deviceNearby[matchedDevice] = false;
-                        
-                        // Update overall status
-                        anyPhoneNearby = false;
-                        for (int i = 0; i < numKnownDevices; i++) {
-                            if (deviceNearby[i]) {
-                                anyPhoneNearby = true;
-                                break;
-                            }
-                        }
-                        
-                        // Removed: Serial output blocked WiFi when no monitor connected
+// Every advertising report; allocates nothing and runs no AES. RPA
+// candidates are queued for the resolve task. Each producer task has its
+// own queue (they are single-producer).
+void ingestAdvert(const uint8_t* addr, int rssi, uint32_t entryCycles, IngestQueue& queue, uint8_t flags) {
+    if (currentMode != MODE_KEYLESS) return;
+    uint32_t advertUs = hal.micros();
+    metrics.advertsReceived.inc();
+    coex.onAdvert();
+    if (!isResolvableAddress(addr)) return;
+
+    metrics.rpaCandidates.inc();
+    // Non-RPA adverts are not traced, they would flood the ring
+    trace.recordAt(TRACE_GAP_CB, entryCycles);
+    trace.record(TRACE_PREFILTER);
+
+    IngestItem item;
+    memcpy(item.address, addr, 6);
+    item.rssi = (int8_t)rssi;
+    item.flags = flags;
+    item.advertUs = advertUs;
+    if (!queue.push(item)) {
+        // Resolve task behind: counted by the queue, nothing else to do
+        trace.record(TRACE_QUEUE_DROP);
+        return;
+    }
+    xTaskNotifyGive(resolveTaskHandle);
+}
 
-                        if (!anyPhoneNearby) {
-                            handleAllPhonesGone("weak signal hysteresis");
-                        }
-                    }
-                } else {
-                    // RSSI between -90 and -80: Maintain current state, update last seen time
-                    if (deviceNearby[matchedDevice]) {
-                        lastSeenTime[matchedDevice] = millis();
-                        // Removed: Serial output blocked WiFi when no monitor connected
-                    }
-                }
+// Bluedroid task
+void onAdvert(const uint8_t* addr, int rssi, uint32_t entryCycles) {
+    ingestAdvert(addr, rssi, entryCycles, ingestQueue, 0);
+}
+
+// Stress injector task (stress_inject.h)
+void onInjectedAdvert(const uint8_t* addr, int rssi, uint32_t entryCycles) {
+    ingestAdvert(addr, rssi, entryCycles, injectQueue, INGEST_INJECTED);
+}
+
+// ========================================
+// PIPELINE STAGE 2: RESOLUTION AND DECISIONS
+// ========================================
+
+// Unlock and gone go on to the loop task; presence and RSSI go straight to
+// the event stream (RAM only). Caller guarantees a free decision slot.
+void resolveAdvert(const IngestItem& item, const ProximityConfig& cfg) {
+    trace.record(TRACE_DEQUEUE);
+    int matchedDevice = verifyRPA(item.address);
+    if (matchedDevice < 0) return;
+
+    metrics.deviceMatches[matchedDevice].inc();
+    coex.onSighting();
+    eventStream.publishRssi(matchedDevice, item.rssi);
+
+    // Global thresholds shifted to this phone's learned levels
+    unsigned long now = hal.millis();
+    bool presenceChanged;
+    ProximityDecision decision = proximity.onAdvert(matchedDevice, item.rssi, now,
+                                                    profileLearner.configFor(matchedDevice, cfg), &presenceChanged);
+    if (stressInjector.isRunning()) {
+        // Stress ramp: time the decision, leave pins, log, events and profiles alone
+        stressInjector.onDecision(decision, matchedDevice, item.flags & INGEST_INJECTED);
+        return;
+    }
+    DIAG_DEBUG("📡 %s %d dBm -> %s", knownDevices[matchedDevice].name, item.rssi, PROX_DECISION_NAMES[decision]);
+    if (presenceChanged) onPresenceChanged(matchedDevice, proximity.isNearby(matchedDevice));
+    profileLearner.onSample(matchedDevice, item.rssi, proximity.isNearby(matchedDevice), now);
+    rssiSeries.add(matchedDevice, item.rssi, now);
+
+    switch (decision) {
+        case PROX_UNLOCK:
+        case PROX_NEARBY:
+        case PROX_WEAK:
+            trace.record(TRACE_PROXIMITY, matchedDevice << 8 | decision);
+            break;
+        case PROX_GONE:
+            trace.record(TRACE_PROXIMITY, matchedDevice << 8 | TRACE_DECIDE_WEAK);
+            trace.record(TRACE_PROXIMITY, matchedDevice << 8 | TRACE_DECIDE_GONE);
+            clearAllPresence();
+            break;
+        case PROX_NONE:
+            break;
+    }
+
+    if (decision == PROX_UNLOCK || decision == PROX_GONE) {
+        DecisionItem d = {(uint8_t)matchedDevice, (uint8_t)decision, 0, item.rssi, item.advertUs};
+        decisionQueue.push(d);
+    }
+}
+
+// Weak-count decay and device timeouts; a device whose timeout finds no
+// decision slot is expired on a later pass
+void expirePass(const ProximityConfig& cfg) {
+    unsigned long now = hal.millis();
+    proximity.decayWeakCounters(now);
+
+    for (int i = 0; i < numKnownDevices; i++) {
+        if (decisionQueue.freeSlots() == 0) break;
+        if (!proximity.expire(i, now, cfg)) continue;
+
+        onPresenceChanged(i, false);
+        profileLearner.onDeparture(i);
+        bool gone = !proximity.isAnyNearby();
+        if (gone) {
+            trace.record(TRACE_PROXIMITY, i << 8 | TRACE_DECIDE_GONE);
+            clearAllPresence();
+        }
+        if (stressInjector.isRunning()) continue;
+        DecisionItem d = {(uint8_t)i, (uint8_t)(gone ? PROX_GONE : PROX_NONE), DECISION_TIMEOUT, 0, 0};
+        decisionQueue.push(d);
+    }
+}
+
+// ========================================
+// PIPELINE STAGE 3: ACTUATION
+// ========================================
+
+// Loop task: pins, LED, audit log and lock timing for one decision
+void applyDecision(const DecisionItem& d) {
+    if (d.flags & DECISION_TIMEOUT) DIAG_INFO("📱 %s timeout", knownDevices[d.device].name);
+
+    switch (d.decision) {
+        case PROX_UNLOCK:
+            // Immediate unlock on first strong signal
+            setLED(true);
+            activateKeyPower();
+            lockTriggered = false;
+            unlockTriggered = false;
+            pendingLock = false;
+            lastUnlockDevice = d.device;  // Track device for logging
+            unlockAdvertUs = d.advertUs;
+            auditLog.logEvent(d.device, ACTION_UNLOCK, d.rssi);  // Log unlock
+            eventStream.publishUnlock(d.device, d.rssi);
+            DIAG_INFO("🔓 Welcome! Activating unlock sequence...");
+            break;
+        case PROX_GONE:
+            handleAllPhonesGone((d.flags & DECISION_TIMEOUT) ? "device timeout" : "weak signal hysteresis");
+            break;
+        default:
+            break;
+    }
+}
+
+// ========================================
+// TASK FUNCTIONS
+// ========================================
+
+// Formats deferred diagnostics (diag.h) onto Serial, off every hot path
+void diagTask(void*) {
+    for (;;) {
+        diag.drain();
+        vTaskDelay(pdMS_TO_TICKS(DIAG_DRAIN_PERIOD_MS));
+    }
+}
+
+#if !HAL_LINUX
+// WiFi + web server, pinned to core 0 next to the WiFi/lwIP stack
+void networkTask(void* param) {
+    hal.watchdogAdd();
+
+    for (;;) {
+        hal.watchdogReset();
+        netTiming.tick();
+
+        // While BLE has priority, poll less and hold off NTP/full WiFi scans
+        bool defer = coex.deferNonUrgent();
+        wifiManager.setDeferNonUrgent(defer);
+        wifiManager.update();
+        dashboardServer.handleClient();
+        telemetry.update();
+        allocGuard.update();
+
+        // Serial console: 't' task table, 'a' allocation report, 's' stress ramp
+        if (Serial.available()) {
+            int c = Serial.read();
+            if (c == 't') telemetry.printTasks();
+            else if (c == 'a') allocGuard.printReport();
+            else if (c == 's' && currentMode == MODE_KEYLESS) stressInjector.requestRamp(knownDevices, numKnownDevices);
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(defer ? COEX_DEFERRED_NET_PERIOD_MS : NET_TASK_PERIOD_MS));
+    }
+}
+#endif
+
+// Pipeline stage 2: drains the ingest queue in batches and runs the
+// timeout pass; wakes per queued advert or every PROXIMITY_PERIOD_MS
+void resolveTask(void*) {
+    hal.watchdogAdd();
+    unsigned long lastExpire = 0;
+    IngestItem batch[PIPELINE_BATCH];
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(PROXIMITY_PERIOD_MS));
+        hal.watchdogReset();
+        resolveTiming.tick();
+
+        // A device delete is shifting the device tables; a restart follows
+        if (resolveParkRequested.load()) {
+            resolveParked.store(true);
+            continue;
+        }
+        stressInjector.applyPendingClear();
+
+        uint32_t queuedBefore = decisionQueue.size();
+        for (;;) {
+            // Backpressure: every advert may need a decision slot
+            uint32_t room = decisionQueue.freeSlots();
+            if (room == 0) {
+                metrics.resolveStalls.inc();
+                break;
             }
+            int n = 0;
+            while (n < PIPELINE_BATCH && (uint32_t)n < room && ingestQueue.pop(&batch[n])) n++;
+            while (n < PIPELINE_BATCH && (uint32_t)n < room && injectQueue.pop(&batch[n])) n++;
+            if (n == 0) break;
+            metrics.resolveBatches.inc();
+            // Settings are re-read per advert: a dashboard change applies to the next one
+            for (int i = 0; i < n; i++) resolveAdvert(batch[i], proximityConfig());
+        }
+
+        if (hal.millis() - lastExpire >= PROXIMITY_PERIOD_MS) {
+            lastExpire = hal.millis();
+            expirePass(proximityConfig());
         }
+
+        if (decisionQueue.size() != queuedBefore) xTaskNotifyGive(actTaskHandle);
+        // Stalled: the loop task has to drain decisions first
+        if (decisionQueue.freeSlots() == 0) vTaskDelay(1);
     }
-};
+}
+
+// Blocking BLE scan loop; adverts arrive in onAdvert() (stage 1)
+void scanTask(void*) {
+    hal.watchdogAdd();
+
+    for (;;) {
+        hal.watchdogReset();
+        scanTiming.tick();
+
+        // Scan duty follows the coexistence policy
+        CoexPolicy scanPolicy = coex.getPolicy();
+        const CoexProfile& profile = COEX_PROFILES[scanPolicy];
+
+        uint32_t scanStart = hal.micros();
+        HalScanResult result = hal.scan(profile.scanInterval, profile.scanWindow, KeylessTraits::scanSeconds);
+        if (result == HAL_SCAN_OK) {
+            uint32_t scanUs = hal.micros() - scanStart;
+            metrics.scanCycle.observe(scanUs);
+            coex.onScanCycle(scanPolicy, scanUs);
+        } else {
+            // Nothing to rebuild: the next pass sets the parameters again
+            metrics.scanFailures.inc();
+            DIAG_WARN("⚠️ BLE scan failed (%d), retrying", result);
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(SCAN_RESTART_DELAY_MS));
+    }
+}
+
+// ========================================
+// DEVICE DELETION
+// ========================================
+
+// Loop task: deletes the device the dashboard asked for, then restarts.
+// Learned profiles are saved under the old indices first; the usage
+// rollups shift in RAM as their NVS blobs shift.
+void deleteRequestedDevice() {
+    int index = deleteRequest.load();
+
+    if (resolveTaskHandle) {
+        resolveParkRequested.store(true);
+        xTaskNotifyGive(resolveTaskHandle);
+        unsigned long start = hal.millis();
+        while (!resolveParked.load() && hal.millis() - start < DELETE_PARK_TIMEOUT_MS) hal.delay(10);
+    }
+
+    RssiProfile profile;
+    int profiled;
+    while ((profiled = profileLearner.takeDirty(&profile)) >= 0) storage.saveProfile(profiled, profile);
+
+    rollup.removeDevice(index);
+    storage.deleteDevice(index);
+    // setup() migrates the EEPROM backup whenever NVS has no devices left;
+    // it must not bring the deleted one back
+    syncKnownDevices();
+    saveDevicesToEEPROM();
+    DeviceRollup blob;
+    int rolled;
+    while ((rolled = rollup.takeDirty(&blob)) >= 0) storage.saveRollup(rolled, blob);
+
+    Serial.printf("🗑️ Device %d deleted - restarting to rebuild the device tables\n", index);
+    hal.delay(500);
+    hal.restart();
+}
 
 // ========================================
 // MODE SWITCHING FUNCTIONS
@@ -586,10 +955,13 @@ class MyAdvertisedDeviceCallbacks: public BLEAdvertisedDeviceCallbacks {
 
 void startPairingMode() {
     currentMode = MODE_PAIRING;
-    pairingStartTime = millis();
+    pairingStartTime = hal.millis();
     
     Serial.println("🔵 Starting BLE pairing mode...");
     
+#if HAL_LINUX
+    Serial.println("📱 Pairing is not simulated - waiting out the pairing window");
+#else
     // Initialize BLE for pairing
     BLEDevice::init("ESPKV7 Tracker");
     BLEDevice::setEncryptionLevel(ESP_BLE_SEC_ENCRYPT);
@@ -681,6 +1053,7 @@ void startPairingMode() {
     
     Serial.println("🚀 ESPKV7 Tracker advertising started!");
     Serial.println("📱 Go to iPhone Settings > Bluetooth and look for 'ESPKV7 Tracker' as fitness device");
+#endif
     if (numKnownDevices > 0) {
         Serial.printf("⏱️ 30s window to add more devices (or automatic keyless mode after timeout)\n");
     } else {
@@ -690,54 +1063,54 @@ void startPairingMode() {
 
 void startKeylessMode() {
     currentMode = MODE_KEYLESS;
+    keylessStartTime = hal.millis();
     
     Serial.println("🔐 Starting keyless mode...");
     
+#if !HAL_LINUX
     // Stop advertising if running
     if (pServer) {
         pServer->getAdvertising()->stop();
     }
+#endif
     
+    // Initialize presence and hysteresis, then hand them to the resolve
+    // task before the first advert can be queued
+    proximity.reset(numKnownDevices);
+    profileLearner.begin(storage.devices, numKnownDevices);
+    rssiSeries.begin(numKnownDevices);
+    rollup.begin(numKnownDevices);
+    int restored = 0;
+    for (int i = 0; i < numKnownDevices; i++) {
+        DeviceRollup blob;
+        if (!storage.loadRollup(i, &blob)) continue;
+        rollup.restore(i, blob);
+        restored++;
+    }
+    if (restored) Serial.printf("📊 Usage rollups restored for %d devices\n", restored);
+    actTaskHandle = xTaskGetCurrentTaskHandle();
+    if (!resolveTaskHandle) {
+        xTaskCreatePinnedToCore(resolveTask, "resolve", RESOLVE_TASK_STACK, NULL,
+                                RESOLVE_TASK_PRIORITY, &resolveTaskHandle, RESOLVE_TASK_CORE);
+    }
+
     // Complete BLE shutdown and restart for clean scanner mode
     Serial.println("🔄 Reinitializing BLE stack for scanning...");
-    BLEDevice::deinit(true);
-    delay(2000);  // Extended delay for complete BLE stack cleanup
-    
-    // Restart BLE in scanner mode
-    BLEDevice::init("");
-    delay(500);   // Allow BLE stack to initialize
-    
-    // Setup scanner with robust error handling
-    pBLEScan = BLEDevice::getScan();
-    if (pBLEScan) {
-        Serial.println("📡 Setting up BLE scanner...");
-        pBLEScan->setAdvertisedDeviceCallbacks(new MyAdvertisedDeviceCallbacks());
-        pBLEScan->setActiveScan(false);  // Passive scanning is more reliable
-        
-        // Wait for BLE to be ready, then set parameters
-        delay(1000);
-        
-        // Use very conservative scan parameters to avoid errors
-        pBLEScan->setInterval(1600);  // 1000ms intervals
-        pBLEScan->setWindow(800);     // 500ms windows
-        
-        Serial.println("📡 BLE scanner ready - parameters set successfully");
-    } else {
-        Serial.println("❌ Failed to create BLE scanner");
-    }
+    hal.scannerBegin(onAdvert);
+    scannerReady = true;
+    Serial.println("📡 BLE scanner ready");
     
-    // Initialize hysteresis
-    for (int i = 0; i < numKnownDevices; i++) {
-        deviceHysteresis[i].weakSignalCount = 0;
-        deviceHysteresis[i].lastWeakSignalTime = 0;
-        deviceHysteresis[i].isWeak = false;
-        deviceNearby[i] = false;
-        lastSeenTime[i] = 0;
-    }
+    stressInjector.begin(onInjectedAdvert, &proximity, &proximityTiming, &netTiming);
     
+    // Scanning runs on its own task so proximity checks keep their cadence
+    if (scannerReady && !scanTaskHandle) {
+        xTaskCreatePinnedToCore(scanTask, "bleScan", SCAN_TASK_STACK, NULL,
+                                SCAN_TASK_PRIORITY, &scanTaskHandle, SCAN_TASK_CORE);
+    }
+
     Serial.println("✅ Keyless system ready - monitoring for known devices");
     setLED(true); // Solid LED = keyless mode active
-    delay(2000);
+    hal.delay(2000);
     setLED(false);
 }
 
@@ -747,13 +1120,17 @@ void startKeylessMode() {
 
 void setup() {
     Serial.begin(115200);
-    delay(1000);
+    hal.delay(1000);
 
     Serial.println("=======================================");
     Serial.println("🔵 ESP32 Dynamic Keyless System v7.2");
     Serial.println("    + Web Dashboard");
     Serial.println("=======================================");
 
+    // DIAG_* lines from here on are printed by the drain task
+    xTaskCreatePinnedToCore(diagTask, "diag", DIAG_TASK_STACK, NULL,
+                            DIAG_TASK_PRIORITY, &diagTaskHandle, DIAG_TASK_CORE);
+
     // Initialize EEPROM (for migration)
     EEPROM.begin(EEPROM_SIZE);
 
@@ -762,39 +1139,46 @@ void setup() {
         Serial.println("Failed to initialize NVS storage!");
     }
 
-    // Load settings from NVS and apply to global variables
+    // Load settings from NVS and apply them to the proximity thresholds
     storage.loadSettings();
-    RSSI_UNLOCK_THRESHOLD = storage.settings.rssiUnlockThreshold;
-    RSSI_LOCK_THRESHOLD = storage.settings.rssiLockThreshold;
-    PROXIMITY_TIMEOUT = storage.settings.proximityTimeout * 1000UL;  // Convert to ms
-    WEAK_SIGNAL_THRESHOLD = storage.settings.weakSignalThreshold;
+    const char* settingsError = applyProximityConfig(ProximityConfig::fromSettings(storage.settings));
+    if (settingsError) {
+        Serial.printf("⚠️ Stored settings rejected (%s), using defaults\n", settingsError);
+        storage.settings = DEFAULT_PROXIMITY_CONFIG.toSettings();
+    }
 
     // Initialize pins
-    pinMode(LED_PIN, OUTPUT);
-    pinMode(KEY_POWER_PIN, OUTPUT);
-    pinMode(LOCK_BUTTON_PIN, OUTPUT);
-    pinMode(UNLOCK_BUTTON_PIN, OUTPUT);
+    hal.pinMode(LED_PIN, OUTPUT);
+    hal.pinMode(KEY_POWER_PIN, OUTPUT);
+    hal.pinMode(LOCK_BUTTON_PIN, OUTPUT);
+    hal.pinMode(UNLOCK_BUTTON_PIN, OUTPUT);
 
     setLED(false);
-    digitalWrite(KEY_POWER_PIN, LOW);
-    digitalWrite(LOCK_BUTTON_PIN, LOW);
-    digitalWrite(UNLOCK_BUTTON_PIN, LOW);
+    hal.digitalWrite(KEY_POWER_PIN, LOW);
+    hal.digitalWrite(LOCK_BUTTON_PIN, LOW);
+    hal.digitalWrite(UNLOCK_BUTTON_PIN, LOW);
 
     // Initialize watchdog
-    esp_task_wdt_init(30, true);
-    esp_task_wdt_add(NULL);
+    hal.watchdogBegin(30);
+    hal.watchdogAdd();
     Serial.println("🐕 Watchdog enabled (30s timeout)");
 
     // Check reset reason to avoid endless restart loop
-    esp_reset_reason_t resetReason = esp_reset_reason();
-    Serial.printf("🔍 Reset reason: %d\n", resetReason);
+    HalResetReason resetReason = hal.resetReason();
+    Serial.printf("🔍 Reset reason: %s\n", HAL_RESET_REASON_NAMES[resetReason]);
+#if !HAL_LINUX
+    telemetry.begin();
+#endif
 
     // Initialize Audit Log
     auditLog.begin(&storage);
+    auditLog.setRollup(&rollup);
 
+#if !HAL_LINUX
     // Initialize WiFi Manager
     wifiManager.begin(&auditLog);
     wifiManager.connect();
+#endif
 
     // Load existing devices from NVS first
     bool hasNvsDevices = storage.loadDevices();
@@ -813,12 +1197,7 @@ void setup() {
     } else {
         // Sync NVS devices to legacy array for compatibility
         hasDevices = true;
-        numKnownDevices = storage.deviceCount;
-        for (int i = 0; i < numKnownDevices; i++) {
-            memcpy(knownDevices[i].irk, storage.devices[i].irk, 16);
-            strncpy(knownDevices[i].name, storage.devices[i].name, 15);
-            knownDevices[i].name[15] = '\0';
-        }
+        syncKnownDevices();
         Serial.printf("Loaded %d devices from NVS\n", numKnownDevices);
     }
     
@@ -829,7 +1208,7 @@ void setup() {
         }
         
         // If this is a software reset (from our auto-restart), go directly to keyless mode
-        if (resetReason == ESP_RST_SW) {
+        if (resetReason == HAL_RESET_SOFTWARE) {
             Serial.println("🔐 Software reset detected - starting keyless mode directly...");
             startKeylessMode();
         } else {
@@ -842,9 +1221,15 @@ void setup() {
         startPairingMode();
     }
 
+#if !HAL_LINUX
     // Start Web Dashboard Server
-    dashboardServer.begin(&storage, &auditLog, &wifiManager);
+    dashboardServer.begin(&storage, &auditLog, &wifiManager, &eventStream);
     Serial.println("🌐 Web Dashboard ready");
+
+    // WiFi and web server from here on run on their own task
+    xTaskCreatePinnedToCore(networkTask, "network", NET_TASK_STACK, NULL,
+                            NET_TASK_PRIORITY, &netTaskHandle, NET_TASK_CORE);
+#endif
 }
 
 // ========================================
@@ -852,26 +1237,31 @@ void setup() {
 // ========================================
 
 void loop() {
-    esp_task_wdt_reset();
+    hal.watchdogReset();
+
+    if (deviceDeletePending()) deleteRequestedDevice();
 
-    // Update WiFi and Web Server
-    wifiManager.update();
-    dashboardServer.handleClient();
+    // WiFi and web server are serviced by networkTask
 
     if (currentMode == MODE_PAIRING) {
         // Check pairing timeout - but NOT in AP mode (WiFi setup)
-        if (millis() - pairingStartTime >= PAIRING_TIMEOUT_MS) {
-            Serial.printf("⏱️ Timeout reached. AP Mode: %s\n", wifiManager.isAPMode() ? "YES" : "NO");
-            if (wifiManager.isAPMode()) {
+        if (hal.millis() - pairingStartTime >= PAIRING_TIMEOUT_MS) {
+#if HAL_LINUX
+            bool apMode = false;
+#else
+            bool apMode = wifiManager.isAPMode();
+#endif
+            Serial.printf("⏱️ Timeout reached. AP Mode: %s\n", apMode ? "YES" : "NO");
+            if (apMode) {
                 // Don't restart during WiFi setup - just reset timer silently
-                pairingStartTime = millis();
+                pairingStartTime = hal.millis();
             } else if (numKnownDevices > 0) {
                 Serial.println("⏰ Pairing timeout - restarting ESP32 for clean keyless mode");
-                delay(2000);
-                ESP.restart();
+                hal.delay(2000);
+                hal.restart();
             } else {
                 Serial.println("⏰ Pairing timeout - no devices paired, restarting pairing...");
-                pairingStartTime = millis();
+                pairingStartTime = hal.millis();
             }
         }
         
@@ -883,82 +1273,72 @@ void loop() {
         }
         
     } else { // MODE_KEYLESS
-        // BLE scan for known devices with error handling
-        esp_task_wdt_reset();
-        // Removed frequent serial output to prevent TX buffer blocking WiFi
-
-        BLEScanResults foundDevices;
-        try {
-            foundDevices = pBLEScan->start(SCAN_TIME, false);
-            esp_task_wdt_reset();
-        } catch (...) {
-            Serial.println("⚠️ BLE scan failed, reinitializing scanner...");
-            esp_task_wdt_reset();
-            
-            // Reinitialize scanner on error
-            pBLEScan = BLEDevice::getScan();
-            if (pBLEScan) {
-                pBLEScan->setAdvertisedDeviceCallbacks(new MyAdvertisedDeviceCallbacks());
-                pBLEScan->setActiveScan(false);
-                pBLEScan->setInterval(1600);
-                pBLEScan->setWindow(800);
-                Serial.println("📡 Scanner reinitialized");
-            }
-            foundDevices = BLEScanResults(); // Empty result
+        // Pipeline stage 3: scanning, resolution and presence run on their
+        // own tasks; this loop acts on their decisions and keeps the timing
+        proximityTiming.tick();
+
+#if !HAL_LINUX
+        // Startup allocations are done; from here on the app tasks must not allocate
+        if (!allocGuard.isReady() && hal.millis() - keylessStartTime >= ALLOC_GUARD_SETTLE_MS) {
+            allocGuard.setAppTasks(xTaskGetCurrentTaskHandle(), scanTaskHandle, resolveTaskHandle, diagTaskHandle,
+                                   netTaskHandle);
+            allocGuard.markReady();
         }
-        
-        // Reset weak signal counters if timeout
-        for (int i = 0; i < numKnownDevices; i++) {
-            if (deviceHysteresis[i].weakSignalCount > 0 && 
-                (millis() - deviceHysteresis[i].lastWeakSignalTime > WEAK_SIGNAL_RESET_TIME)) {
-                deviceHysteresis[i].weakSignalCount = 0;
-                deviceHysteresis[i].isWeak = false;
-            }
+#endif
+
+        // Unlocks, departures and timeouts from the resolve task
+        DecisionItem decision;
+        while (decisionQueue.pop(&decision)) applyDecision(decision);
+
+        // Profiles the resolve task updated after a walk-away
+        RssiProfile profile;
+        int profiled;
+        while ((profiled = profileLearner.takeDirty(&profile)) >= 0) {
+            storage.saveProfile(profiled, profile);
+            DIAG_INFO("📶 %s profile: %u sessions, boundary %d dBm", knownDevices[profiled].name,
+                (unsigned)profile.sessions, profile.boundary);
         }
-        
-        // Check device timeouts
-        for (int i = 0; i < numKnownDevices; i++) {
-            if (deviceNearby[i] && (millis() - lastSeenTime[i] > PROXIMITY_TIMEOUT)) {
-                deviceNearby[i] = false;
-                Serial.printf("📱 %s timeout\n", knownDevices[i].name);
-                
-                // Update overall status
-                anyPhoneNearby = false;
-                for (int j = 0; j < numKnownDevices; j++) {
-                    if (deviceNearby[j]) {
-                        anyPhoneNearby = true;
-                        break;
-                    }
-                }
-                
-                if (!anyPhoneNearby) {
-                    handleAllPhonesGone("device timeout");
-                }
+
+        // Usage rollups: ongoing presence every second, changed devices to NVS
+        // once an hour (and at the first NTP sync)
+        if (hal.millis() - lastRollupTick >= ROLLUP_TICK_MS) {
+            lastRollupTick = hal.millis();
+            uint32_t unixNow = auditLog.unixNow();
+            rollup.tick(lastRollupTick, unixNow);
+            if (unixNow / 3600 != rollupSavedHour) {
+                rollupSavedHour = unixNow / 3600;
+                DeviceRollup blob;
+                int rolled;
+                while ((rolled = rollup.takeDirty(&blob)) >= 0) storage.saveRollup(rolled, blob);
             }
         }
+
+        // Radio policy: BLE gets priority while presence is in doubt
+        bool uncertain = proximity.isAnyNearby() && (pendingLock || proximity.hasWeakSignals());
+        coex.update(proximity.isAnyNearby(), uncertain);
         
         // Execute pending lock
-        if (pendingLock && millis() >= lockTriggerTime) {
+        if (pendingLock && hal.millis() >= lockTriggerTime) {
             triggerLock();
             pendingLock = false;
         }
         
         // Trigger unlock after delay
-        if (anyPhoneNearby && keyPowered && !unlockTriggered && 
-            (millis() - keyPowerTime >= UNLOCK_DELAY)) {
+        if (proximity.isAnyNearby() && keyPowered && !unlockTriggered && 
+            (hal.millis() - keyPowerTime >= UNLOCK_DELAY)) {
             triggerUnlock();
         }
         
         // Turn off key power after lock
-        if (lockTriggered && (millis() - lockTriggerTime >= POWER_OFF_DELAY)) {
+        if (lockTriggered && (hal.millis() - lockTriggerTime >= POWER_OFF_DELAY)) {
             deactivateKeyPower();
             lockTriggered = false;
         }
         
         // LED status: ON when phones nearby, OFF when not
-        setLED(anyPhoneNearby);
-        
-        pBLEScan->clearResults();
-        delay(500);
+        setLED(proximity.isAnyNearby());
     }
+
+    // The resolve task wakes us early when it queues a decision
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(PROXIMITY_PERIOD_MS));
 }
@@ -0,0 +1,226 @@
+/*
+ * Metrics Module - Hot-path counters and fixed-bucket histograms
+ * Counters are relaxed atomics (one instruction on the hot path).
+ * Histograms take a short spinlock; all storage is static.
+ * Rendered in Prometheus text format by GET /metrics.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "storage.h"
+
+#define HISTOGRAM_MAX_BUCKETS 10
+
+struct Counter {
+    std::atomic<uint32_t> value{0};
+
+    void inc(uint32_t n = 1) {
+        value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint32_t get() {
+        return value.load(std::memory_order_relaxed);
+    }
+};
+
+// Elapsed time as whole seconds plus the leftover milliseconds, so a
+// *_seconds_total series does not wrap with a uint32_t of milliseconds
+// (49.7 days). One writer task; readers may see the remainder lag.
+struct SecondsCounter {
+    Counter seconds;
+    volatile uint32_t remainderMs = 0;
+
+    void addMs(uint32_t ms) {
+        uint64_t total = (uint64_t)remainderMs + ms;
+        seconds.inc((uint32_t)(total / 1000));
+        remainderMs = (uint32_t)(total % 1000);
+    }
+
+    uint32_t getSeconds() {
+        return seconds.get();
+    }
+
+    uint64_t getMs() {
+        return (uint64_t)seconds.get() * 1000 + remainderMs;
+    }
+};
+
+// Cumulative histogram over microsecond observations
+struct Histogram {
+    const uint32_t* boundsUs;           // Upper bounds, ascending (+Inf implicit)
+    uint8_t bucketCount;
+    uint32_t counts[HISTOGRAM_MAX_BUCKETS + 1];
+    uint64_t sumUs;
+    uint32_t total;
+    portMUX_TYPE mux;
+
+    Histogram(const uint32_t* bounds, uint8_t count)
+        : boundsUs(bounds), bucketCount(count), sumUs(0), total(0) {
+        memset(counts, 0, sizeof(counts));
+        mux = portMUX_INITIALIZER_UNLOCKED;
+    }
+
+    void observe(uint32_t us) {
+        uint8_t i = 0;
+        while (i < bucketCount && us > boundsUs[i]) i++;
+
+        portENTER_CRITICAL(&mux);
+        counts[i]++;
+        sumUs += us;
+        total++;
+        portEXIT_CRITICAL(&mux);
+    }
+
+    void observeMs(uint32_t ms) {
+        observe(ms * 1000UL);
+    }
+};
+
+// Bucket bounds (microseconds)
+static const uint32_t LATENCY_BOUNDS_US[] = {50000, 100000, 250000, 500000, 750000, 1000000, 2000000, 5000000};
+static const uint32_t SCAN_BOUNDS_US[] = {1000000, 2000000, 3000000, 3500000, 4000000, 5000000, 10000000};
+static const uint32_t NVS_BOUNDS_US[] = {500, 1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000};
+static const uint32_t HTTP_BOUNDS_US[] = {1000, 2000, 5000, 10000, 25000, 50000, 100000, 250000, 1000000};
+static const uint32_t WIFI_BOUNDS_US[] = {250000, 500000, 1000000, 2000000, 3000000, 5000000, 10000000, 15000000};
+
+#define BOUNDS(a) a, (uint8_t)(sizeof(a) / sizeof(a[0]))
+
+class Metrics {
+public:
+    // BLE ingestion
+    Counter advertsReceived;
+    Counter rpaCandidates;
+    Counter aesResolutions;
+    Counter scanFailures;
+    Counter deviceMatches[MAX_DEVICES];
+
+    // Pipeline (queue drops and depths are kept by the queues, pipeline.h)
+    Counter resolveBatches;
+    Counter resolveStalls;
+
+    // Actuation
+    Counter unlocks;
+    Counter locks;
+
+    Histogram advertToUnlock{BOUNDS(LATENCY_BOUNDS_US)};
+    Histogram scanCycle{BOUNDS(SCAN_BOUNDS_US)};
+    Histogram nvsWrite{BOUNDS(NVS_BOUNDS_US)};
+    Histogram httpHandler{BOUNDS(HTTP_BOUNDS_US)};
+
+    // WiFi station
+    Histogram wifiConnectFast{BOUNDS(WIFI_BOUNDS_US)};
+    Histogram wifiConnectFull{BOUNDS(WIFI_BOUNDS_US)};
+    Counter wifiFastFallbacks;
+
+    // Deferred diagnostics (diag.h), counted by the drain task
+    Counter diagOverwritten;
+
+    // ========== Prometheus text rendering ==========
+    // Public so other modules (coex.h) can render their own series
+
+    template <typename Sink>
+    static void writeHelp(Sink& out, const char* name, const char* type, const char* help) {
+        char line[160];
+        snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+        out(line);
+    }
+
+    template <typename Sink>
+    static void writeValue(Sink& out, const char* name, const char* labels, uint32_t value) {
+        char line[128];
+        snprintf(line, sizeof(line), "%s%s %lu\n", name, labels, (unsigned long)value);
+        out(line);
+    }
+
+    template <typename Sink>
+    static void writeCounter(Sink& out, const char* name, const char* help, Counter& c) {
+        writeHelp(out, name, "counter", help);
+        writeValue(out, name, "", c.get());
+    }
+
+    template <typename Sink>
+    static void writeGauge(Sink& out, const char* name, const char* help, uint32_t value) {
+        writeHelp(out, name, "gauge", help);
+        writeValue(out, name, "", value);
+    }
+
+    template <typename Sink>
+    static void writeHistogram(Sink& out, const char* name, const char* help, Histogram& h) {
+        uint32_t counts[HISTOGRAM_MAX_BUCKETS + 1];
+        uint64_t sumUs;
+        uint32_t total;
+
+        portENTER_CRITICAL(&h.mux);
+        memcpy(counts, h.counts, sizeof(counts));
+        sumUs = h.sumUs;
+        total = h.total;
+        portEXIT_CRITICAL(&h.mux);
+
+        writeHelp(out, name, "histogram", help);
+
+        char line[128];
+        uint32_t cumulative = 0;
+        for (uint8_t i = 0; i < h.bucketCount; i++) {
+            cumulative += counts[i];
+            snprintf(line, sizeof(line), "%s_bucket{le=\"%g\"} %lu\n",
+                name, h.boundsUs[i] / 1e6, (unsigned long)cumulative);
+            out(line);
+        }
+        snprintf(line, sizeof(line), "%s_bucket{le=\"+Inf\"} %lu\n%s_sum %.6f\n%s_count %lu\n",
+            name, (unsigned long)total, name, sumUs / 1e6, name, (unsigned long)total);
+        out(line);
+    }
+
+public:
+    // Render all metrics; `out` is called with each text fragment.
+    // Task handles may be NULL (task not running).
+    template <typename Sink>
+    void render(Sink& out, int deviceCount, TaskHandle_t* tasks, const char* const* taskNames, int taskCount) {
+        writeCounter(out, "keyless_adverts_received_total", "BLE advertisements seen by the scan callback", advertsReceived);
+        writeCounter(out, "keyless_rpa_candidates_total", "Advertisements with a resolvable private address", rpaCandidates);
+        writeCounter(out, "keyless_aes_resolutions_total", "AES-128 operations spent resolving RPAs", aesResolutions);
+        writeCounter(out, "keyless_scan_failures_total", "BLE scans that failed to start or complete", scanFailures);
+
+        writeHelp(out, "keyless_device_matches_total", "counter", "RPAs resolved to a paired device");
+        for (int i = 0; i < deviceCount && i < MAX_DEVICES; i++) {
+            char labels[16];
+            snprintf(labels, sizeof(labels), "{device=\"%d\"}", i);
+            writeValue(out, "keyless_device_matches_total", labels, deviceMatches[i].get());
+        }
+
+        writeCounter(out, "keyless_resolve_batches_total", "Batches taken from the ingest queue by the resolve task", resolveBatches);
+        writeCounter(out, "keyless_resolve_stalls_total", "Resolve passes stopped by a full decision queue", resolveStalls);
+
+        writeCounter(out, "keyless_unlocks_total", "Unlock pulses sent", unlocks);
+        writeCounter(out, "keyless_locks_total", "Lock pulses sent", locks);
+
+        writeHistogram(out, "keyless_advert_to_unlock_seconds", "Time from triggering advertisement to unlock pulse", advertToUnlock);
+        writeHistogram(out, "keyless_scan_cycle_seconds", "Duration of one BLE scan cycle", scanCycle);
+        writeHistogram(out, "keyless_nvs_write_seconds", "Duration of NVS log writes", nvsWrite);
+        writeHistogram(out, "keyless_http_handler_seconds", "Duration of API handlers", httpHandler);
+        writeHistogram(out, "keyless_wifi_connect_fast_seconds", "WiFi connect time via cached BSSID/channel/IP", wifiConnectFast);
+        writeHistogram(out, "keyless_wifi_connect_full_seconds", "WiFi connect time via full scan and DHCP", wifiConnectFull);
+        writeCounter(out, "keyless_wifi_fast_connect_failures_total", "Fast-path connect attempts that timed out", wifiFastFallbacks);
+        writeCounter(out, "keyless_diag_overwritten_total", "Diagnostic records overwritten before the drain task read them", diagOverwritten);
+
+        writeGauge(out, "keyless_free_heap_bytes", "Free heap", ESP.getFreeHeap());
+        writeGauge(out, "keyless_min_free_heap_bytes", "Lowest free heap since boot", ESP.getMinFreeHeap());
+        writeGauge(out, "keyless_largest_free_block_bytes", "Largest allocatable heap block", ESP.getMaxAllocHeap());
+        writeGauge(out, "keyless_uptime_seconds", "Time since boot", millis() / 1000);
+
+        writeHelp(out, "keyless_task_stack_free_bytes", "gauge", "Task stack high-water mark (minimum free stack)");
+        for (int i = 0; i < taskCount; i++) {
+            if (!tasks[i]) continue;
+            char labels[32];
+            snprintf(labels, sizeof(labels), "{task=\"%s\"}", taskNames[i]);
+            writeValue(out, "keyless_task_stack_free_bytes", labels, uxTaskGetStackHighWaterMark(tasks[i]));
+        }
+    }
+};
+
+extern Metrics metrics;
+
+#endif // METRICS_H
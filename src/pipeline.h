@@ -0,0 +1,125 @@
+/*
+ * Pipeline Module - Bounded queues between the keyless stages
+ *
+ *   stage 1  ingest   scan callback (Bluedroid, core 0): counters, RPA
+ *                     pre-filter, push to the ingest queue. Full queue:
+ *                     the advert is dropped and counted.
+ *   stage 2  resolve  resolve task (core 1): pops up to PIPELINE_BATCH
+ *                     adverts per pass, RPA resolution and the proximity
+ *                     decision, plus the timeout pass. Owns all proximity
+ *                     state. Pushes unlock/gone/timeout to the decision
+ *                     queue and only takes an advert while it has room
+ *                     (backpressure: the ingest queue fills and drops).
+ *   stage 3  act      Arduino loop task (core 1): key power, pins, LED,
+ *                     audit log and lock timing
+ *
+ * SpscQueue is a lock-free ring for one producer and one consumer task;
+ * portable (the native bench drives it in --stress-ramp). The stress
+ * injector (stress_inject.h) is a second stage 1 producer, so it has its
+ * own queue, which the resolve task drains alongside the radio's.
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdint.h>
+#include <atomic>
+
+#define PIPELINE_INGEST_DEPTH 64        // ~20 ms of a crowded car park's RPAs
+#define PIPELINE_DECISION_DEPTH 16
+#define PIPELINE_BATCH 8                // Adverts per resolve pass before the queues are re-checked
+
+// IngestItem.flags
+#define INGEST_INJECTED 0x01            // From the stress injector task, not the radio
+
+// DecisionItem.flags
+#define DECISION_TIMEOUT 0x01           // From the timeout pass, not an advert
+
+struct IngestItem {
+    uint8_t address[6];
+    int8_t rssi;
+    uint8_t flags;
+    uint32_t advertUs;                  // hal.micros() at callback entry
+};
+
+struct DecisionItem {
+    uint8_t device;
+    uint8_t decision;                   // ProximityDecision
+    uint8_t flags;
+    int8_t rssi;
+    uint32_t advertUs;                  // Of the deciding advert
+};
+
+template <typename T, uint32_t Depth>
+class SpscQueue {
+private:
+    static_assert(Depth >= 2 && (Depth & (Depth - 1)) == 0, "queue depth must be a power of two");
+
+    T slots[Depth];
+    std::atomic<uint32_t> head{0};      // Next pop, written by the consumer
+    std::atomic<uint32_t> tail{0};      // Next push, written by the producer
+    std::atomic<uint32_t> dropped{0};
+    std::atomic<uint32_t> highWater{0};
+
+public:
+    // Producer. False (and counted as dropped) when full.
+    bool push(const T& item) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        uint32_t used = t - head.load(std::memory_order_acquire);
+        if (used >= Depth) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        slots[t & (Depth - 1)] = item;
+        tail.store(t + 1, std::memory_order_release);
+        if (used + 1 > highWater.load(std::memory_order_relaxed)) {
+            highWater.store(used + 1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    // Consumer
+    bool pop(T* out) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        *out = slots[h & (Depth - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Exact for the producer (space only grows behind its back)
+    uint32_t freeSlots() {
+        return Depth - (tail.load(std::memory_order_relaxed) - head.load(std::memory_order_acquire));
+    }
+
+    uint32_t size() {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    // Only while neither side is running (mode switch, bench setup)
+    void clear() {
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+    }
+
+    uint32_t getDropped() {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+    uint32_t getHighWater() {
+        return highWater.load(std::memory_order_relaxed);
+    }
+
+    static uint32_t depth() {
+        return Depth;
+    }
+};
+
+typedef SpscQueue<IngestItem, PIPELINE_INGEST_DEPTH> IngestQueue;
+typedef SpscQueue<DecisionItem, PIPELINE_DECISION_DEPTH> DecisionQueue;
+
+extern IngestQueue ingestQueue;
+extern IngestQueue injectQueue;         // Stress injector task only (STRESS_INJECT builds)
+extern DecisionQueue decisionQueue;
+
+#endif // PIPELINE_H
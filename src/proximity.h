@@ -0,0 +1,181 @@
+/*
+ * Proximity Module - Per-device presence decisions from RSSI
+ * Pure state machine: no I/O, the caller applies the side effects
+ * (LED, key power, audit log, event stream). Shared by the scan callback,
+ * the proximity loop and the native benchmark build.
+ *
+ *   rssi >  unlockRssi   strong: device nearby, weak counter cleared
+ *   rssi <= lockRssi     weak: counted, weakThreshold in a row -> not nearby
+ *   in between           keeps a nearby device alive, otherwise ignored
+ *
+ * Weak counts older than Traits::weakResetMs start over; a nearby device
+ * not seen for timeoutMs times out. RSSI passes through Traits::RssiFilter
+ * first. Tables are sized by Traits::capacity and the per-pass loops run
+ * over the whole table (unused slots stay clear), so their bounds are
+ * compile-time constants.
+ */
+
+#ifndef PROXIMITY_H
+#define PROXIMITY_H
+
+#include <Arduino.h>
+#include "keyless_config.h"
+
+// Values match TraceDecision so they can be traced directly
+enum ProximityDecision {
+    PROX_NONE = 0,          // Mid-range signal from a device that is not nearby
+    PROX_UNLOCK = 1,        // First strong signal while nobody was nearby
+    PROX_NEARBY = 2,        // Strong/mid signal, overall state unchanged
+    PROX_WEAK = 3,          // Weak signal counted
+    PROX_GONE = 4           // Weak hysteresis or timeout left nobody nearby
+};
+
+static const char* const PROX_DECISION_NAMES[] = {"none", "unlock", "nearby", "weak", "gone"};
+
+template <typename Traits>
+class ProximityEngine {
+private:
+    static const int capacity = Traits::capacity;
+    typedef typename Traits::RssiFilter Filter;
+
+    struct Hysteresis {
+        volatile int weakSignalCount;
+        volatile unsigned long lastWeakSignalTime;
+        volatile bool isWeak;
+    };
+
+    volatile unsigned long lastSeenTime[capacity];
+    volatile bool deviceNearby[capacity];
+    Hysteresis hysteresis[capacity];
+    typename Filter::State filter[capacity];
+    volatile bool anyNearby = false;
+    int deviceCount = 0;
+
+    void updateAnyNearby() {
+        bool any = false;
+        for (int i = 0; i < capacity; i++) {
+            if (deviceNearby[i]) {
+                any = true;
+                break;
+            }
+        }
+        anyNearby = any;
+    }
+
+public:
+    ProximityEngine() {
+        reset(0);
+    }
+
+    // Forget all state and track `count` devices
+    void reset(int count) {
+        deviceCount = count < capacity ? count : capacity;
+        for (int i = 0; i < capacity; i++) {
+            hysteresis[i].weakSignalCount = 0;
+            hysteresis[i].lastWeakSignalTime = 0;
+            hysteresis[i].isWeak = false;
+            deviceNearby[i] = false;
+            lastSeenTime[i] = 0;
+            Filter::reset(filter[i]);
+        }
+        anyNearby = false;
+    }
+
+    // Advert from a resolved device. `presenceChanged` is set when the
+    // device's nearby flag flipped (see isNearby()).
+    ProximityDecision onAdvert(int device, int rssi, unsigned long now, const ProximityConfig& cfg,
+                               bool* presenceChanged) {
+        *presenceChanged = false;
+        rssi = Filter::apply(filter[device], rssi);
+
+        if (rssi > cfg.unlockRssi) {
+            // Strong signal (more sensitive, longer range)
+            lastSeenTime[device] = now;
+            hysteresis[device].weakSignalCount = 0;
+            hysteresis[device].isWeak = false;
+
+            bool wasAnyNearby = anyNearby;
+            *presenceChanged = !deviceNearby[device];
+            deviceNearby[device] = true;
+            anyNearby = true;
+
+            return wasAnyNearby ? PROX_NEARBY : PROX_UNLOCK;
+        }
+
+        if (rssi <= cfg.lockRssi) {
+            // Weak signal (less sensitive, shorter range) with hysteresis
+            Hysteresis& h = hysteresis[device];
+            if (now - h.lastWeakSignalTime > Traits::weakResetMs) {
+                h.weakSignalCount = 0;
+            }
+            h.lastWeakSignalTime = now;
+
+            if (++h.weakSignalCount < cfg.weakThreshold) return PROX_WEAK;
+
+            h.isWeak = true;
+            *presenceChanged = deviceNearby[device];
+            deviceNearby[device] = false;
+            updateAnyNearby();
+            return anyNearby ? PROX_WEAK : PROX_GONE;
+        }
+
+        // Between the thresholds: maintain current state
+        if (!deviceNearby[device]) return PROX_NONE;
+        lastSeenTime[device] = now;
+        return PROX_NEARBY;
+    }
+
+    // Clear weak counts that were not continued within Traits::weakResetMs
+    void decayWeakCounters(unsigned long now) {
+        for (int i = 0; i < capacity; i++) {
+            if (hysteresis[i].weakSignalCount > 0 &&
+                (now - hysteresis[i].lastWeakSignalTime > Traits::weakResetMs)) {
+                hysteresis[i].weakSignalCount = 0;
+                hysteresis[i].isWeak = false;
+            }
+        }
+    }
+
+    // True when a nearby device was just timed out
+    bool expire(int device, unsigned long now, const ProximityConfig& cfg) {
+        if (!deviceNearby[device] || now - lastSeenTime[device] <= cfg.timeoutMs) return false;
+        deviceNearby[device] = false;
+        updateAnyNearby();
+        return true;
+    }
+
+    // Everyone gone: clear presence and hysteresis
+    void clearAll() {
+        for (int i = 0; i < capacity; i++) {
+            deviceNearby[i] = false;
+            hysteresis[i].weakSignalCount = 0;
+            hysteresis[i].isWeak = false;
+        }
+        anyNearby = false;
+    }
+
+    // Any nearby device currently counting weak signals
+    bool hasWeakSignals() {
+        for (int i = 0; i < capacity; i++) {
+            if (hysteresis[i].weakSignalCount > 0) return true;
+        }
+        return false;
+    }
+
+    bool isNearby(int device) {
+        return deviceNearby[device];
+    }
+
+    bool isAnyNearby() {
+        return anyNearby;
+    }
+
+    int getDeviceCount() {
+        return deviceCount;
+    }
+};
+
+// The firmware's engine
+typedef ProximityEngine<KeylessTraits> ProximityTracker;
+
+#endif // PROXIMITY_H
@@ -0,0 +1,329 @@
+/*
+ * Rollup Module - Incremental per-device usage aggregates
+ * Every unlock, lock and presence change updates one bucket in each tier
+ * as it happens (write-through), so /api/stats only copies buckets:
+ *
+ *   tier   bucket   kept        per device
+ *   hour   1 h      24 h        144 bytes
+ *   day    1 day    14 days     168 bytes
+ *   week   1 week   26 weeks    312 bytes
+ *
+ * Old data is downsampled by retention alone: an hour that falls out of
+ * the hour ring is still counted in its day and week. Buckets are in UTC
+ * (weeks start on Monday) and hold presence seconds, unlocks, locks and the
+ * RSSI sum of the unlocks (arrival RSSI average = sum / unlocks).
+ *
+ * Presence is credited while it lasts (tick(), once a second) and when it
+ * ends. Events before the first NTP sync have no hour to go to; they
+ * collect per device and are added to the current buckets at the sync.
+ * DeviceRollup is the NVS blob ("roll<n>"), written hourly for devices
+ * that changed. Portable: no I/O.
+ */
+
+#ifndef ROLLUP_H
+#define ROLLUP_H
+
+#include <Arduino.h>
+#include "keyless_config.h"
+
+#define ROLLUP_HOURS 24
+#define ROLLUP_DAYS 14
+#define ROLLUP_WEEKS 26
+
+enum RollupTier {
+    ROLLUP_HOUR,
+    ROLLUP_DAY,
+    ROLLUP_WEEK
+};
+
+struct RollupHourBucket {
+    uint16_t presenceS;
+    uint8_t unlocks;                    // Saturates at 255 (RSSI sum stops with it)
+    uint8_t locks;
+    int16_t rssiSum;
+};
+
+struct RollupBucket {
+    uint32_t presenceS;
+    uint16_t unlocks;
+    uint16_t locks;
+    int32_t rssiSum;
+};
+
+// One device, all tiers; slot = period % ring size, `latest*` is the
+// newest period (hours/days/weeks since the epoch) the ring holds
+struct DeviceRollup {
+    uint32_t latestHour;
+    uint32_t latestDay;
+    uint32_t latestWeek;
+    RollupHourBucket hours[ROLLUP_HOURS];
+    RollupBucket days[ROLLUP_DAYS];
+    RollupBucket weeks[ROLLUP_WEEKS];
+};
+
+// A tier's buckets for one device, oldest first, ending at the current period
+struct RollupSeries {
+    uint32_t firstStart;                // Unix time of buckets[0]
+    uint32_t step;                      // Seconds per bucket
+    int count;
+    RollupBucket buckets[ROLLUP_WEEKS];
+};
+
+static_assert(ROLLUP_WEEKS >= ROLLUP_HOURS && ROLLUP_WEEKS >= ROLLUP_DAYS, "RollupSeries holds the longest tier");
+
+template <int Capacity>
+class UsageRollup {
+private:
+    DeviceRollup devices[Capacity];
+    RollupBucket pending[Capacity];     // Before the first NTP sync
+    bool hasPending = false;
+    uint32_t presentSinceMs[Capacity];  // Presence not yet credited
+    bool present[Capacity];
+    bool dirty[Capacity];
+    int deviceCount = 0;
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+
+    static uint32_t hourOf(uint32_t unixTime) {
+        return unixTime / 3600;
+    }
+
+    static uint32_t dayOf(uint32_t unixTime) {
+        return unixTime / 86400;
+    }
+
+    // 1970-01-01 was a Thursday; weeks start on Monday
+    static uint32_t weekOf(uint32_t unixTime) {
+        return (unixTime / 86400 + 3) / 7;
+    }
+
+    static uint32_t weekStart(uint32_t week) {
+        return (week * 7 - 3) * 86400;
+    }
+
+    // Ring slot for `period`, clearing the ones skipped; nullptr if too old
+    template <typename Bucket, int N>
+    static Bucket* slot(Bucket (&ring)[N], uint32_t& latest, uint32_t period) {
+        if (period > latest) {
+            if (latest == 0 || period - latest >= (uint32_t)N) {
+                memset(ring, 0, sizeof(ring));
+            } else {
+                for (uint32_t p = latest + 1; p <= period; p++) memset(&ring[p % N], 0, sizeof(Bucket));
+            }
+            latest = period;
+        } else if (latest - period >= (uint32_t)N) {
+            return nullptr;
+        }
+        return &ring[period % N];
+    }
+
+    static void addTo(RollupBucket* b, const RollupBucket& delta) {
+        if (!b) return;
+        b->presenceS += delta.presenceS;
+        b->unlocks += delta.unlocks;
+        b->locks += delta.locks;
+        b->rssiSum += delta.rssiSum;
+    }
+
+    // Caller holds mux
+    void add(int device, const RollupBucket& delta, uint32_t unixTime) {
+        if (unixTime == 0) {
+            addTo(&pending[device], delta);
+            hasPending = true;
+            return;
+        }
+        DeviceRollup& r = devices[device];
+        RollupHourBucket* h = slot(r.hours, r.latestHour, hourOf(unixTime));
+        if (h) {
+            uint32_t presence = h->presenceS + delta.presenceS;
+            h->presenceS = presence > 3600 ? 3600 : presence;
+            if (h->unlocks + delta.unlocks <= 255) {
+                h->unlocks += delta.unlocks;
+                h->rssiSum += delta.rssiSum;
+            }
+            if (h->locks + delta.locks <= 255) h->locks += delta.locks;
+        }
+        addTo(slot(r.days, r.latestDay, dayOf(unixTime)), delta);
+        addTo(slot(r.weeks, r.latestWeek, weekOf(unixTime)), delta);
+        dirty[device] = true;
+    }
+
+    // Caller holds mux
+    void creditPresence(int device, uint32_t nowMs, uint32_t unixTime) {
+        if (!present[device]) return;
+        uint32_t seconds = (nowMs - presentSinceMs[device]) / 1000;
+        if (seconds == 0) return;
+        presentSinceMs[device] += seconds * 1000;
+        RollupBucket delta = {seconds, 0, 0, 0};
+        add(device, delta, unixTime);
+    }
+
+    template <typename Bucket, int N>
+    static void series(const Bucket (&ring)[N], uint32_t latest, uint32_t current, RollupSeries* out) {
+        out->count = N;
+        for (int k = 0; k < N; k++) {
+            uint32_t period = current - (N - 1) + k;
+            RollupBucket& b = out->buckets[k];
+            memset(&b, 0, sizeof(b));
+            if (latest == 0 || period > latest || latest - period >= (uint32_t)N) continue;
+            const Bucket& src = ring[period % N];
+            b.presenceS = src.presenceS;
+            b.unlocks = src.unlocks;
+            b.locks = src.locks;
+            b.rssiSum = src.rssiSum;
+        }
+    }
+
+public:
+    void begin(int count) {
+        portENTER_CRITICAL(&mux);
+        deviceCount = count < Capacity ? count : Capacity;
+        memset(devices, 0, sizeof(devices));
+        memset(pending, 0, sizeof(pending));
+        memset(present, 0, sizeof(present));
+        memset(dirty, 0, sizeof(dirty));
+        hasPending = false;
+        portEXIT_CRITICAL(&mux);
+    }
+
+    // Boot: a device's persisted blob (Storage::loadRollup)
+    void restore(int device, const DeviceRollup& saved) {
+        if (device < 0 || device >= deviceCount) return;
+        portENTER_CRITICAL(&mux);
+        devices[device] = saved;
+        portEXIT_CRITICAL(&mux);
+    }
+
+    // A device was deleted: the later ones move down a slot, as
+    // Storage::deleteDevice does with their "roll<n>" blobs
+    void removeDevice(int device) {
+        if (device < 0 || device >= deviceCount) return;
+        portENTER_CRITICAL(&mux);
+        for (int i = device; i < deviceCount - 1; i++) {
+            devices[i] = devices[i + 1];
+            pending[i] = pending[i + 1];
+            presentSinceMs[i] = presentSinceMs[i + 1];
+            present[i] = present[i + 1];
+            dirty[i] = dirty[i + 1];
+        }
+        deviceCount--;
+        memset(&devices[deviceCount], 0, sizeof(DeviceRollup));
+        memset(&pending[deviceCount], 0, sizeof(RollupBucket));
+        present[deviceCount] = false;
+        dirty[deviceCount] = false;
+        portEXIT_CRITICAL(&mux);
+    }
+
+    // ========== Events (any task) ==========
+
+    void onUnlock(int device, int rssi, uint32_t unixTime) {
+        if (device < 0 || device >= deviceCount) return;
+        RollupBucket delta = {0, 1, 0, rssi};
+        portENTER_CRITICAL(&mux);
+        add(device, delta, unixTime);
+        portEXIT_CRITICAL(&mux);
+    }
+
+    void onLock(int device, uint32_t unixTime) {
+        if (device < 0 || device >= deviceCount) return;
+        RollupBucket delta = {0, 0, 1, 0};
+        portENTER_CRITICAL(&mux);
+        add(device, delta, unixTime);
+        portEXIT_CRITICAL(&mux);
+    }
+
+    void onPresence(int device, bool nearby, uint32_t nowMs, uint32_t unixTime) {
+        if (device < 0 || device >= deviceCount) return;
+        portENTER_CRITICAL(&mux);
+        if (nearby && !present[device]) {
+            present[device] = true;
+            presentSinceMs[device] = nowMs;
+        } else if (!nearby && present[device]) {
+            creditPresence(device, nowMs, unixTime);
+            present[device] = false;
+        }
+        portEXIT_CRITICAL(&mux);
+    }
+
+    // Loop task, about once a second: credits ongoing presence and hands
+    // pre-sync totals to the clock once it is known
+    void tick(uint32_t nowMs, uint32_t unixTime) {
+        portENTER_CRITICAL(&mux);
+        for (int i = 0; i < deviceCount; i++) creditPresence(i, nowMs, unixTime);
+        if (hasPending && unixTime != 0) {
+            for (int i = 0; i < deviceCount; i++) {
+                const RollupBucket& p = pending[i];
+                if (p.presenceS || p.unlocks || p.locks) add(i, p, unixTime);
+                memset(&pending[i], 0, sizeof(pending[i]));
+            }
+            hasPending = false;
+        }
+        portEXIT_CRITICAL(&mux);
+    }
+
+    // ========== Readers ==========
+
+    // Copy of the next device blob changed since the last call; -1 if none
+    int takeDirty(DeviceRollup* out) {
+        int found = -1;
+        portENTER_CRITICAL(&mux);
+        for (int i = 0; i < deviceCount && found < 0; i++) {
+            if (!dirty[i]) continue;
+            dirty[i] = false;
+            *out = devices[i];
+            found = i;
+        }
+        portEXIT_CRITICAL(&mux);
+        return found;
+    }
+
+    // `tier` buckets of `device` up to the period containing `unixTime`
+    // (0 = the device's newest period); false if there is neither. O(buckets).
+    bool getSeries(int device, RollupTier tier, uint32_t unixTime, RollupSeries* out) {
+        if (device < 0 || device >= deviceCount) return false;
+        portENTER_CRITICAL(&mux);
+        const DeviceRollup& r = devices[device];
+        if (unixTime == 0 && r.latestWeek == 0) {
+            portEXIT_CRITICAL(&mux);
+            return false;
+        }
+        switch (tier) {
+            case ROLLUP_HOUR: {
+                uint32_t current = unixTime ? hourOf(unixTime) : r.latestHour;
+                series(r.hours, r.latestHour, current, out);
+                out->step = 3600;
+                out->firstStart = (current - (ROLLUP_HOURS - 1)) * 3600;
+                break;
+            }
+            case ROLLUP_DAY: {
+                uint32_t current = unixTime ? dayOf(unixTime) : r.latestDay;
+                series(r.days, r.latestDay, current, out);
+                out->step = 86400;
+                out->firstStart = (current - (ROLLUP_DAYS - 1)) * 86400;
+                break;
+            }
+            case ROLLUP_WEEK: {
+                uint32_t current = unixTime ? weekOf(unixTime) : r.latestWeek;
+                series(r.weeks, r.latestWeek, current, out);
+                out->step = 7 * 86400;
+                out->firstStart = weekStart(current - (ROLLUP_WEEKS - 1));
+                break;
+            }
+        }
+        portEXIT_CRITICAL(&mux);
+        return true;
+    }
+
+    // Totals collected before the first NTP sync of this boot
+    RollupBucket getPending(int device) {
+        RollupBucket b = {0, 0, 0, 0};
+        if (device < 0 || device >= deviceCount) return b;
+        portENTER_CRITICAL(&mux);
+        b = pending[device];
+        portEXIT_CRITICAL(&mux);
+        return b;
+    }
+};
+
+typedef UsageRollup<MAX_DEVICES> Rollup;
+
+#endif // ROLLUP_H
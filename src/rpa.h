@@ -0,0 +1,126 @@
+/*
+ * RPA Resolution - Match a Resolvable Private Address against known IRKs
+ * Portable (no ESP-IDF dependency): the AES-128 block function is provided
+ * by the platform, mbedtls on the ESP32 (main.cpp), a software AES in the
+ * native benchmark and Linux simulator builds.
+ *
+ * RPA (MSB first): prand[3] (top bits 01) | hash[3]
+ * Resolved when ah(IRK, prand) = AES-128(IRK, 0^104 || prand)[LSB 3 bytes] == hash
+ */
+
+#ifndef RPA_H
+#define RPA_H
+
+#include <stdint.h>
+
+// Platform AES-128 ECB encrypt of one block
+void aes128_ecb_fast(const uint8_t key[16], const uint8_t in[16], uint8_t out[16]);
+
+inline bool isResolvableAddress(const uint8_t* address) {
+    return (address[0] & 0xC0) == 0x40;
+}
+
+// Returns the index of the first device whose IRK resolves the address,
+// or -1. `aesOps` (optional) receives the number of AES blocks computed.
+// Device only needs an `irk[16]` member (DeviceEntry, StoredDevice).
+template <typename Device>
+int resolveRPA(const uint8_t* rpaAddress, const Device* devices, int deviceCount, int* aesOps = nullptr) {
+    if (aesOps) *aesOps = 0;
+    if (!isResolvableAddress(rpaAddress)) {
+        return -1; // Not a valid RPA
+    }
+
+    uint8_t input[16] = {0};
+    input[13] = rpaAddress[0];
+    input[14] = rpaAddress[1];
+    input[15] = rpaAddress[2];
+
+    for (int deviceIndex = 0; deviceIndex < deviceCount; deviceIndex++) {
+        uint8_t aesResult[16];
+        aes128_ecb_fast(devices[deviceIndex].irk, input, aesResult);
+        if (aesOps) (*aesOps)++;
+
+        // Hash is the least significant 3 bytes of the (big-endian) result
+        if (aesResult[13] == rpaAddress[3] &&
+            aesResult[14] == rpaAddress[4] &&
+            aesResult[15] == rpaAddress[5]) {
+            return deviceIndex;
+        }
+    }
+
+    return -1;
+}
+
+// ========== Fixed-capacity resolver ==========
+
+#define RPA_UNROLL_MAX 16   // Larger tables loop; unrolling only grows flash
+
+// One device of an unrolled table walk; Index == End stops the recursion
+template <int Index, int End>
+struct RpaUnrolled {
+    template <typename Device>
+    static int resolve(const uint8_t* input, const uint8_t* hash, const Device* devices, int deviceCount,
+                       int* aesOps) {
+        if (Index >= deviceCount) return -1;
+        uint8_t aesResult[16];
+        aes128_ecb_fast(devices[Index].irk, input, aesResult);
+        (*aesOps)++;
+        if (aesResult[13] == hash[0] && aesResult[14] == hash[1] && aesResult[15] == hash[2]) return Index;
+        return RpaUnrolled<Index + 1, End>::resolve(input, hash, devices, deviceCount, aesOps);
+    }
+};
+
+template <int End>
+struct RpaUnrolled<End, End> {
+    template <typename Device>
+    static int resolve(const uint8_t*, const uint8_t*, const Device*, int, int*) {
+        return -1;
+    }
+};
+
+// resolveRPA() for a table of at most Capacity devices (KeylessTraits::capacity):
+// the walk is unrolled up to RPA_UNROLL_MAX, a loop with a constant bound above
+template <int Capacity, bool Unroll = (Capacity <= RPA_UNROLL_MAX)>
+struct RpaResolver {
+    template <typename Device>
+    static int resolve(const uint8_t* rpaAddress, const Device* devices, int deviceCount, int* aesOps = nullptr) {
+        int ops = 0;
+        int found = -1;
+        if (isResolvableAddress(rpaAddress)) {
+            uint8_t input[16] = {0};
+            input[13] = rpaAddress[0];
+            input[14] = rpaAddress[1];
+            input[15] = rpaAddress[2];
+            found = RpaUnrolled<0, Capacity>::resolve(input, rpaAddress + 3, devices, deviceCount, &ops);
+        }
+        if (aesOps) *aesOps = ops;
+        return found;
+    }
+};
+
+template <int Capacity>
+struct RpaResolver<Capacity, false> {
+    template <typename Device>
+    static int resolve(const uint8_t* rpaAddress, const Device* devices, int deviceCount, int* aesOps = nullptr) {
+        return resolveRPA(rpaAddress, devices, deviceCount < Capacity ? deviceCount : Capacity, aesOps);
+    }
+};
+
+// The RPA `irk` produces for a 22-bit prand (host-side fixtures and the
+// Linux simulator; the firmware only resolves)
+inline void makeRPA(const uint8_t irk[16], uint32_t prand, uint8_t rpa[6]) {
+    uint8_t input[16] = {0};
+    uint8_t result[16];
+    input[13] = (uint8_t)(((prand >> 16) & 0x3F) | 0x40);
+    input[14] = (uint8_t)(prand >> 8);
+    input[15] = (uint8_t)prand;
+    aes128_ecb_fast(irk, input, result);
+    rpa[0] = input[13];
+    rpa[1] = input[14];
+    rpa[2] = input[15];
+    rpa[3] = result[13];
+    rpa[4] = result[14];
+    rpa[5] = result[15];
+}
+
+#endif // RPA_H
@@ -0,0 +1,238 @@
+/*
+ * RSSI Profile - Per-device signal levels learned from observed sessions
+ * An iPhone in a back pocket reads 10-15 dB below one in a hand, so one
+ * pair of thresholds for every phone needs wide margins. Each paired device
+ * learns two histograms (2 dB bins, halved when full so old habits fade):
+ *
+ *   near       samples while the device was nearby, i.e. at the car
+ *   departure  the last PROFILE_DEPART_MS of samples before each walk-away
+ *
+ * A session (nearby -> gone/timeout) shorter than PROFILE_MIN_SESSION_MS
+ * is somebody walking past and is discarded. After PROFILE_MIN_SESSIONS the
+ * profile has a weak boundary: halfway between the near PROFILE_NEAR_PCT
+ * (2nd) percentile and the departure median when they are apart, else
+ * PROFILE_SAFETY_DB below that percentile. Both global thresholds are shifted by (boundary - effective
+ * weak threshold), so the configured unlock/lock spread is kept per device.
+ * The engine's weak boundary is also its unlock boundary, so raising it
+ * trades arrival latency for departure latency: raises are capped lower
+ * than drops.
+ *
+ * RssiProfile is persisted with the IRK (StoredDevice.profile). The
+ * per-session state lives in RAM (ProfileLearner): the resolve task feeds
+ * it, the loop task takes snapshots of changed profiles to write to NVS.
+ */
+
+#ifndef RSSI_PROFILE_H
+#define RSSI_PROFILE_H
+
+#include <Arduino.h>
+#include "keyless_config.h"
+
+#define PROFILE_BIN_DB 2
+#define PROFILE_BINS ((KEYLESS_RSSI_MAX - KEYLESS_RSSI_MIN) / PROFILE_BIN_DB + 1)
+#define PROFILE_HIST_CAP 4000           // Samples per histogram before halving
+#define PROFILE_TAIL 16                 // Latest samples held back as departure candidates
+#define PROFILE_DEPART_MS 10000
+#define PROFILE_MIN_SESSION_MS 30000
+#define PROFILE_MIN_SESSIONS 3
+#define PROFILE_MIN_SAMPLES 50          // Per histogram before it is trusted
+#define PROFILE_NEAR_PCT 2              // Near quantile the boundary stays under
+#define PROFILE_SAFETY_DB 4             // dB below it
+#define PROFILE_MAX_RAISE 6             // Strong phone: lock sooner, but unlock on arrival later
+#define PROFILE_MAX_LOWER 15            // Weak phone (pocket, case): no locks while standing there
+
+struct RssiHistogram {
+    uint16_t bins[PROFILE_BINS];
+    uint16_t total;
+
+    void clear() {
+        memset(this, 0, sizeof(*this));
+    }
+
+    static int binOf(int rssi) {
+        if (rssi < KEYLESS_RSSI_MIN) rssi = KEYLESS_RSSI_MIN;
+        if (rssi > KEYLESS_RSSI_MAX) rssi = KEYLESS_RSSI_MAX;
+        return (rssi - KEYLESS_RSSI_MIN) / PROFILE_BIN_DB;
+    }
+
+    void add(int rssi, uint16_t count = 1) {
+        if (total + count > PROFILE_HIST_CAP) halve();
+        bins[binOf(rssi)] += count;
+        total += count;
+    }
+
+    void merge(const RssiHistogram& other) {
+        for (int i = 0; i < PROFILE_BINS; i++) {
+            if (other.bins[i]) add(KEYLESS_RSSI_MIN + i * PROFILE_BIN_DB, other.bins[i]);
+        }
+    }
+
+    void halve() {
+        total = 0;
+        for (int i = 0; i < PROFILE_BINS; i++) {
+            bins[i] /= 2;
+            total += bins[i];
+        }
+    }
+
+    // Lower edge (dBm) of the bin holding the `percent` quantile
+    int quantile(int percent) const {
+        uint32_t target = ((uint32_t)total * percent + 99) / 100;
+        if (target == 0) target = 1;
+        uint32_t seen = 0;
+        for (int i = 0; i < PROFILE_BINS; i++) {
+            seen += bins[i];
+            if (seen >= target) return KEYLESS_RSSI_MIN + i * PROFILE_BIN_DB;
+        }
+        return KEYLESS_RSSI_MAX;
+    }
+};
+
+struct RssiProfile {
+    RssiHistogram near;
+    RssiHistogram departure;
+    uint16_t sessions;
+    int8_t boundary;                    // Learned weak boundary (dBm), 0 = not yet
+
+    void reset() {
+        memset(this, 0, sizeof(*this));
+    }
+
+    void derive() {
+        boundary = 0;
+        if (sessions < PROFILE_MIN_SESSIONS || near.total < PROFILE_MIN_SAMPLES) return;
+        int nearLow = near.quantile(PROFILE_NEAR_PCT);
+        int b = nearLow - PROFILE_SAFETY_DB;
+        if (departure.total >= PROFILE_MIN_SAMPLES) {
+            int departMid = departure.quantile(50);
+            if (nearLow - departMid > 2 * PROFILE_SAFETY_DB) b = (nearLow + departMid) / 2;
+        }
+        if (b < KEYLESS_RSSI_MIN) b = KEYLESS_RSSI_MIN;
+        if (b > KEYLESS_RSSI_MAX) b = KEYLESS_RSSI_MAX;
+        boundary = (int8_t)b;
+    }
+
+    // dB both thresholds move by for this device (0 until learned)
+    int offsetFor(const ProximityConfig& cfg) const {
+        if (boundary == 0) return 0;
+        // An advert above unlockRssi is strong whatever lockRssi says
+        int weak = cfg.unlockRssi < cfg.lockRssi ? cfg.unlockRssi : cfg.lockRssi;
+        int offset = boundary - weak;
+        if (offset > PROFILE_MAX_RAISE) offset = PROFILE_MAX_RAISE;
+        if (offset < -PROFILE_MAX_LOWER) offset = -PROFILE_MAX_LOWER;
+        return offset;
+    }
+};
+
+// Session state per device and the learning rules; profiles themselves
+// stay in the device table (`Device` needs a `profile` member)
+template <typename Device, int Capacity>
+class ProfileLearner {
+private:
+    struct Session {
+        RssiHistogram near;
+        int8_t tail[PROFILE_TAIL];
+        uint32_t tailMs[PROFILE_TAIL];
+        uint8_t tailHead;
+        uint8_t tailCount;
+        bool active;
+        uint32_t startMs;
+        uint32_t lastMs;
+    };
+
+    Device* devices = nullptr;
+    int deviceCount = 0;
+    Session sessions[Capacity];
+    bool dirty[Capacity];
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;    // Profiles and dirty flags
+
+    static int clampRssi(int rssi) {
+        if (rssi < KEYLESS_RSSI_MIN) return KEYLESS_RSSI_MIN;
+        if (rssi > KEYLESS_RSSI_MAX) return KEYLESS_RSSI_MAX;
+        return rssi;
+    }
+
+public:
+    void begin(Device* table, int count) {
+        devices = table;
+        deviceCount = count < Capacity ? count : Capacity;
+        memset(sessions, 0, sizeof(sessions));
+        for (int i = 0; i < Capacity; i++) dirty[i] = false;
+    }
+
+    // Thresholds for `device`: the global ones shifted by its profile
+    ProximityConfig configFor(int device, const ProximityConfig& cfg) const {
+        ProximityConfig out = cfg;
+        if (device >= deviceCount) return out;
+        int offset = devices[device].profile.offsetFor(cfg);
+        out.unlockRssi = clampRssi(cfg.unlockRssi + offset);
+        out.lockRssi = clampRssi(cfg.lockRssi + offset);
+        return out;
+    }
+
+    // Every advert of a device after its proximity decision; the advert
+    // that took the device out of range is the session's last sample
+    void onSample(int device, int rssi, bool nearby, uint32_t nowMs) {
+        if (device >= deviceCount) return;
+        Session& s = sessions[device];
+        if (!nearby && !s.active) return;
+        if (!s.active) {
+            memset(&s, 0, sizeof(s));
+            s.active = true;
+            s.startMs = nowMs;
+        }
+        s.lastMs = nowMs;
+
+        // The oldest held-back sample was not part of a departure after all
+        if (s.tailCount == PROFILE_TAIL) {
+            s.near.add(s.tail[s.tailHead]);
+        } else {
+            s.tailCount++;
+        }
+        s.tail[s.tailHead] = (int8_t)clampRssi(rssi);
+        s.tailMs[s.tailHead] = nowMs;
+        s.tailHead = (s.tailHead + 1) % PROFILE_TAIL;
+
+        if (!nearby) onDeparture(device);
+    }
+
+    // The device left without a last advert (timeout, everyone gone). Returns
+    // true when the session was long enough to update the profile.
+    bool onDeparture(int device) {
+        if (device >= deviceCount) return false;
+        Session& s = sessions[device];
+        if (!s.active) return false;
+        s.active = false;
+        if (s.lastMs - s.startMs < PROFILE_MIN_SESSION_MS) return false;
+
+        portENTER_CRITICAL(&mux);
+        RssiProfile& p = devices[device].profile;
+        p.near.merge(s.near);
+        for (int k = 0; k < s.tailCount; k++) {
+            int i = (s.tailHead + PROFILE_TAIL - s.tailCount + k) % PROFILE_TAIL;
+            if (s.lastMs - s.tailMs[i] <= PROFILE_DEPART_MS) p.departure.add(s.tail[i]);
+            else p.near.add(s.tail[i]);
+        }
+        if (p.sessions < UINT16_MAX) p.sessions++;
+        p.derive();
+        dirty[device] = true;
+        portEXIT_CRITICAL(&mux);
+        return true;
+    }
+
+    // Copy of the next profile changed since the last call; -1 if none
+    int takeDirty(RssiProfile* out) {
+        int found = -1;
+        portENTER_CRITICAL(&mux);
+        for (int i = 0; i < deviceCount && found < 0; i++) {
+            if (!dirty[i]) continue;
+            dirty[i] = false;
+            *out = devices[i].profile;
+            found = i;
+        }
+        portEXIT_CRITICAL(&mux);
+        return found;
+    }
+};
+
+#endif // RSSI_PROFILE_H
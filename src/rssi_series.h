@@ -0,0 +1,173 @@
+/*
+ * RSSI Series - Per-device signal history in RAM for charts
+ * Every resolved advert is kept at full resolution for a while, and is
+ * also folded into min/max/mean buckets for longer views:
+ *
+ *   tier     resolution   kept                     per device
+ *   raw      per advert   last RSSI_SERIES_RAW     320 bytes
+ *   fine     10 s         6 min                    288 bytes
+ *   coarse   1 min        1 h                      480 bytes
+ *
+ * The tiers are written through on every sample (no re-aggregation pass),
+ * so the memory is fixed and a reader copies at most one tier. Times are
+ * millis(); a clock that goes backwards (wrap) starts the tiers over.
+ * Written by the resolve task, read by the web and loop tasks. Portable:
+ * no I/O.
+ */
+
+#ifndef RSSI_SERIES_H
+#define RSSI_SERIES_H
+
+#include <Arduino.h>
+#include "keyless_config.h"
+
+#ifndef RSSI_SERIES_RAW
+#define RSSI_SERIES_RAW 64
+#endif
+#define RSSI_FINE_MS 10000
+#define RSSI_FINE_BUCKETS 36
+#define RSSI_COARSE_MS 60000
+#define RSSI_COARSE_BUCKETS 60
+
+enum RssiTier {
+    RSSI_TIER_FINE,
+    RSSI_TIER_COARSE
+};
+
+struct RssiBucket {
+    int8_t min;
+    int8_t max;
+    uint16_t count;                     // 0 = no adverts in this period
+    int32_t sum;
+
+    int mean() const {
+        return count ? (sum - (int32_t)count / 2) / (int32_t)count : 0;
+    }
+};
+
+// Buckets of one tier, oldest first; the last one is the current period
+struct RssiTierView {
+    uint32_t stepMs;
+    uint32_t currentAgeMs;              // Time since the last bucket started
+    int count;
+    RssiBucket buckets[RSSI_COARSE_BUCKETS];
+};
+
+static_assert(RSSI_COARSE_BUCKETS >= RSSI_FINE_BUCKETS, "RssiTierView holds the longest tier");
+
+template <int Capacity>
+class RssiSeries {
+private:
+    template <int N, uint32_t StepMs>
+    struct Tier {
+        uint32_t latest;                // Newest period + 1, 0 = empty
+        RssiBucket ring[N];
+
+        void add(uint32_t nowMs, int rssi) {
+            uint32_t period = nowMs / StepMs + 1;
+            if (latest == 0 || period < latest || period - latest >= (uint32_t)N) {
+                memset(ring, 0, sizeof(ring));
+            } else {
+                for (uint32_t p = latest + 1; p <= period; p++) memset(&ring[p % N], 0, sizeof(RssiBucket));
+            }
+            latest = period;
+
+            RssiBucket& b = ring[period % N];
+            if (b.count == 0 || rssi < b.min) b.min = (int8_t)rssi;
+            if (b.count == 0 || rssi > b.max) b.max = (int8_t)rssi;
+            if (b.count < UINT16_MAX) {
+                b.count++;
+                b.sum += rssi;
+            }
+        }
+
+        void copy(uint32_t nowMs, RssiTierView* out) const {
+            uint32_t current = nowMs / StepMs + 1;
+            out->stepMs = StepMs;
+            out->currentAgeMs = nowMs % StepMs;
+            out->count = N;
+            for (int k = 0; k < N; k++) {
+                uint32_t period = current - (N - 1) + k;
+                bool kept = latest != 0 && period <= latest && latest - period < (uint32_t)N;
+                if (kept) out->buckets[k] = ring[period % N];
+                else memset(&out->buckets[k], 0, sizeof(RssiBucket));
+            }
+        }
+    };
+
+    struct Device {
+        uint32_t rawMs[RSSI_SERIES_RAW];
+        int8_t rawRssi[RSSI_SERIES_RAW];
+        uint16_t rawHead;
+        uint16_t rawCount;
+        Tier<RSSI_FINE_BUCKETS, RSSI_FINE_MS> fine;
+        Tier<RSSI_COARSE_BUCKETS, RSSI_COARSE_MS> coarse;
+    };
+
+    Device devices[Capacity];
+    int deviceCount = 0;
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+
+public:
+    void begin(int count) {
+        portENTER_CRITICAL(&mux);
+        deviceCount = count < Capacity ? count : Capacity;
+        memset(devices, 0, sizeof(devices));
+        portEXIT_CRITICAL(&mux);
+    }
+
+    // Resolve task: one resolved advert
+    void add(int device, int rssi, uint32_t nowMs) {
+        if (device < 0 || device >= deviceCount) return;
+        if (rssi < KEYLESS_RSSI_MIN) rssi = KEYLESS_RSSI_MIN;
+        if (rssi > KEYLESS_RSSI_MAX) rssi = KEYLESS_RSSI_MAX;
+
+        portENTER_CRITICAL(&mux);
+        Device& d = devices[device];
+        d.rawMs[d.rawHead] = nowMs;
+        d.rawRssi[d.rawHead] = (int8_t)rssi;
+        d.rawHead = (d.rawHead + 1) % RSSI_SERIES_RAW;
+        if (d.rawCount < RSSI_SERIES_RAW) d.rawCount++;
+        d.fine.add(nowMs, rssi);
+        d.coarse.add(nowMs, rssi);
+        portEXIT_CRITICAL(&mux);
+    }
+
+    // Latest sample of `device`, or `fallback` if it has none
+    int latest(int device, int fallback) {
+        if (device < 0 || device >= deviceCount) return fallback;
+        portENTER_CRITICAL(&mux);
+        const Device& d = devices[device];
+        int rssi = d.rawCount ? d.rawRssi[(d.rawHead + RSSI_SERIES_RAW - 1) % RSSI_SERIES_RAW] : fallback;
+        portEXIT_CRITICAL(&mux);
+        return rssi;
+    }
+
+    // Raw samples, oldest first, as age (ms before `nowMs`) and RSSI
+    int readRaw(int device, uint32_t nowMs, uint32_t* ageMs, int8_t* rssi, int maxOut) {
+        if (device < 0 || device >= deviceCount) return 0;
+        portENTER_CRITICAL(&mux);
+        const Device& d = devices[device];
+        int n = d.rawCount < maxOut ? d.rawCount : maxOut;
+        for (int k = 0; k < n; k++) {
+            int i = (d.rawHead + RSSI_SERIES_RAW - n + k) % RSSI_SERIES_RAW;
+            ageMs[k] = nowMs - d.rawMs[i];
+            rssi[k] = d.rawRssi[i];
+        }
+        portEXIT_CRITICAL(&mux);
+        return n;
+    }
+
+    bool readTier(int device, RssiTier tier, uint32_t nowMs, RssiTierView* out) {
+        if (device < 0 || device >= deviceCount) return false;
+        portENTER_CRITICAL(&mux);
+        if (tier == RSSI_TIER_FINE) devices[device].fine.copy(nowMs, out);
+        else devices[device].coarse.copy(nowMs, out);
+        portEXIT_CRITICAL(&mux);
+        return true;
+    }
+};
+
+extern RssiSeries<MAX_DEVICES> rssiSeries;
+
+#endif // RSSI_SERIES_H
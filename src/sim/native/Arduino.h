@@ -0,0 +1,265 @@
+/*
+ * Simulator Arduino Shim - Arduino-ESP32 API on the sim kernel
+ * Enough of Arduino.h/FreeRTOS for main.cpp and the modules it builds with
+ * HAL_LINUX (storage, audit log, metrics, trace, coex, event stream,
+ * proximity). Time is the kernel's virtual clock, tasks are kernel tasks,
+ * Serial goes to stdout stamped with simulated world time.
+ *
+ * There is no GPIO here on purpose: main.cpp drives pins through hal.
+ */
+
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <atomic>
+#include "sim_kernel.h"
+
+using std::min;
+using std::max;
+
+#define HEX 16
+#define DEC 10
+#define LOW 0
+#define HIGH 1
+#define INPUT 0x01
+#define OUTPUT 0x03
+
+#define SIM_CPU_MHZ 240
+
+// ========== Time ==========
+
+inline unsigned long millis() {
+    return (unsigned long)(uint32_t)(simNowUs() / 1000);
+}
+
+inline unsigned long micros() {
+    return (unsigned long)(uint32_t)simNowUs();
+}
+
+inline void delay(uint32_t ms) {
+    simSleepUs((uint64_t)ms * 1000);
+}
+
+inline void delayMicroseconds(uint32_t us) {
+    simSleepUs(us);
+}
+
+// ========== Serial (stdout) ==========
+
+class SimSerial {
+private:
+    bool lineStart = true;
+    bool quiet = false;
+
+    void write(const char* text) {
+        write((const uint8_t*)text, strlen(text));
+    }
+
+public:
+    size_t write(const uint8_t* data, size_t len) {
+        if (quiet) return len;
+        for (const uint8_t* p = data; p != data + len; p++) {
+            if (lineStart) {
+                uint64_t ms = simWorldUs() / 1000;
+                fprintf(stdout, "[%3lud %02lu:%02lu:%02lu.%03lu] ", (unsigned long)(ms / 86400000),
+                    (unsigned long)(ms / 3600000 % 24), (unsigned long)(ms / 60000 % 60),
+                    (unsigned long)(ms / 1000 % 60), (unsigned long)(ms % 1000));
+                lineStart = false;
+            }
+            fputc(*p, stdout);
+            if (*p == '\n') lineStart = true;
+        }
+        return len;
+    }
+
+private:
+    size_t printNumber(unsigned long value, bool negative, int base) {
+        char text[24];
+        if (base == HEX) snprintf(text, sizeof(text), "%lX", value);
+        else snprintf(text, sizeof(text), negative ? "-%lu" : "%lu", value);
+        write(text);
+        return strlen(text);
+    }
+
+public:
+    void begin(unsigned long) {}
+
+    // Firmware output off (the simulator's own summary still prints)
+    void setQuiet(bool q) {
+        quiet = q;
+    }
+
+    int printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        char text[512];
+        va_list args;
+        va_start(args, format);
+        int len = vsnprintf(text, sizeof(text), format, args);
+        va_end(args);
+        write(text);
+        return len;
+    }
+
+    size_t print(const char* text) {
+        write(text);
+        return strlen(text);
+    }
+
+    size_t print(char c) {
+        char text[2] = {c, '\0'};
+        write(text);
+        return 1;
+    }
+
+    size_t print(int value, int base = DEC) {
+        if (base == HEX) return printNumber((unsigned int)value, false, base);
+        return printNumber(value < 0 ? -(long)value : value, value < 0, base);
+    }
+
+    size_t print(unsigned int value, int base = DEC) {
+        return printNumber(value, false, base);
+    }
+
+    size_t print(long value, int base = DEC) {
+        if (base == HEX) return printNumber((unsigned long)value, false, base);
+        return printNumber(value < 0 ? -(unsigned long)value : value, value < 0, base);
+    }
+
+    size_t print(unsigned long value, int base = DEC) {
+        return printNumber(value, false, base);
+    }
+
+    template <typename T>
+    size_t println(T value) {
+        size_t n = print(value);
+        write("\n");
+        return n + 1;
+    }
+
+    template <typename T>
+    size_t println(T value, int base) {
+        size_t n = print(value, base);
+        write("\n");
+        return n + 1;
+    }
+
+    size_t println() {
+        write("\n");
+        return 1;
+    }
+
+    // stdout never blocks the simulated tasks
+    int availableForWrite() {
+        return 4096;
+    }
+
+    int available() {
+        return 0;
+    }
+
+    int read() {
+        return -1;
+    }
+};
+
+inline SimSerial Serial;
+
+// ========== ESP ==========
+
+class SimEsp {
+public:
+    uint32_t getFreeHeap() { return 0; }
+    uint32_t getMinFreeHeap() { return 0; }
+    uint32_t getMaxAllocHeap() { return 0; }
+    uint32_t getCpuFreqMHz() { return SIM_CPU_MHZ; }
+
+    // Virtual cycles at SIM_CPU_MHZ (trace timestamps)
+    uint32_t getCycleCount() {
+        return (uint32_t)(simNowUs() * SIM_CPU_MHZ);
+    }
+};
+
+inline SimEsp ESP;
+
+inline uint32_t getCpuFrequencyMhz() {
+    return SIM_CPU_MHZ;
+}
+
+// ========== FreeRTOS ==========
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))    // configTICK_RATE_HZ 1000
+#define portMAX_DELAY 0xFFFFFFFF
+#define pdPASS 1
+#define pdFAIL 0
+#define pdTRUE 1
+#define pdFALSE 0
+
+inline TickType_t xTaskGetTickCount() {
+    return (TickType_t)millis();
+}
+
+inline void vTaskDelay(TickType_t ticks) {
+    delay(ticks);
+}
+
+inline BaseType_t xPortGetCoreID() {
+    return 0;
+}
+
+// Priority and core are ignored: tasks run one at a time in wake-up order
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t /* stackDepth */,
+                                          void* param, UBaseType_t /* priority */, TaskHandle_t* handle,
+                                          BaseType_t /* core */) {
+    TaskHandle_t task = simCreateTask(fn, name, param);
+    if (handle) *handle = task;
+    return task ? pdPASS : pdFAIL;
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return simCurrentTask();
+}
+
+inline const char* pcTaskGetName(TaskHandle_t task) {
+    return simTaskName(task);
+}
+
+inline BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    simNotifyGive(task);
+    return pdPASS;
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks) {
+    return simNotifyTake(clearOnExit, ticks == portMAX_DELAY ? UINT64_MAX : (uint64_t)ticks * 1000);
+}
+
+inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) {
+    return 0;
+}
+
+// Tasks never preempt each other, critical sections have nothing to exclude
+struct portMUX_TYPE {
+    int owner;
+};
+
+#define portMUX_INITIALIZER_UNLOCKED {0}
+
+inline void portENTER_CRITICAL(portMUX_TYPE*) {
+}
+
+inline void portEXIT_CRITICAL(portMUX_TYPE*) {
+}
+
+#endif // SIM_ARDUINO_H
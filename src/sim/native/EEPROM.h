@@ -0,0 +1,55 @@
+/*
+ * Simulator EEPROM Shim - Legacy device backup persisted to a file
+ * main.cpp keeps its pre-NVS device list in EEPROM as a backup and migrates
+ * it into NVS whenever NVS has no devices. <state dir>/eeprom.bin is read
+ * by begin() and rewritten by commit(), so it survives the simulator's
+ * restarts like flash; without the file the EEPROM is blank (0xFF).
+ */
+
+#ifndef SIM_EEPROM_H
+#define SIM_EEPROM_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+class SimEeprom {
+private:
+    uint8_t data[512];
+
+    std::string path() {
+        return simStateDir() + "/eeprom.bin";
+    }
+
+public:
+    bool begin(size_t) {
+        memset(data, 0xFF, sizeof(data));
+        FILE* f = fopen(path().c_str(), "rb");
+        if (f) {
+            size_t n = fread(data, 1, sizeof(data), f);
+            (void)n;
+            fclose(f);
+        }
+        return true;
+    }
+
+    bool commit() {
+        FILE* f = fopen(path().c_str(), "wb");
+        if (!f) return false;
+        bool ok = fwrite(data, 1, sizeof(data), f) == sizeof(data);
+        fclose(f);
+        return ok;
+    }
+
+    uint8_t readByte(int addr) { return data[addr]; }
+    void writeByte(int addr, uint8_t v) { data[addr] = v; }
+
+    uint32_t readULong(int addr) { uint32_t v; memcpy(&v, data + addr, 4); return v; }
+    void writeULong(int addr, uint32_t v) { memcpy(data + addr, &v, 4); }
+
+    int32_t readInt(int addr) { int32_t v; memcpy(&v, data + addr, 4); return v; }
+    void writeInt(int addr, int32_t v) { memcpy(data + addr, &v, 4); }
+};
+
+inline SimEeprom EEPROM;
+
+#endif // SIM_EEPROM_H
@@ -0,0 +1,119 @@
+/*
+ * Simulator Preferences Shim - NVS stand-in persisted to files
+ * One file per namespace, <state dir>/<namespace>.nvs, rewritten on every
+ * put/remove like an NVS commit. Survives the simulator's restarts
+ * (hal.restart() re-executes the process) the way NVS survives a reboot.
+ * The state directory is set once by the simulator before setup().
+ */
+
+#ifndef SIM_PREFERENCES_H
+#define SIM_PREFERENCES_H
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include <vector>
+
+inline std::string& simStateDir() {
+    static std::string dir = ".";
+    return dir;
+}
+
+class Preferences {
+private:
+    std::string path;
+    std::map<std::string, std::vector<uint8_t>> values;
+
+    // File: repeated [key length u8][key][value length u16 LE][value]
+    void load() {
+        values.clear();
+        FILE* f = fopen(path.c_str(), "rb");
+        if (!f) return;
+        for (;;) {
+            uint8_t keyLen;
+            uint8_t lenBytes[2];
+            if (fread(&keyLen, 1, 1, f) != 1) break;
+            std::string key(keyLen, '\0');
+            if (fread(&key[0], 1, keyLen, f) != keyLen || fread(lenBytes, 1, 2, f) != 2) break;
+            std::vector<uint8_t> value(lenBytes[0] | lenBytes[1] << 8);
+            if (!value.empty() && fread(value.data(), 1, value.size(), f) != value.size()) break;
+            values[key] = value;
+        }
+        fclose(f);
+    }
+
+    void save() {
+        if (path.empty()) return;
+        FILE* f = fopen(path.c_str(), "wb");
+        if (!f) return;
+        for (auto& kv : values) {
+            uint8_t keyLen = (uint8_t)kv.first.size();
+            uint8_t lenBytes[2] = {(uint8_t)kv.second.size(), (uint8_t)(kv.second.size() >> 8)};
+            fwrite(&keyLen, 1, 1, f);
+            fwrite(kv.first.data(), 1, keyLen, f);
+            fwrite(lenBytes, 1, 2, f);
+            fwrite(kv.second.data(), 1, kv.second.size(), f);
+        }
+        fclose(f);
+    }
+
+    size_t put(const char* key, const void* value, size_t len) {
+        std::vector<uint8_t>& v = values[key];
+        v.assign((const uint8_t*)value, (const uint8_t*)value + len);
+        save();
+        return len;
+    }
+
+    template <typename T>
+    T get(const char* key, T defaultValue) {
+        auto it = values.find(key);
+        if (it == values.end() || it->second.size() != sizeof(T)) return defaultValue;
+        T value;
+        memcpy(&value, it->second.data(), sizeof(T));
+        return value;
+    }
+
+public:
+    bool begin(const char* name, bool = false) {
+        path = simStateDir() + "/" + name + ".nvs";
+        load();
+        return true;
+    }
+
+    void end() {}
+    bool clear() { values.clear(); save(); return true; }
+    bool remove(const char* key) { bool had = values.erase(key) > 0; save(); return had; }
+    bool isKey(const char* key) { return values.count(key) > 0; }
+
+    int8_t getChar(const char* key, int8_t d = 0) { return get(key, d); }
+    uint8_t getUChar(const char* key, uint8_t d = 0) { return get(key, d); }
+    int32_t getInt(const char* key, int32_t d = 0) { return get(key, d); }
+    uint32_t getUInt(const char* key, uint32_t d = 0) { return get(key, d); }
+    bool getBool(const char* key, bool d = false) { return get(key, (uint8_t)d) != 0; }
+
+    size_t putChar(const char* key, int8_t v) { return put(key, &v, sizeof(v)); }
+    size_t putUChar(const char* key, uint8_t v) { return put(key, &v, sizeof(v)); }
+    size_t putInt(const char* key, int32_t v) { return put(key, &v, sizeof(v)); }
+    size_t putUInt(const char* key, uint32_t v) { return put(key, &v, sizeof(v)); }
+    size_t putBool(const char* key, bool v) { uint8_t b = v; return put(key, &b, 1); }
+
+    size_t putBytes(const char* key, const void* value, size_t len) { return put(key, value, len); }
+
+    size_t getBytes(const char* key, void* buf, size_t maxLen) {
+        auto it = values.find(key);
+        if (it == values.end() || it->second.size() > maxLen) return 0;
+        memcpy(buf, it->second.data(), it->second.size());
+        return it->second.size();
+    }
+
+    size_t putString(const char* key, const char* value) { return put(key, value, strlen(value) + 1); }
+
+    size_t getString(const char* key, char* buf, size_t maxLen) {
+        auto it = values.find(key);
+        if (it == values.end() || it->second.size() > maxLen) return 0;
+        memcpy(buf, it->second.data(), it->second.size());
+        return it->second.size();
+    }
+};
+
+#endif // SIM_PREFERENCES_H
@@ -0,0 +1,21 @@
+/*
+ * Simulator WiFi Shim - Disconnected WiFiClient for event_stream.h
+ * The simulator runs no web server, so no client ever attaches to the
+ * event stream; producers still fill its queue as on the device.
+ */
+
+#ifndef SIM_WIFI_H
+#define SIM_WIFI_H
+
+#include <Arduino.h>
+
+class WiFiClient {
+public:
+    int fd() { return -1; }
+    bool connected() { return false; }
+    void stop() {}
+    void setNoDelay(bool) {}
+    size_t print(const char*) { return 0; }
+};
+
+#endif // SIM_WIFI_H
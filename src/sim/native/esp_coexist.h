@@ -0,0 +1,19 @@
+/*
+ * Simulator esp_coexist Shim - Radio preference is accepted and ignored
+ * (scan duty, which the coex profiles also set, is modelled by hal.scan())
+ */
+
+#ifndef SIM_ESP_COEXIST_H
+#define SIM_ESP_COEXIST_H
+
+typedef enum {
+    ESP_COEX_PREFER_WIFI,
+    ESP_COEX_PREFER_BT,
+    ESP_COEX_PREFER_BALANCE
+} esp_coex_prefer_t;
+
+inline int esp_coex_preference_set(esp_coex_prefer_t) {
+    return 0;
+}
+
+#endif // SIM_ESP_COEXIST_H
@@ -0,0 +1,14 @@
+/*
+ * Simulator esp_timer Shim - Virtual microseconds since boot
+ */
+
+#ifndef SIM_ESP_TIMER_H
+#define SIM_ESP_TIMER_H
+
+#include <Arduino.h>
+
+inline int64_t esp_timer_get_time() {
+    return (int64_t)simNowUs();
+}
+
+#endif // SIM_ESP_TIMER_H
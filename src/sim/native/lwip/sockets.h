@@ -0,0 +1,11 @@
+/*
+ * Simulator lwIP Shim - Host BSD sockets
+ */
+
+#ifndef SIM_LWIP_SOCKETS_H
+#define SIM_LWIP_SOCKETS_H
+
+#include <errno.h>
+#include <sys/socket.h>
+
+#endif // SIM_LWIP_SOCKETS_H
@@ -0,0 +1,149 @@
+/*
+ * Sim Kernel - ucontext scheduler on a virtual clock (see sim_kernel.h)
+ */
+
+#include "sim_kernel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+
+uint64_t simClockUs = 0;
+uint64_t simBootWorldUs = 0;
+
+struct SimTask {
+    ucontext_t context;
+    char* stack;
+    SimTaskFn fn;
+    void* param;
+    char name[16];
+    uint64_t wakeUs;
+    uint32_t notifyCount;
+    bool notifyWait;            // Sleeping in simNotifyTake()
+    bool finished;
+    bool watched;               // Subscribed to the task watchdog
+    uint64_t fedUs;
+};
+
+static SimTask tasks[SIM_MAX_TASKS];
+static int taskCount = 0;
+static int current = -1;        // -1: scheduler (or before simRun)
+static ucontext_t scheduler;
+static uint64_t watchdogTimeoutUs = 0;
+
+static void switchToScheduler() {
+    SimTask& t = tasks[current];
+    swapcontext(&t.context, &scheduler);
+}
+
+static void taskEntry() {
+    SimTask& t = tasks[current];
+    t.fn(t.param);
+    // FreeRTOS tasks never return; treat it as the task deleting itself
+    t.finished = true;
+    switchToScheduler();
+}
+
+void simSleepUs(uint64_t us) {
+    if (current < 0) {
+        simClockUs += us;
+        return;
+    }
+    tasks[current].wakeUs = simClockUs + us;
+    switchToScheduler();
+}
+
+void* simCreateTask(SimTaskFn fn, const char* name, void* param) {
+    if (taskCount >= SIM_MAX_TASKS) return NULL;
+    SimTask& t = tasks[taskCount];
+    memset(&t, 0, sizeof(t));
+    t.fn = fn;
+    t.param = param;
+    strncpy(t.name, name, sizeof(t.name) - 1);
+    t.wakeUs = simClockUs;
+    t.stack = (char*)malloc(SIM_TASK_STACK);
+
+    getcontext(&t.context);
+    t.context.uc_stack.ss_sp = t.stack;
+    t.context.uc_stack.ss_size = SIM_TASK_STACK;
+    t.context.uc_link = NULL;
+    makecontext(&t.context, taskEntry, 0);
+    return &tasks[taskCount++];
+}
+
+void* simCurrentTask() {
+    return current >= 0 ? &tasks[current] : NULL;
+}
+
+const char* simTaskName(void* task) {
+    return task ? ((SimTask*)task)->name : "main";
+}
+
+void simNotifyGive(void* task) {
+    SimTask* t = (SimTask*)task;
+    if (!t) return;
+    t->notifyCount++;
+    if (t->notifyWait && t->wakeUs > simClockUs) t->wakeUs = simClockUs;
+}
+
+uint32_t simNotifyTake(bool clear, uint64_t timeoutUs) {
+    if (current < 0) return 0;
+    SimTask& t = tasks[current];
+    if (t.notifyCount == 0 && timeoutUs > 0) {
+        t.notifyWait = true;
+        t.wakeUs = timeoutUs == UINT64_MAX ? UINT64_MAX : simClockUs + timeoutUs;
+        switchToScheduler();
+        t.notifyWait = false;
+    }
+    uint32_t count = t.notifyCount;
+    if (count > 0) t.notifyCount = clear ? 0 : count - 1;
+    return count;
+}
+
+void simWatchdogBegin(uint32_t timeoutS) {
+    watchdogTimeoutUs = (uint64_t)timeoutS * 1000000;
+}
+
+void simWatchdogAdd() {
+    if (current < 0) return;
+    tasks[current].watched = true;
+    tasks[current].fedUs = simClockUs;
+}
+
+void simWatchdogReset() {
+    if (current >= 0) tasks[current].fedUs = simClockUs;
+}
+
+void simRun(uint64_t untilUs, SimWatchdogFn onWatchdog) {
+    for (;;) {
+        int next = -1;
+        for (int i = 0; i < taskCount; i++) {
+            if (tasks[i].finished) continue;
+            if (next < 0 || tasks[i].wakeUs < tasks[next].wakeUs) next = i;
+        }
+        if (next < 0) return;
+        uint64_t wakeUs = tasks[next].wakeUs;
+
+        // A starved subscriber trips the watchdog before anything else runs
+        if (watchdogTimeoutUs) {
+            for (int i = 0; i < taskCount; i++) {
+                uint64_t deadline = tasks[i].fedUs + watchdogTimeoutUs;
+                if (tasks[i].watched && !tasks[i].finished && deadline < wakeUs && deadline <= untilUs) {
+                    if (deadline > simClockUs) simClockUs = deadline;
+                    onWatchdog(tasks[i].name);
+                    return;
+                }
+            }
+        }
+
+        if (wakeUs > untilUs) {
+            simClockUs = untilUs;
+            return;
+        }
+        if (wakeUs > simClockUs) simClockUs = wakeUs;
+
+        current = next;
+        swapcontext(&scheduler, &tasks[next].context);
+        current = -1;
+    }
+}
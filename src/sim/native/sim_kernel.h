@@ -0,0 +1,66 @@
+/*
+ * Sim Kernel - Virtual time and cooperative tasks for the Linux build
+ * Stands in for FreeRTOS under the simulator's Arduino shim. Every task
+ * runs on its own ucontext stack, one at a time, and only gives up the
+ * CPU by sleeping (delay(), vTaskDelay(), a blocking scan). The scheduler
+ * then moves the clock straight to the earliest wake-up, so idle time
+ * costs nothing and days of operation replay in seconds.
+ *
+ * Code between sleeps runs in zero virtual time: CPU cost is not modelled,
+ * and a task that spins without sleeping hangs the simulator. Wake-up ties
+ * go to the task created first, so a run is fully deterministic.
+ *
+ * Task notifications are counting semaphores per task, as FreeRTOS's
+ * xTaskNotifyGive()/ulTaskNotifyTake(): a give wakes a waiting task at the
+ * current time.
+ *
+ * The task watchdog is modelled: a subscribed task that does not feed it
+ * within the timeout (virtual time) ends the run through onWatchdog.
+ */
+
+#ifndef SIM_KERNEL_H
+#define SIM_KERNEL_H
+
+#include <stdint.h>
+
+#define SIM_MAX_TASKS 8
+#define SIM_TASK_STACK (256 * 1024)     // Host code needs far more than the ESP32 budgets
+
+typedef void (*SimTaskFn)(void* param);
+typedef void (*SimWatchdogFn)(const char* taskName);
+
+extern uint64_t simClockUs;             // Device clock, 0 at boot
+extern uint64_t simBootWorldUs;         // World time of this boot (simulation timeline)
+
+inline uint64_t simNowUs() {
+    return simClockUs;
+}
+
+inline uint64_t simWorldUs() {
+    return simBootWorldUs + simClockUs;
+}
+
+// Sleep the calling task; outside a task just advances the clock
+void simSleepUs(uint64_t us);
+
+// Returns a task handle, NULL when SIM_MAX_TASKS are running
+void* simCreateTask(SimTaskFn fn, const char* name, void* param);
+void* simCurrentTask();
+const char* simTaskName(void* task);
+
+// Add one to `task`'s notification count, waking it if it waits
+void simNotifyGive(void* task);
+
+// Wait up to `timeoutUs` (UINT64_MAX: forever) for a notification. Returns
+// the count before taking: all of it when `clear`, otherwise one.
+uint32_t simNotifyTake(bool clear, uint64_t timeoutUs);
+
+void simWatchdogBegin(uint32_t timeoutS);
+void simWatchdogAdd();
+void simWatchdogReset();
+
+// Run the tasks until the clock would pass `untilUs`, or the watchdog
+// fires (onWatchdog is called from the scheduler, then simRun returns)
+void simRun(uint64_t untilUs, SimWatchdogFn onWatchdog);
+
+#endif // SIM_KERNEL_H
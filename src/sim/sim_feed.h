@@ -0,0 +1,263 @@
+/*
+ * Sim Feed - Synthetic BLE advert traffic for the Linux simulator
+ * Deterministic for a given seed, on the world timeline (simWorldUs()),
+ * so a restarted simulator regenerates the same traffic and skips ahead.
+ *
+ * Paired phones cycle through
+ *   away      silent, 20 min .. 6 h
+ *   approach  20 s, RSSI ramps -100 -> -65 dBm
+ *   near      2 .. 90 min around -65 dBm (+/- 8)
+ *   leave     20 s, RSSI ramps -65 -> -100 dBm
+ * advertising every advertMs (+/- 10%) with a new RPA every 15 min.
+ * Adverts below SIM_RSSI_FLOOR are never received.
+ *
+ * Other devices send foreignPerSec adverts at random RSSI: 70% public or
+ * static addresses (pre-filtered by the firmware), 30% RPAs of
+ * SIM_FOREIGN_DEVICES unpaired phones (cost a full AES pass each).
+ */
+
+#ifndef SIM_FEED_H
+#define SIM_FEED_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include "rpa.h"
+#include "storage.h"
+
+#define SIM_FOREIGN_DEVICES 8
+#define SIM_RPA_ROTATE_US (15ULL * 60 * 1000000)
+#define SIM_RAMP_US (20ULL * 1000000)
+#define SIM_NEAR_RSSI -65
+#define SIM_FAR_RSSI -100
+#define SIM_RSSI_FLOOR -98
+
+struct SimScenario {
+    int phones;                 // Paired phones, 1..MAX_DEVICES
+    uint32_t advertMs;          // Phone advertising interval
+    double foreignPerSec;       // Adverts from unpaired devices
+    uint32_t seed;
+};
+
+struct SimAdvert {
+    uint64_t worldUs;
+    uint8_t address[6];
+    int8_t rssi;
+    int8_t phone;               // Paired phone that sent it, -1 = other device
+};
+
+class SimFeed {
+private:
+    enum PhoneState { AWAY, APPROACH, NEAR, LEAVE };
+
+    struct Phone {
+        uint8_t irk[16];
+        uint8_t rpa[6];
+        uint64_t rpaEpoch;
+        PhoneState state;
+        uint64_t stateStartUs;
+        uint64_t stateEndUs;
+        uint64_t nextUs;        // Next advert (or state change while away)
+    };
+
+    SimScenario scenario;
+    uint64_t rng = 1;
+    Phone phones[MAX_DEVICES];
+    uint8_t foreignIrks[SIM_FOREIGN_DEVICES][16];
+    uint8_t foreignRpas[SIM_FOREIGN_DEVICES][6];
+    uint64_t foreignEpoch = UINT64_MAX;
+    uint64_t foreignNextUs = 0;
+
+    // Ground truth for the simulator's report
+    uint32_t arrivals = 0;
+    uint32_t departures = 0;
+    uint32_t sent = 0;
+
+    // xorshift64*
+    uint64_t nextRandom() {
+        rng ^= rng >> 12;
+        rng ^= rng << 25;
+        rng ^= rng >> 27;
+        return rng * 2685821657736338717ULL;
+    }
+
+    uint64_t uniform(uint64_t lo, uint64_t hi) {
+        return lo + nextRandom() % (hi - lo + 1);
+    }
+
+    uint64_t minutesUs(uint64_t minutes) {
+        return minutes * 60 * 1000000;
+    }
+
+    void enter(Phone& p, PhoneState state, uint64_t atUs) {
+        p.state = state;
+        p.stateStartUs = atUs;
+        switch (state) {
+            case AWAY:
+                p.stateEndUs = atUs + uniform(minutesUs(20), minutesUs(360));
+                p.nextUs = p.stateEndUs;
+                break;
+            case APPROACH:
+                arrivals++;
+                p.stateEndUs = atUs + SIM_RAMP_US;
+                p.nextUs = atUs;
+                break;
+            case NEAR:
+                p.stateEndUs = atUs + uniform(minutesUs(2), minutesUs(90));
+                p.nextUs = atUs;
+                break;
+            case LEAVE:
+                departures++;
+                p.stateEndUs = atUs + SIM_RAMP_US;
+                p.nextUs = atUs;
+                break;
+        }
+    }
+
+    int phoneRssi(Phone& p, uint64_t atUs) {
+        int noise;
+        double f = (double)(atUs - p.stateStartUs) / SIM_RAMP_US;
+        switch (p.state) {
+            case APPROACH:
+                noise = (int)uniform(0, 6) - 3;
+                return (int)lround(SIM_FAR_RSSI + f * (SIM_NEAR_RSSI - SIM_FAR_RSSI)) + noise;
+            case LEAVE:
+                noise = (int)uniform(0, 6) - 3;
+                return (int)lround(SIM_NEAR_RSSI + f * (SIM_FAR_RSSI - SIM_NEAR_RSSI)) + noise;
+            default:
+                return SIM_NEAR_RSSI + (int)uniform(0, 16) - 8;
+        }
+    }
+
+    void rotatePhone(Phone& p, int index, uint64_t atUs) {
+        uint64_t epoch = atUs / SIM_RPA_ROTATE_US;
+        if (epoch == p.rpaEpoch) return;
+        p.rpaEpoch = epoch;
+        makeRPA(p.irk, (uint32_t)(epoch * 131 + index * 7919 + scenario.seed), p.rpa);
+    }
+
+    void rotateForeign(uint64_t atUs) {
+        uint64_t epoch = atUs / SIM_RPA_ROTATE_US;
+        if (epoch == foreignEpoch) return;
+        foreignEpoch = epoch;
+        for (int f = 0; f < SIM_FOREIGN_DEVICES; f++) {
+            makeRPA(foreignIrks[f], (uint32_t)(epoch * 977 + f * 104729 + scenario.seed), foreignRpas[f]);
+        }
+    }
+
+    uint64_t foreignGapUs() {
+        // Exponential inter-arrival times (Poisson process)
+        double u = (double)((nextRandom() >> 11) + 1) / 9007199254740993.0;
+        return (uint64_t)(-log(u) / scenario.foreignPerSec * 1e6) + 1;
+    }
+
+    // Index of the phone with the earliest pending event, or -1 for foreign
+    int nextSource() {
+        int best = -1;
+        uint64_t bestUs = scenario.foreignPerSec > 0 ? foreignNextUs : UINT64_MAX;
+        for (int i = 0; i < scenario.phones; i++) {
+            if (phones[i].nextUs < bestUs) {
+                best = i;
+                bestUs = phones[i].nextUs;
+            }
+        }
+        return best;
+    }
+
+public:
+    // Fixed IRK of paired phone `index` (the simulator stores it in NVS)
+    static void phoneIrk(uint32_t seed, int index, uint8_t irk[16]) {
+        for (int i = 0; i < 16; i++) irk[i] = (uint8_t)(seed * 37 + index * 61 + i * 13 + 5);
+    }
+
+    void begin(const SimScenario& s) {
+        scenario = s;
+        rng = s.seed * 0x9E3779B97F4A7C15ULL + 1;
+        for (int f = 0; f < SIM_FOREIGN_DEVICES; f++) {
+            for (int i = 0; i < 16; i++) foreignIrks[f][i] = (uint8_t)nextRandom();
+        }
+        for (int i = 0; i < scenario.phones; i++) {
+            phoneIrk(s.seed, i, phones[i].irk);
+            phones[i].rpaEpoch = UINT64_MAX;
+            enter(phones[i], AWAY, 0);
+            // First arrival within the first half hour
+            phones[i].stateEndUs = phones[i].nextUs = uniform(minutesUs(1), minutesUs(30));
+        }
+        foreignNextUs = scenario.foreignPerSec > 0 ? foreignGapUs() : UINT64_MAX;
+    }
+
+    // Time of the next event, UINT64_MAX if there is none
+    uint64_t peekUs() {
+        int source = nextSource();
+        return source < 0 ? foreignNextUs : phones[source].nextUs;
+    }
+
+    // Next advert at or before `untilUs`; false if nothing is sent by then
+    bool next(uint64_t untilUs, SimAdvert* out) {
+        for (;;) {
+            int source = nextSource();
+            uint64_t atUs = source < 0 ? foreignNextUs : phones[source].nextUs;
+            if (atUs > untilUs) return false;
+
+            if (source < 0) {
+                foreignNextUs = atUs + foreignGapUs();
+                out->worldUs = atUs;
+                out->phone = -1;
+                out->rssi = (int8_t)(SIM_FAR_RSSI + (int)uniform(0, 50));
+                uint64_t kind = nextRandom() % 10;
+                if (kind < 3) {
+                    rotateForeign(atUs);
+                    memcpy(out->address, foreignRpas[nextRandom() % SIM_FOREIGN_DEVICES], 6);
+                } else {
+                    uint64_t r = nextRandom();
+                    for (int i = 0; i < 6; i++) out->address[i] = (uint8_t)(r >> (i * 8));
+                    out->address[0] = (out->address[0] & 0x3F) | (kind < 7 ? 0xC0 : 0x00);
+                }
+                sent++;
+                return true;
+            }
+
+            Phone& p = phones[source];
+            if (atUs >= p.stateEndUs) {
+                PhoneState following = p.state == AWAY ? APPROACH : p.state == APPROACH ? NEAR
+                                     : p.state == NEAR ? LEAVE : AWAY;
+                enter(p, following, p.stateEndUs);
+                continue;
+            }
+
+            uint64_t jitter = scenario.advertMs * 100;  // +/- 10%
+            p.nextUs = atUs + scenario.advertMs * 1000 - jitter + uniform(0, 2 * jitter);
+            int rssi = phoneRssi(p, atUs);
+            if (rssi < SIM_RSSI_FLOOR) continue;
+
+            rotatePhone(p, source, atUs);
+            out->worldUs = atUs;
+            memcpy(out->address, p.rpa, 6);
+            out->rssi = (int8_t)rssi;
+            out->phone = (int8_t)source;
+            sent++;
+            return true;
+        }
+    }
+
+    // Generate and drop everything sent before `worldUs`
+    void skipTo(uint64_t worldUs) {
+        SimAdvert a;
+        while (worldUs > 0 && next(worldUs - 1, &a)) {
+        }
+    }
+
+    uint32_t getArrivals() {
+        return arrivals;
+    }
+
+    uint32_t getDepartures() {
+        return departures;
+    }
+
+    uint32_t getSent() {
+        return sent;
+    }
+};
+
+#endif // SIM_FEED_H
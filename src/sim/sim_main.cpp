@@ -0,0 +1,407 @@
+/*
+ * Keyless Simulator - The firmware's setup()/loop() as a Linux process
+ * Linux build entry point (pio run -e linux). main.cpp runs unchanged on
+ * the Linux HAL: virtual time, recorded GPIO, adverts from SimFeed, NVS in
+ * files under the state directory.
+ *
+ *   program                       one simulated day, one paired phone
+ *   program --days 7 --quiet      a week, summary only
+ *   program --phones 3 --foreign 60 --advert-ms 150 --seed 7
+ *   program --state DIR           NVS files and restart state (default sim_state)
+ *   program --phones 3 --days 3 --delete-phone 2 --delete-at 40
+ *                                 dashboard deletes phone 2 after 40 h (checked)
+ *   program --phones 1 --hours 3 --delete-phone 1 --delete-at 1
+ *                                 deletes the only phone (stays gone)
+ *
+ * Every run starts from a freshly flashed device with the phones already
+ * paired (IRKs in NVS and the legacy EEPROM backup), so the first boot goes through the 30 s pairing
+ * window and restarts into keyless mode like a power-on on the car.
+ * hal.restart() and the task watchdog re-execute the process with
+ * --resume; the feed is regenerated from the seed and skips ahead.
+ *
+ * --delete-phone asks main.cpp to delete that phone's device as the
+ * dashboard would. On the boot after the delete's restart the run checks
+ * that the phone is gone, every other phone still resolves to its stored
+ * index (the key of the RSSI history, profiles and usage) and every other
+ * learned profile is byte-identical, and at the end of the run that every
+ * RSSI history sample came from the phone at that index; the exit status
+ * is 1 otherwise.
+ */
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <EEPROM.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#include <vector>
+#include "hal.h"
+#include "storage.h"
+#include "metrics.h"
+#include "sim_feed.h"
+#include "rssi_series.h"
+
+#define SIM_STATE_MAGIC 0x53494D31      // "SIM1"
+#define SIM_REBOOT_US 300000            // Reset to setup(), as on the ESP32
+#define SIM_SENT_KEPT 1024              // Latest adverts per phone, for the RSSI history check
+
+void setup();
+void loop();
+int verifyRPA(const uint8_t* rpaAddress);
+bool requestDeviceDelete(int index);
+void syncKnownDevices();
+void saveDevicesToEEPROM();
+
+extern Storage storage;
+
+// Survives restarts in <state>/sim.state (the simulator's RTC memory)
+struct SimCarry {
+    uint32_t magic;
+    uint64_t worldUs;                   // World time of the next boot
+    uint64_t endWorldUs;
+    HalResetReason reason;
+    uint32_t boots;
+    uint32_t softwareResets;
+    uint32_t watchdogResets;
+    uint32_t heard;
+    uint32_t risingEdges[HAL_LINUX_PINS];
+    double wallSeconds;
+    uint32_t deleteStage;               // DeleteStage
+    uint32_t profileHash[MAX_DEVICES];  // Per phone, when the delete was asked for
+};
+
+enum DeleteStage {
+    DELETE_NONE,
+    DELETE_REQUESTED,
+    DELETE_CHECKED,
+    DELETE_FAILED
+};
+
+static SimCarry carry;
+static SimScenario scenario = {1, 300, 20.0, 1};
+static SimFeed feed;
+static int deletePhone = 0;             // 1-based, 0 = no delete
+static double deleteAtHours = 0;
+static int rssiSamplesChecked = 0;
+
+// What each phone sent this boot (device clock), newest last
+struct SentAdverts {
+    uint32_t ms[SIM_SENT_KEPT];
+    int8_t rssi[SIM_SENT_KEPT];
+    uint32_t count;
+};
+static SentAdverts sentAdverts[MAX_DEVICES];
+static std::vector<char*> processArgs;
+static std::chrono::steady_clock::time_point wallStart;
+static bool quiet = false;
+
+static std::string statePath(const char* file) {
+    return simStateDir() + "/" + file;
+}
+
+static double wallSecondsNow() {
+    return carry.wallSeconds +
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+}
+
+// ========== HAL hooks ==========
+
+static bool nextAdvert(uint64_t untilUs, HalAdvert* out) {
+    SimAdvert a;
+    if (!feed.next(simBootWorldUs + untilUs, &a)) return false;
+    out->timeUs = a.worldUs - simBootWorldUs;
+    memcpy(out->address, a.address, 6);
+    out->rssi = a.rssi;
+    if (a.phone >= 0) {
+        SentAdverts& s = sentAdverts[a.phone];
+        s.ms[s.count % SIM_SENT_KEPT] = (uint32_t)(out->timeUs / 1000);
+        s.rssi[s.count % SIM_SENT_KEPT] = a.rssi;
+        s.count++;
+    }
+    return true;
+}
+
+static void onPin(uint8_t pin, uint8_t level) {
+    if (level == HIGH) carry.risingEdges[pin]++;
+}
+
+static void restartProcess(HalResetReason reason) {
+    carry.worldUs = simWorldUs() + SIM_REBOOT_US;
+    carry.reason = reason;
+    if (reason == HAL_RESET_WATCHDOG) carry.watchdogResets++;
+    else carry.softwareResets++;
+    carry.heard += hal.getHeard();
+    carry.wallSeconds = wallSecondsNow();
+
+    FILE* f = fopen(statePath("sim.state").c_str(), "wb");
+    if (!f || fwrite(&carry, sizeof(carry), 1, f) != 1) {
+        fprintf(stderr, "sim: cannot write %s\n", statePath("sim.state").c_str());
+        exit(1);
+    }
+    fclose(f);
+    fflush(stdout);
+
+    execv("/proc/self/exe", processArgs.data());
+    fprintf(stderr, "sim: restart failed (%s)\n", strerror(errno));
+    exit(1);
+}
+
+static void onWatchdog(const char* taskName) {
+    Serial.printf("E (sim) task_wdt: Task watchdog got triggered, %s did not reset it\n", taskName);
+    restartProcess(HAL_RESET_WATCHDOG);
+}
+
+static void loopTask(void*) {
+    setup();
+    for (;;) {
+        loop();
+    }
+}
+
+// ========== Device delete (--delete-phone) ==========
+
+static uint32_t profileHash(const RssiProfile& profile) {
+    uint32_t hash = 2166136261u;        // FNV-1a
+    const uint8_t* bytes = (const uint8_t*)&profile;
+    for (size_t i = 0; i < sizeof(profile); i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Stored device of a phone (0-based), by IRK; -1 if none
+static int storedIndexOf(int phone) {
+    uint8_t irk[16];
+    SimFeed::phoneIrk(scenario.seed, phone, irk);
+    for (int i = 0; i < storage.deviceCount; i++) {
+        if (memcmp(storage.devices[i].irk, irk, 16) == 0) return i;
+    }
+    return -1;
+}
+
+// Index the firmware's resolver gives an advert of the phone
+static int resolvedIndexOf(int phone) {
+    uint8_t irk[16];
+    uint8_t rpa[6];
+    SimFeed::phoneIrk(scenario.seed, phone, irk);
+    makeRPA(irk, 0x5EED + phone, rpa);
+    return verifyRPA(rpa);
+}
+
+static bool checkDelete() {
+    int deleted = deletePhone - 1;
+    bool ok = storage.deviceCount == scenario.phones - 1 && storedIndexOf(deleted) < 0 &&
+        resolvedIndexOf(deleted) < 0;
+    for (int p = 0; p < scenario.phones && ok; p++) {
+        if (p == deleted) continue;
+        int index = storedIndexOf(p);
+        ok = index >= 0 && resolvedIndexOf(p) == index &&
+            profileHash(storage.devices[index].profile) == carry.profileHash[p];
+    }
+    return ok;
+}
+
+// Did `phone` send an advert at `rssi` within a second of `ms`?
+static bool phoneSent(int phone, uint32_t ms, int rssi) {
+    const SentAdverts& s = sentAdverts[phone];
+    uint32_t kept = s.count < SIM_SENT_KEPT ? s.count : SIM_SENT_KEPT;
+    for (uint32_t k = 0; k < kept; k++) {
+        uint32_t i = (s.count - 1 - k) % SIM_SENT_KEPT;
+        uint32_t gap = ms > s.ms[i] ? ms - s.ms[i] : s.ms[i] - ms;
+        if (gap <= 1000 && s.rssi[i] == rssi) return true;
+    }
+    return false;
+}
+
+// End of the run: every raw sample in a phone's RSSI history (what
+// /api/devices/{id}/rssi serves for its stored index) is one of its adverts
+static bool checkRssiHistory() {
+    uint32_t now = millis();
+    for (int p = 0; p < scenario.phones; p++) {
+        int index = storedIndexOf(p);
+        if (index < 0) continue;
+        uint32_t ages[RSSI_SERIES_RAW];
+        int8_t rssi[RSSI_SERIES_RAW];
+        int n = rssiSeries.readRaw(index, now, ages, rssi, RSSI_SERIES_RAW);
+        for (int k = 0; k < n; k++) {
+            if (!phoneSent(p, now - ages[k], rssi[k])) return false;
+            rssiSamplesChecked++;
+        }
+    }
+    return true;
+}
+
+// Plays the dashboard: asks for the delete at --delete-at, then checks the
+// boot after the delete's restart
+static void deleteTask(void*) {
+    if (carry.deleteStage == DELETE_NONE) {
+        uint64_t atUs = (uint64_t)(deleteAtHours * 3600e6);
+        if (atUs > simWorldUs()) simSleepUs(atUs - simWorldUs());
+        for (int p = 0; p < scenario.phones; p++) {
+            int index = storedIndexOf(p);
+            carry.profileHash[p] = index >= 0 ? profileHash(storage.devices[index].profile) : 0;
+        }
+        int index = storedIndexOf(deletePhone - 1);
+        carry.deleteStage = (index >= 0 && requestDeviceDelete(index)) ? DELETE_REQUESTED : DELETE_FAILED;
+    } else if (carry.deleteStage == DELETE_REQUESTED) {
+        simSleepUs(1000000);            // setup() is done, no session has ended yet
+        carry.deleteStage = checkDelete() ? DELETE_CHECKED : DELETE_FAILED;
+    }
+}
+
+// ========== Report ==========
+
+static void formatWorldTime(uint64_t us, char* text, size_t size) {
+    uint64_t s = us / 1000000;
+    snprintf(text, size, "%lud %02lu:%02lu:%02lu", (unsigned long)(s / 86400),
+        (unsigned long)(s / 3600 % 24), (unsigned long)(s / 60 % 60), (unsigned long)(s % 60));
+}
+
+static void printSummary() {
+    feed.skipTo(carry.endWorldUs);      // Count arrivals up to the end
+    double wall = wallSecondsNow();
+    char simulated[32];
+    formatWorldTime(carry.endWorldUs, simulated, sizeof(simulated));
+
+    printf("\n=== Simulated %s in %.1f s (%.0fx real time) ===\n", simulated, wall,
+        wall > 0 ? carry.endWorldUs / 1e6 / wall : 0);
+    printf("Boots:      %lu (%lu software resets, %lu watchdog resets)\n", (unsigned long)carry.boots,
+        (unsigned long)carry.softwareResets, (unsigned long)carry.watchdogResets);
+    printf("Phones:     %lu arrivals, %lu departures\n", (unsigned long)feed.getArrivals(),
+        (unsigned long)feed.getDepartures());
+    printf("Adverts:    %lu sent, %lu heard, %lu missed (scan duty, between scans, not scanning)\n",
+        (unsigned long)feed.getSent(), (unsigned long)(carry.heard + hal.getHeard()),
+        (unsigned long)(feed.getSent() - carry.heard - hal.getHeard()));
+    printf("GPIO:       rising edges");
+    for (int pin = 0; pin < HAL_LINUX_PINS; pin++) {
+        if (carry.risingEdges[pin]) printf("  pin %d: %lu", pin, (unsigned long)carry.risingEdges[pin]);
+    }
+    printf("\n");
+    printf("Last boot:  %lu unlocks, %lu locks, %lu AES ops\n", (unsigned long)metrics.unlocks.get(),
+        (unsigned long)metrics.locks.get(), (unsigned long)metrics.aesResolutions.get());
+    printf("Audit log:  %lu entries written (NVS)\n", (unsigned long)(storage.getNextSeq() - 1));
+    if (deletePhone) {
+        static const char* const RESULTS[] = {
+            "not reached", "requested, no restart followed",
+            "tables rebuilt, other phones' indices and profiles unchanged", "FAILED"
+        };
+        printf("Delete:     phone %d at %.1f h: %s\n", deletePhone, deleteAtHours, RESULTS[carry.deleteStage]);
+        if (carry.deleteStage == DELETE_CHECKED) {
+            printf("            %d RSSI history samples, each from its own phone\n", rssiSamplesChecked);
+        }
+    }
+}
+
+// ========== Setup ==========
+
+static void usage(const char* program) {
+    fprintf(stderr, "usage: %s [--days N | --hours N] [--phones N] [--foreign PER_SEC] [--advert-ms MS]\n"
+                    "       [--seed N] [--state DIR] [--quiet] [--delete-phone N --delete-at HOURS]\n", program);
+}
+
+// Freshly flashed device with the scenario's phones paired, in NVS and
+// in the legacy EEPROM backup as pairing leaves them
+static bool prepareState() {
+    mkdir(simStateDir().c_str(), 0755);
+    remove(statePath("keyless.nvs").c_str());
+    remove(statePath("eeprom.bin").c_str());
+    remove(statePath("sim.state").c_str());
+
+    if (!storage.begin()) return false;
+    for (int i = 0; i < scenario.phones; i++) {
+        uint8_t irk[16];
+        char name[DEVICE_NAME_LEN];
+        SimFeed::phoneIrk(scenario.seed, i, irk);
+        snprintf(name, sizeof(name), "Phone_%02d", i + 1);
+        storage.addDevice(irk, name);
+    }
+    syncKnownDevices();
+    EEPROM.begin(512);                  // main.cpp's EEPROM_SIZE
+    saveDevicesToEEPROM();
+    return true;
+}
+
+static bool loadCarry() {
+    FILE* f = fopen(statePath("sim.state").c_str(), "rb");
+    if (!f) return false;
+    bool ok = fread(&carry, sizeof(carry), 1, f) == 1 && carry.magic == SIM_STATE_MAGIC;
+    fclose(f);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    double days = 1;
+    bool resume = false;
+    simStateDir() = "sim_state";
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--days") && i + 1 < argc) {
+            days = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--hours") && i + 1 < argc) {
+            days = atof(argv[++i]) / 24;
+        } else if (!strcmp(argv[i], "--phones") && i + 1 < argc) {
+            scenario.phones = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--foreign") && i + 1 < argc) {
+            scenario.foreignPerSec = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--advert-ms") && i + 1 < argc) {
+            scenario.advertMs = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            scenario.seed = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--state") && i + 1 < argc) {
+            simStateDir() = argv[++i];
+        } else if (!strcmp(argv[i], "--delete-phone") && i + 1 < argc) {
+            deletePhone = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--delete-at") && i + 1 < argc) {
+            deleteAtHours = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--quiet")) {
+            quiet = true;
+        } else if (!strcmp(argv[i], "--resume")) {
+            resume = true;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (scenario.phones < 1 || scenario.phones > MAX_DEVICES || scenario.advertMs < 20 || days <= 0 ||
+        deletePhone < 0 || deletePhone > scenario.phones) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    processArgs.assign(argv, argv + argc);
+    if (!resume) processArgs.push_back((char*)"--resume");
+    processArgs.push_back(NULL);
+
+    Serial.setQuiet(quiet);
+    if (!resume || !loadCarry()) {
+        if (!prepareState()) {
+            fprintf(stderr, "sim: cannot use state directory %s\n", simStateDir().c_str());
+            return 1;
+        }
+        memset(&carry, 0, sizeof(carry));
+        carry.magic = SIM_STATE_MAGIC;
+        carry.endWorldUs = (uint64_t)(days * 86400e6);
+        carry.reason = HAL_RESET_POWER_ON;
+    }
+    carry.boots++;
+    wallStart = std::chrono::steady_clock::now();
+
+    simBootWorldUs = carry.worldUs;
+    feed.begin(scenario);
+    feed.skipTo(carry.worldUs);
+    hal.attach(nextAdvert, onPin, restartProcess, carry.reason, scenario.seed + carry.boots);
+
+    // Arduino's loopTask: setup() once, then loop() forever
+    simCreateTask(loopTask, "loopTask", NULL);
+    if (deletePhone) simCreateTask(deleteTask, "dashboard", NULL);
+    if (carry.endWorldUs > carry.worldUs) {
+        simRun(carry.endWorldUs - carry.worldUs, onWatchdog);
+    }
+
+    if (carry.deleteStage == DELETE_CHECKED && !checkRssiHistory()) carry.deleteStage = DELETE_FAILED;
+    fflush(stdout);
+    printSummary();
+    return (deletePhone && carry.deleteStage != DELETE_CHECKED) ? 1 : 0;
+}
@@ -0,0 +1,41 @@
+/*
+ * Static Asset Module - Serving precompressed pages from flash
+ * Assets are gzipped at build time (scripts/build_web_assets.py) and sent
+ * as-is with an ETag, so repeat loads cost a 304 instead of the full page.
+ */
+
+#ifndef STATIC_ASSET_H
+#define STATIC_ASSET_H
+
+#include <WebServer.h>
+
+struct StaticAsset {
+    const uint8_t* data;        // gzip stream in PROGMEM
+    size_t length;              // Compressed size
+    size_t rawLength;           // Uncompressed size (diagnostics only)
+    const char* etag;           // Quoted content hash
+    const char* contentType;
+};
+
+// Request headers WebServer must keep for sendStaticAsset()
+static const char* STATIC_ASSET_HEADERS[] = {"If-None-Match"};
+
+// Call before server.begin()
+inline void collectStaticAssetHeaders(WebServer& server) {
+    server.collectHeaders(STATIC_ASSET_HEADERS, 1);
+}
+
+inline void sendStaticAsset(WebServer& server, const StaticAsset& asset) {
+    server.sendHeader("ETag", asset.etag);
+    server.sendHeader("Cache-Control", "no-cache");  // Always revalidate, 304 is cheap
+
+    if (server.hasHeader("If-None-Match") && server.header("If-None-Match") == asset.etag) {
+        server.send(304);
+        return;
+    }
+
+    server.sendHeader("Content-Encoding", "gzip");
+    server.send_P(200, asset.contentType, (PGM_P)asset.data, asset.length);
+}
+
+#endif // STATIC_ASSET_H
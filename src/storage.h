@@ -7,46 +7,174 @@
 #define STORAGE_H
 
 #include <Preferences.h>
-
-// Configuration
-#define MAX_DEVICES 10
-#define MAX_LOG_ENTRIES 50
+#include "keyless_config.h"
+#include "rssi_profile.h"
+#include "log_index.h"
+#include "rollup.h"
+
+// Configuration (MAX_DEVICES comes from keyless_config.h)
+#ifndef KEYLESS_LOG_ENTRIES
+#define KEYLESS_LOG_ENTRIES 128
+#endif
+#define MAX_LOG_ENTRIES KEYLESS_LOG_ENTRIES
+#define LOG_PAGE_ENTRIES 32     // Entries per NVS blob ("logP<n>"), rewritten as a unit
+#define LOG_PAGES (MAX_LOG_ENTRIES / LOG_PAGE_ENTRIES)
+#define LEGACY_LOG_ENTRIES 50   // Ring size of the "logBuf" / "logBuf2" layouts
 #define DEVICE_NAME_LEN 20
 
+static_assert(MAX_LOG_ENTRIES % LOG_PAGE_ENTRIES == 0, "log ring must be whole NVS pages");
+
 // Device structure (extended with name)
 struct StoredDevice {
     uint8_t irk[16];
     char name[DEVICE_NAME_LEN];
     bool active;
+    RssiProfile profile;    // Learned signal levels (rssi_profile.h)
 };
 
 // Log entry structure
 struct LogEntry {
+    uint32_t seq;           // Monotonic sequence number (first entry = 1)
     uint32_t timestamp;     // millis() at event time
+    uint32_t unixTime;      // Wall clock (s) at event time, 0 = before NTP sync
     uint8_t deviceIndex;    // Which device (0-9)
     uint8_t action;         // 0=Lock, 1=Unlock
     int8_t rssi;            // Signal strength
+    uint8_t reserved;
 };
 
-// Settings structure
-struct KeylessSettings {
-    int8_t rssiUnlockThreshold;   // Default: -90
-    int8_t rssiLockThreshold;     // Default: -80
-    uint8_t proximityTimeout;     // Default: 10 (seconds)
-    uint8_t weakSignalThreshold;  // Default: 3
+// Log entry layout before wall-clock time (NVS key "logBuf2")
+struct SeqLogEntry {
+    uint32_t seq;
+    uint32_t timestamp;
+    uint8_t deviceIndex;
+    uint8_t action;
+    int8_t rssi;
+};
+
+// Log entry layout before sequence numbers (NVS key "logBuf")
+struct LegacyLogEntry {
+    uint32_t timestamp;
+    uint8_t deviceIndex;
+    uint8_t action;
+    int8_t rssi;
 };
 
 class Storage {
 private:
     Preferences prefs;
+    portMUX_TYPE logMux = portMUX_INITIALIZER_UNLOCKED;
+
+    // Filters over the log ring (log_index.h), under logMux
+    LogIndex<MAX_LOG_ENTRIES, MAX_DEVICES> logIndex;
+
+    // Entry with sequence number seq lives in slot (seq - 1) % MAX_LOG_ENTRIES
+    static int slotForSeq(uint32_t seq) {
+        return (seq - 1) % MAX_LOG_ENTRIES;
+    }
+
+    // Into its slot if it is among the newest MAX_LOG_ENTRIES before logNextSeq
+    void placeLogEntry(const LogEntry& e) {
+        if (e.seq == 0 || e.seq >= logNextSeq || logNextSeq - e.seq > MAX_LOG_ENTRIES) return;
+        logBuffer[slotForSeq(e.seq)] = e;
+    }
+
+    void saveLogPage(int page) {
+        char key[16];
+        snprintf(key, sizeof(key), "logP%d", page);
+        prefs.putBytes(key, &logBuffer[page * LOG_PAGE_ENTRIES], LOG_PAGE_ENTRIES * sizeof(LogEntry));
+    }
+
+    void saveLogPages() {
+        prefs.putUInt("logSeq", logNextSeq);
+        prefs.putUInt("logCap", MAX_LOG_ENTRIES);
+        for (int p = 0; p < LOG_PAGES; p++) saveLogPage(p);
+    }
+
+    // Paged ring, possibly written with another KEYLESS_LOG_ENTRIES
+    void loadLogPages() {
+        logNextSeq = prefs.getUInt("logSeq", 1);
+        if (logNextSeq == 0) logNextSeq = 1;
+        uint32_t cap = prefs.getUInt("logCap", MAX_LOG_ENTRIES);
+
+        LogEntry page[LOG_PAGE_ENTRIES];
+        for (uint32_t p = 0; p * LOG_PAGE_ENTRIES < cap; p++) {
+            char key[16];
+            snprintf(key, sizeof(key), "logP%lu", (unsigned long)p);
+            if (prefs.getBytes(key, page, sizeof(page)) != sizeof(page)) continue;
+            for (int i = 0; i < LOG_PAGE_ENTRIES; i++) placeLogEntry(page[i]);
+        }
+
+        if (cap != MAX_LOG_ENTRIES) {
+            for (uint32_t p = LOG_PAGES; p * LOG_PAGE_ENTRIES < cap; p++) {
+                char key[16];
+                snprintf(key, sizeof(key), "logP%lu", (unsigned long)p);
+                prefs.remove(key);
+            }
+            saveLogPages();
+            Serial.printf("Log ring resized %lu -> %d entries\n", (unsigned long)cap, MAX_LOG_ENTRIES);
+        }
+    }
+
+    // Convert the sequenced log without wall-clock time ("logBuf2") once
+    void migrateSeqLog() {
+        logNextSeq = prefs.getUInt("logSeq", 1);
+        if (logNextSeq == 0) logNextSeq = 1;
+
+        SeqLogEntry old[LEGACY_LOG_ENTRIES];
+        if (prefs.getBytes("logBuf2", old, sizeof(old)) == sizeof(old)) {
+            for (int i = 0; i < LEGACY_LOG_ENTRIES; i++) {
+                LogEntry e = {old[i].seq, old[i].timestamp, 0, old[i].deviceIndex, old[i].action, old[i].rssi, 0};
+                placeLogEntry(e);
+            }
+            Serial.println("Migrated log to paged format");
+        }
+
+        prefs.remove("logBuf2");
+        saveLogPages();
+    }
+
+    // Convert the pre-sequence log (logHead/logCount + "logBuf") once
+    void migrateLegacyLog() {
+        uint8_t head = prefs.getUChar("logHead", 0);
+        uint8_t count = prefs.getUChar("logCount", 0);
+        if (count > LEGACY_LOG_ENTRIES || head >= LEGACY_LOG_ENTRIES) count = 0;
+
+        LegacyLogEntry legacy[LEGACY_LOG_ENTRIES];
+        if (count > 0 && prefs.getBytes("logBuf", legacy, sizeof(legacy)) == sizeof(legacy)) {
+            logNextSeq = count + 1;
+            int start = (count < LEGACY_LOG_ENTRIES) ? 0 : head;
+            for (int i = 0; i < count; i++) {
+                const LegacyLogEntry& old = legacy[(start + i) % LEGACY_LOG_ENTRIES];
+                LogEntry e = {(uint32_t)(i + 1), old.timestamp, 0, old.deviceIndex, old.action, old.rssi, 0};
+                placeLogEntry(e);
+            }
+            Serial.printf("Migrated %d log entries to sequenced format\n", count);
+        }
+
+        prefs.remove("logHead");
+        prefs.remove("logCount");
+        prefs.remove("logBuf");
+        saveLogPages();
+    }
+
+    // Index over every retained entry, oldest first (boot, NTP backfill)
+    void rebuildLogIndex() {
+        LogEntry none = {};
+        logIndex.clear();
+        for (uint32_t seq = logNextSeq - logCount; seq < logNextSeq; seq++) {
+            logIndex.add(logBuffer[slotForSeq(seq)], none);
+        }
+    }
 
 public:
     StoredDevice devices[MAX_DEVICES];
     int deviceCount = 0;
 
     LogEntry logBuffer[MAX_LOG_ENTRIES];
-    uint8_t logHead = 0;    // Next write position
-    uint8_t logCount = 0;   // Total entries (max 50)
+    uint32_t logNextSeq = 1;  // Sequence number of the next entry
+    uint32_t bootSeq = 1;     // First sequence number logged in this boot
+    uint16_t logCount = 0;    // Retained entries (max MAX_LOG_ENTRIES)
 
     // Settings with defaults
     KeylessSettings settings = {-90, -80, 10, 3};
@@ -78,6 +206,12 @@ public:
             // Load active state
             snprintf(key, sizeof(key), "act%d", i);
             devices[i].active = prefs.getBool(key, true);
+
+            // Load learned profile (none yet, or an older layout: start over)
+            snprintf(key, sizeof(key), "prof%d", i);
+            if (prefs.getBytes(key, &devices[i].profile, sizeof(RssiProfile)) != sizeof(RssiProfile)) {
+                devices[i].profile.reset();
+            }
         }
 
         return deviceCount > 0;
@@ -97,9 +231,37 @@ public:
 
             snprintf(key, sizeof(key), "act%d", i);
             prefs.putBool(key, devices[i].active);
+
+            snprintf(key, sizeof(key), "prof%d", i);
+            prefs.putBytes(key, &devices[i].profile, sizeof(RssiProfile));
         }
     }
 
+    // Profile copy taken under the learner's lock (ProfileLearner::takeDirty)
+    void saveProfile(int index, const RssiProfile& profile) {
+        if (index < 0 || index >= deviceCount) return;
+
+        char key[16];
+        snprintf(key, sizeof(key), "prof%d", index);
+        prefs.putBytes(key, &profile, sizeof(RssiProfile));
+    }
+
+    // Usage aggregates of one device (rollup.h); false if none or an older layout
+    bool loadRollup(int index, DeviceRollup* blob) {
+        char key[16];
+        snprintf(key, sizeof(key), "roll%d", index);
+        return prefs.getBytes(key, blob, sizeof(DeviceRollup)) == sizeof(DeviceRollup);
+    }
+
+    // Blob copy taken under the rollup's lock (UsageRollup::takeDirty)
+    void saveRollup(int index, const DeviceRollup& blob) {
+        if (index < 0 || index >= deviceCount) return;
+
+        char key[16];
+        snprintf(key, sizeof(key), "roll%d", index);
+        prefs.putBytes(key, &blob, sizeof(DeviceRollup));
+    }
+
     bool addDevice(uint8_t* irk, const char* name) {
         if (deviceCount >= MAX_DEVICES) return false;
 
@@ -111,9 +273,14 @@ public:
         }
 
         memcpy(devices[deviceCount].irk, irk, 16);
-        strncpy(devices[deviceCount].name, name, DEVICE_NAME_LEN - 1);
-        devices[deviceCount].name[DEVICE_NAME_LEN - 1] = '\0';
+        snprintf(devices[deviceCount].name, DEVICE_NAME_LEN, "%s", name);
         devices[deviceCount].active = true;
+        devices[deviceCount].profile.reset();
+
+        // Usage of a device that used to sit in this slot
+        char key[16];
+        snprintf(key, sizeof(key), "roll%d", deviceCount);
+        if (prefs.isKey(key)) prefs.remove(key);
         deviceCount++;
 
         saveDevices();
@@ -136,10 +303,18 @@ public:
     bool deleteDevice(int index) {
         if (index < 0 || index >= deviceCount) return false;
 
-        // Shift remaining devices
+        // Shift remaining devices, and their usage aggregates with them
+        DeviceRollup blob;
         for (int i = index; i < deviceCount - 1; i++) {
             memcpy(&devices[i], &devices[i + 1], sizeof(StoredDevice));
+            char key[16];
+            snprintf(key, sizeof(key), "roll%d", i);
+            if (loadRollup(i + 1, &blob)) prefs.putBytes(key, &blob, sizeof(DeviceRollup));
+            else if (prefs.isKey(key)) prefs.remove(key);
         }
+        char key[16];
+        snprintf(key, sizeof(key), "roll%d", deviceCount - 1);
+        if (prefs.isKey(key)) prefs.remove(key);
         deviceCount--;
 
         saveDevices();
@@ -149,51 +324,103 @@ public:
     // ========== Audit Log Storage ==========
 
     void loadLog() {
-        logHead = prefs.getUChar("logHead", 0);
-        logCount = prefs.getUChar("logCount", 0);
+        memset(logBuffer, 0, sizeof(logBuffer));
+        logNextSeq = 1;
 
-        if (logCount > MAX_LOG_ENTRIES) logCount = 0;
-        if (logHead >= MAX_LOG_ENTRIES) logHead = 0;
+        if (prefs.isKey("logP0")) {
+            loadLogPages();
+        } else if (prefs.isKey("logBuf2")) {
+            migrateSeqLog();
+        } else {
+            migrateLegacyLog();
+        }
 
-        prefs.getBytes("logBuf", logBuffer, sizeof(logBuffer));
+        // Newest entries back to the first gap (missing page, smaller old ring)
+        logCount = 0;
+        while (logCount < MAX_LOG_ENTRIES && logCount < logNextSeq - 1) {
+            uint32_t seq = logNextSeq - 1 - logCount;
+            if (logBuffer[slotForSeq(seq)].seq != seq) break;
+            logCount++;
+        }
+        bootSeq = logNextSeq;
+        rebuildLogIndex();
     }
 
-    void addLogEntry(uint8_t deviceIndex, uint8_t action, int8_t rssi, uint32_t timestamp) {
-        logBuffer[logHead].timestamp = timestamp;
-        logBuffer[logHead].deviceIndex = deviceIndex;
-        logBuffer[logHead].action = action;
-        logBuffer[logHead].rssi = rssi;
-
-        logHead = (logHead + 1) % MAX_LOG_ENTRIES;
+    void addLogEntry(uint8_t deviceIndex, uint8_t action, int8_t rssi, uint32_t timestamp, uint32_t unixTime = 0) {
+        portENTER_CRITICAL(&logMux);
+        int slot = slotForSeq(logNextSeq);
+        LogEntry evicted = logBuffer[slot];
+        if (logCount < MAX_LOG_ENTRIES) evicted.seq = 0;
+        LogEntry& e = logBuffer[slot];
+        e.seq = logNextSeq;
+        e.timestamp = timestamp;
+        e.unixTime = unixTime;
+        e.deviceIndex = deviceIndex;
+        e.action = action;
+        e.rssi = rssi;
+        e.reserved = 0;
+        logIndex.add(e, evicted);
+
+        logNextSeq++;
         if (logCount < MAX_LOG_ENTRIES) logCount++;
+        uint32_t seqToSave = logNextSeq;
+        portEXIT_CRITICAL(&logMux);
 
-        // Save to NVS (batched to reduce writes)
-        prefs.putUChar("logHead", logHead);
-        prefs.putUChar("logCount", logCount);
-        prefs.putBytes("logBuf", logBuffer, sizeof(logBuffer));
+        // Save to NVS: only the page the entry landed in
+        prefs.putUInt("logSeq", seqToSave);
+        saveLogPage(slot / LOG_PAGE_ENTRIES);
     }
 
-    // Get log entries in chronological order (oldest first)
-    int getLogEntries(LogEntry* output, int maxEntries) {
-        if (logCount == 0) return 0;
+    // After the first NTP sync: wall-clock time for this boot's earlier
+    // entries from the millis() <-> Unix anchor (saved with the next append)
+    void backfillUnixTime(uint32_t anchorMillis, uint32_t anchorUnix) {
+        portENTER_CRITICAL(&logMux);
+        for (uint32_t seq = max(bootSeq, logNextSeq - logCount); seq < logNextSeq; seq++) {
+            LogEntry& e = logBuffer[slotForSeq(seq)];
+            if (e.unixTime == 0) e.unixTime = anchorUnix - (uint32_t)(anchorMillis - e.timestamp) / 1000;
+        }
+        rebuildLogIndex();
+        portEXIT_CRITICAL(&logMux);
+    }
 
-        int count = min((int)logCount, maxEntries);
-        int startIdx;
+    // Newest-first entries matching `q` (log_index.h); cost follows the
+    // matching device/action chain or time window, not the ring size
+    int queryLog(const LogQuery& q, LogEntry* output, int maxEntries, LogQueryStats* stats) {
+        portENTER_CRITICAL(&logMux);
+        int n = logIndex.query(logBuffer, logNextSeq - logCount, logNextSeq, q, output, maxEntries, stats);
+        portEXIT_CRITICAL(&logMux);
+        return n;
+    }
 
-        if (logCount < MAX_LOG_ENTRIES) {
-            startIdx = 0;
-        } else {
-            startIdx = logHead; // Oldest entry
-        }
+    // Sequence number of the oldest retained entry (== getNextSeq() if empty)
+    uint32_t getOldestSeq() {
+        return logNextSeq - logCount;
+    }
 
-        for (int i = 0; i < count; i++) {
-            int idx = (startIdx + i) % MAX_LOG_ENTRIES;
-            output[i] = logBuffer[idx];
-        }
+    uint32_t getNextSeq() {
+        return logNextSeq;
+    }
 
+    // Copy up to maxEntries entries with since < seq < untilSeq, oldest first.
+    // Only depends on seq -> slot mapping, so the cursor stays valid for any
+    // ring size or backing store that is addressable by sequence number.
+    int readLogSince(uint32_t since, LogEntry* output, int maxEntries, uint32_t untilSeq = UINT32_MAX) {
+        portENTER_CRITICAL(&logMux);
+        uint32_t first = max(since + 1, logNextSeq - logCount);
+        uint32_t end = min(untilSeq, logNextSeq);
+        int count = 0;
+        for (uint32_t seq = first; seq < end && count < maxEntries; seq++) {
+            output[count++] = logBuffer[slotForSeq(seq)];
+        }
+        portEXIT_CRITICAL(&logMux);
         return count;
     }
 
+    // Get log entries in chronological order (oldest first)
+    int getLogEntries(LogEntry* output, int maxEntries) {
+        return readLogSince(0, output, maxEntries);
+    }
+
     // ========== Settings Storage ==========
 
     void loadSettings() {
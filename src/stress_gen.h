@@ -0,0 +1,266 @@
+/*
+ * Stress Generator - Crowded-RF advert workload for the ingestion path
+ * Portable: drives the native stress ramp (bench --stress-ramp) and the
+ * on-device injector (STRESS_INJECT=1, src/stress_inject.h).
+ *
+ * Background traffic at `rate` adverts/s with exponential gaps:
+ *   foreign RPAs     rpaPercent, a full AES pass per paired device each
+ *   public/static    the rest, rejected by the RPA pre-filter
+ *   bursts           burstPercent of them repeated STRESS_BURST_LEN - 1
+ *                    more times STRESS_BURST_GAP_US apart (three channels +
+ *                    scan response), on top of `rate`
+ * Paired phones (IRKs from the device table) advertise every
+ * STRESS_PHONE_PERIOD_US and walk up and away together: STRESS_PHONE_STRONG
+ * periods strong (unlock), STRESS_PHONE_WEAK weak (gone), so every cycle
+ * yields one unlock decision.
+ *
+ * StressRunner feeds the arrivals through a FIFO of STRESS_QUEUE_DEPTH
+ * adverts, standing in for the BLE stack's scan-result queue: an advert
+ * that arrives while it is full is dropped. The caller pops, runs the
+ * ingestion path and reports unlock decisions for latency (arrival ->
+ * decision).
+ */
+
+#ifndef STRESS_GEN_H
+#define STRESS_GEN_H
+
+#include <Arduino.h>
+#include <math.h>
+#include "rpa.h"
+
+#define STRESS_PHONES 2
+#define STRESS_PHONE_PERIOD_US 100000
+#define STRESS_PHONE_STRONG 5
+#define STRESS_PHONE_WEAK 5
+#define STRESS_BURST_LEN 3
+#define STRESS_BURST_GAP_US 400
+#define STRESS_QUEUE_DEPTH 32
+#define STRESS_LATENCY_SAMPLES 64
+
+struct StressMix {
+    uint32_t rate;              // Background adverts per second
+    uint8_t rpaPercent;         // Foreign RPAs, the rest public/static
+    uint8_t burstPercent;       // Background adverts repeated as a burst
+    uint8_t phones;             // Paired phones advertising, 0..STRESS_PHONES
+};
+
+struct StressAdvert {
+    uint64_t timeUs;            // Arrival, relative to the run start
+    uint8_t address[6];
+    int8_t rssi;
+    int8_t phone;               // Paired device index, -1 for background
+};
+
+struct StressResult {
+    uint32_t durationUs;
+    uint32_t offered;
+    uint32_t processed;
+    uint32_t dropped;           // Queue full on arrival
+    uint32_t unlocks;
+    uint32_t latencyP50Us;      // Arrival -> unlock decision
+    uint32_t latencyP99Us;
+    uint32_t latencyMaxUs;
+};
+
+class StressGenerator {
+private:
+    StressMix mix;
+    uint64_t rng = 1;
+    uint8_t phoneIrk[STRESS_PHONES][16];
+
+    uint64_t backgroundNextUs = 0;
+    StressAdvert burst;                 // Pending duplicates, burst.timeUs = next one
+    int burstLeft = 0;
+
+    uint64_t phoneNextUs[STRESS_PHONES];
+    uint64_t phoneCycle[STRESS_PHONES]; // Cycle of the current RPA
+    uint8_t phoneRpa[STRESS_PHONES][6];
+
+    // xorshift64*
+    uint64_t nextRandom() {
+        rng ^= rng >> 12;
+        rng ^= rng << 25;
+        rng ^= rng >> 27;
+        return rng * 2685821657736338717ULL;
+    }
+
+    int uniform(int lo, int hi) {
+        return lo + (int)(nextRandom() % (uint64_t)(hi - lo + 1));
+    }
+
+    uint64_t backgroundGapUs() {
+        if (mix.rate == 0) return UINT64_MAX / 2;
+        double u = (double)((nextRandom() >> 11) + 1) / 9007199254740993.0;
+        return (uint64_t)(-log(u) * 1e6 / mix.rate) + 1;
+    }
+
+    void nextBurst(StressAdvert* out) {
+        *out = burst;
+        out->rssi = (int8_t)(burst.rssi + uniform(-2, 2));
+        burst.timeUs += STRESS_BURST_GAP_US;
+        burstLeft--;
+    }
+
+    void nextBackground(StressAdvert* out) {
+        out->timeUs = backgroundNextUs;
+        out->phone = -1;
+        backgroundNextUs += backgroundGapUs();
+
+        uint64_t r = nextRandom();
+        for (int i = 0; i < 6; i++) out->address[i] = (uint8_t)(r >> (i * 8));
+        if ((int)(nextRandom() % 100) < mix.rpaPercent) {
+            out->address[0] = (out->address[0] & 0x3F) | 0x40;     // RPA of an unknown IRK
+        } else {
+            out->address[0] &= 0x3F;                                // Public / non-resolvable
+        }
+        out->rssi = (int8_t)uniform(-100, -50);
+
+        // One burst at a time; a new one replaces what is left of the last
+        if ((int)(nextRandom() % 100) < mix.burstPercent) {
+            burst = *out;
+            burst.timeUs += STRESS_BURST_GAP_US;
+            burstLeft = STRESS_BURST_LEN - 1;
+        }
+    }
+
+    void nextPhone(int p, StressAdvert* out) {
+        uint64_t period = phoneNextUs[p] / STRESS_PHONE_PERIOD_US;
+        uint64_t cycle = period / (STRESS_PHONE_STRONG + STRESS_PHONE_WEAK);
+        bool strong = period % (STRESS_PHONE_STRONG + STRESS_PHONE_WEAK) < STRESS_PHONE_STRONG;
+        if (cycle != phoneCycle[p]) {
+            // New RPA each cycle, as after an iOS rotation
+            phoneCycle[p] = cycle;
+            makeRPA(phoneIrk[p], (uint32_t)nextRandom(), phoneRpa[p]);
+        }
+
+        out->timeUs = phoneNextUs[p];
+        out->phone = (int8_t)p;
+        memcpy(out->address, phoneRpa[p], 6);
+        out->rssi = (int8_t)(strong ? uniform(-70, -50) : uniform(-99, -95));
+        phoneNextUs[p] += STRESS_PHONE_PERIOD_US - STRESS_PHONE_PERIOD_US / 10 +
+                          (uint64_t)uniform(0, STRESS_PHONE_PERIOD_US / 5);
+    }
+
+public:
+    // The phones use the IRKs of the first mix.phones entries of `devices`
+    // (any type with an irk[16] member, as for resolveRPA())
+    template <typename Device>
+    void begin(const StressMix& m, const Device* devices, uint32_t seed) {
+        mix = m;
+        if (mix.phones > STRESS_PHONES) mix.phones = STRESS_PHONES;
+        for (int p = 0; p < mix.phones; p++) memcpy(phoneIrk[p], devices[p].irk, 16);
+        rng = seed * 0x9E3779B97F4A7C15ULL + 1;
+        burstLeft = 0;
+        backgroundNextUs = backgroundGapUs();
+        for (int p = 0; p < STRESS_PHONES; p++) {
+            phoneNextUs[p] = (uint64_t)uniform(0, STRESS_PHONE_PERIOD_US - 1);
+            phoneCycle[p] = UINT64_MAX;
+        }
+    }
+
+    // Arrival time of the next advert
+    uint64_t peekUs() {
+        uint64_t next = backgroundNextUs;
+        if (burstLeft > 0 && burst.timeUs < next) next = burst.timeUs;
+        for (int p = 0; p < mix.phones; p++) {
+            if (phoneNextUs[p] < next) next = phoneNextUs[p];
+        }
+        return next;
+    }
+
+    void next(StressAdvert* out) {
+        int source = -1;                // -1 background, -2 burst, else phone
+        uint64_t next = backgroundNextUs;
+        if (burstLeft > 0 && burst.timeUs < next) {
+            source = -2;
+            next = burst.timeUs;
+        }
+        for (int p = 0; p < mix.phones; p++) {
+            if (phoneNextUs[p] < next) {
+                source = p;
+                next = phoneNextUs[p];
+            }
+        }
+        if (source == -1) nextBackground(out);
+        else if (source == -2) nextBurst(out);
+        else nextPhone(source, out);
+    }
+};
+
+class StressRunner {
+private:
+    StressGenerator generator;
+    StressAdvert queue[STRESS_QUEUE_DEPTH];
+    int head = 0;
+    int count = 0;
+
+    uint32_t latency[STRESS_LATENCY_SAMPLES];
+    StressResult result;
+
+public:
+    template <typename Device>
+    void begin(const StressMix& mix, const Device* devices, uint32_t seed) {
+        generator.begin(mix, devices, seed);
+        head = 0;
+        count = 0;
+        memset(&result, 0, sizeof(result));
+    }
+
+    // Queue everything that has arrived by `elapsedUs`; full queue drops
+    void admit(uint64_t elapsedUs) {
+        while (generator.peekUs() <= elapsedUs) {
+            result.offered++;
+            if (count == STRESS_QUEUE_DEPTH) {
+                StressAdvert lost;
+                generator.next(&lost);
+                result.dropped++;
+                continue;
+            }
+            generator.next(&queue[(head + count) % STRESS_QUEUE_DEPTH]);
+            count++;
+        }
+    }
+
+    bool pop(StressAdvert* out) {
+        if (count == 0) return false;
+        *out = queue[head];
+        head = (head + 1) % STRESS_QUEUE_DEPTH;
+        count--;
+        result.processed++;
+        return true;
+    }
+
+    // Arrival time of the next advert not yet admitted
+    uint64_t nextArrivalUs() {
+        return generator.peekUs();
+    }
+
+    // The ingestion path decided to unlock at `elapsedUs` on the advert
+    // that arrived at `arrivalUs` (StressAdvert.timeUs)
+    void onUnlock(uint64_t arrivalUs, uint64_t elapsedUs) {
+        uint32_t us = (uint32_t)(elapsedUs - arrivalUs);
+        latency[result.unlocks % STRESS_LATENCY_SAMPLES] = us;   // Most recent samples
+        result.unlocks++;
+        if (us > result.latencyMaxUs) result.latencyMaxUs = us;
+    }
+
+    void finish(uint64_t elapsedUs, StressResult* out) {
+        result.durationUs = (uint32_t)elapsedUs;
+        int n = result.unlocks < STRESS_LATENCY_SAMPLES ? result.unlocks : STRESS_LATENCY_SAMPLES;
+        // Insertion sort, at most STRESS_LATENCY_SAMPLES entries
+        for (int i = 1; i < n; i++) {
+            uint32_t v = latency[i];
+            int j = i - 1;
+            while (j >= 0 && latency[j] > v) {
+                latency[j + 1] = latency[j];
+                j--;
+            }
+            latency[j + 1] = v;
+        }
+        result.latencyP50Us = n ? latency[n / 2] : 0;
+        result.latencyP99Us = n ? latency[(n * 99) / 100] : 0;
+        *out = result;
+    }
+};
+
+#endif // STRESS_GEN_H
@@ -0,0 +1,180 @@
+/*
+ * Stress Injector - Feeds generated adverts into the scan callback on-device
+ * Debug builds only (env:esp32dev-stress, -DSTRESS_INJECT=1). Serial 's'
+ * in keyless mode runs a ramp: the crowded-RF mix from stress_gen.h at
+ * STRESS_RAMP_START adverts/s, doubled every STRESS_LEVEL_MS until more
+ * than half are dropped or STRESS_RAMP_MAX is reached. One line per level:
+ *
+ *   STRESS offered/s sustained/s drop% unlocks p50/p99/max_us loop/net max gap ms
+ *
+ * The injector task sits where Bluedroid delivers adverts (core 0, above
+ * the network task) and runs stage 1 for every advert it pops from the
+ * StressRunner queue, so drops mean pipeline stage 1 could not keep up.
+ * Scanning carries on, so it pushes to its own ingest queue (injectQueue,
+ * flagged INGEST_INJECTED) rather than the radio's; its stage 1 drops show
+ * on /metrics as keyless_inject_dropped_total. Phone adverts
+ * use the first paired IRKs, so phone p is device p. While a ramp runs,
+ * the resolve task hands every proximity decision to onDecision() instead
+ * of acting on it: no key power, no button pulses, no audit log entries.
+ * Proximity state belongs to the resolve task; the injector only requests
+ * a reset (applyPendingClear()). The runner's results are shared with the
+ * resolve task (onUnlock()) and guarded by runnerMux.
+ */
+
+#ifndef STRESS_INJECT_H
+#define STRESS_INJECT_H
+
+#include <Arduino.h>
+#include "hal.h"
+#include "proximity.h"
+#include "stress_gen.h"
+#include "task_config.h"
+
+#ifndef STRESS_INJECT
+#define STRESS_INJECT 0
+#endif
+
+#define STRESS_TASK_CORE 0
+#define STRESS_TASK_PRIORITY 3          // Above the network task, below lwIP and Bluedroid
+#define STRESS_TASK_STACK 4096
+#define STRESS_IDLE_POLL_MS 200
+#define STRESS_LEVEL_MS 10000
+#define STRESS_RAMP_START 100           // Background adverts/s, doubled per level
+#define STRESS_RAMP_MAX 12800
+#define STRESS_STOP_DROP_PERCENT 50
+
+class StressInjector {
+private:
+    struct Phone {
+        uint8_t irk[16];
+    };
+
+    StressRunner runner;
+    portMUX_TYPE runnerMux = portMUX_INITIALIZER_UNLOCKED;     // begin/finish vs onUnlock
+    StressAdvert current;
+    HalAdvertHandler handler = NULL;
+    ProximityTracker* tracker = NULL;   // Resolve task's; only touched from its hooks below
+    LoopTiming* loopTiming = NULL;
+    LoopTiming* netTiming = NULL;
+    Phone devices[STRESS_PHONES];
+    int phones = 0;
+    volatile uint32_t phoneArrivalUs[STRESS_PHONES];    // Latest handed-off advert per phone
+    uint32_t levelStart = 0;
+    TaskHandle_t task = NULL;
+    volatile bool requested = false;
+    volatile bool running = false;
+    volatile bool clearRequested = false;
+
+    static void taskEntry(void* param) {
+        StressInjector* self = (StressInjector*)param;
+        for (;;) {
+            if (self->requested) {
+                self->runRamp();
+                self->requested = false;
+            }
+            vTaskDelay(pdMS_TO_TICKS(STRESS_IDLE_POLL_MS));
+        }
+    }
+
+    uint32_t elapsedUs() {
+        return hal.micros() - levelStart;
+    }
+
+    // Up to one queue's worth per pass, then yield a tick so core 0's idle
+    // task and the network task still run (caps a level at ~32k adverts/s)
+    void runLevel(uint32_t rate, StressResult* result) {
+        StressMix mix = {rate, 30, 20, (uint8_t)phones};
+        portENTER_CRITICAL(&runnerMux);
+        runner.begin(mix, devices, rate);
+        portEXIT_CRITICAL(&runnerMux);
+        clearRequested = true;
+        loopTiming->maxGapMs = 0;
+        netTiming->maxGapMs = 0;
+        levelStart = hal.micros();
+
+        while (elapsedUs() < STRESS_LEVEL_MS * 1000UL) {
+            runner.admit(elapsedUs());
+            for (int n = 0; n < STRESS_QUEUE_DEPTH && runner.pop(&current); n++) {
+                if (current.phone >= 0) phoneArrivalUs[current.phone] = (uint32_t)current.timeUs;
+                handler(current.address, current.rssi, ESP.getCycleCount());
+            }
+            vTaskDelay(1);
+        }
+        portENTER_CRITICAL(&runnerMux);
+        runner.finish(elapsedUs(), result);
+        portEXIT_CRITICAL(&runnerMux);
+    }
+
+    void runRamp() {
+        running = true;
+        Serial.printf("STRESS ramp: %d phone(s), %d s per level, queue %d\n", phones, STRESS_LEVEL_MS / 1000,
+                      STRESS_QUEUE_DEPTH);
+        for (uint32_t rate = STRESS_RAMP_START; rate <= STRESS_RAMP_MAX; rate *= 2) {
+            StressResult r;
+            runLevel(rate, &r);
+            uint32_t ms = r.durationUs / 1000;
+            uint32_t dropPercent = r.offered ? r.dropped * 100 / r.offered : 0;
+            Serial.printf("STRESS %lu/s sustained %lu/s drop %lu%% unlocks %lu latency %lu/%lu/%lu us "
+                          "loop %lu ms net %lu ms\n",
+                          (unsigned long)(r.offered * 1000ULL / ms), (unsigned long)(r.processed * 1000ULL / ms),
+                          (unsigned long)dropPercent, (unsigned long)r.unlocks, (unsigned long)r.latencyP50Us,
+                          (unsigned long)r.latencyP99Us, (unsigned long)r.latencyMaxUs,
+                          (unsigned long)loopTiming->maxGapMs, (unsigned long)netTiming->maxGapMs);
+            if (dropPercent > STRESS_STOP_DROP_PERCENT) break;
+        }
+        clearRequested = true;
+        running = false;
+        Serial.println("STRESS ramp done");
+    }
+
+public:
+    // Starts the (idle) injector task in STRESS_INJECT builds
+    void begin(HalAdvertHandler onAdvert, ProximityTracker* proximity, LoopTiming* proximityLoop,
+               LoopTiming* networkLoop) {
+        handler = onAdvert;
+        tracker = proximity;
+        loopTiming = proximityLoop;
+        netTiming = networkLoop;
+        if (!STRESS_INJECT) return;
+        xTaskCreatePinnedToCore(taskEntry, "stress", STRESS_TASK_STACK, this, STRESS_TASK_PRIORITY, &task,
+                                STRESS_TASK_CORE);
+    }
+
+    // Serial 's': ramp with the first (up to STRESS_PHONES) paired devices
+    template <typename Device>
+    void requestRamp(const Device* deviceTable, int deviceCount) {
+        if (!STRESS_INJECT) {
+            Serial.println("STRESS injector not built (env:esp32dev-stress)");
+            return;
+        }
+        if (requested) return;
+        phones = min(deviceCount, STRESS_PHONES);
+        for (int p = 0; p < phones; p++) memcpy(devices[p].irk, deviceTable[p].irk, 16);
+        requested = true;
+    }
+
+    bool isRunning() {
+        return running;
+    }
+
+    // Resolve task, before each pass: level start/end reset
+    void applyPendingClear() {
+        if (!clearRequested) return;
+        clearRequested = false;
+        tracker->clearAll();
+    }
+
+    // Resolve task while running, in place of the unlock/lock actions
+    // (for real adverts too; only injected ones are timed)
+    void onDecision(ProximityDecision decision, int device, bool injected) {
+        if (decision == PROX_UNLOCK && injected && device < phones) {
+            portENTER_CRITICAL(&runnerMux);
+            runner.onUnlock(phoneArrivalUs[device], elapsedUs());
+            portEXIT_CRITICAL(&runnerMux);
+        } else if (decision == PROX_GONE) {
+            tracker->clearAll();
+        }
+    }
+};
+
+#endif // STRESS_INJECT_H
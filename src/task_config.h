@@ -0,0 +1,66 @@
+/*
+ * Task Configuration - FreeRTOS task layout, priorities and stack budgets
+ *
+ * Core 0 (PRO): WiFi/lwIP, Bluedroid host (scan callback = pipeline
+ *               stage 1), network task (WiFi + web), diag drain task
+ * Core 1 (APP): BLE scan task, resolve task (stage 2: RPA resolution and
+ *               proximity decisions), Arduino loop task (stage 3: actuation)
+ *
+ * Web latency and proximity timing no longer depend on each other: a slow
+ * HTTP client only delays the network task, and the 3 s blocking scan only
+ * delays the scan task. AES work runs off the Bluedroid task, so a burst of
+ * foreign RPAs backs up the ingest queue (pipeline.h), not the BLE stack.
+ */
+
+#ifndef TASK_CONFIG_H
+#define TASK_CONFIG_H
+
+#include <Arduino.h>
+
+// Network task: WifiManager::update() + DashboardServer::handleClient()
+#define NET_TASK_CORE 0
+#define NET_TASK_PRIORITY 2          // Above idle, below lwIP (18) and Bluedroid (19+)
+#define NET_TASK_STACK 6144
+#define NET_TASK_PERIOD_MS 5
+
+// BLE scan task: blocking GapScanner::scan() loop, results arrive via GAP callback
+#define SCAN_TASK_CORE 1
+#define SCAN_TASK_PRIORITY 2         // Above the loop task so scans restart promptly
+#define SCAN_TASK_STACK 4096
+#define SCAN_RESTART_DELAY_MS 500    // Radio time left to WiFi between scans
+
+// Resolve task: drains the ingest queue, owns proximity state (pipeline.h)
+#define RESOLVE_TASK_CORE 1
+#define RESOLVE_TASK_PRIORITY 3      // Above scan and loop: decisions before actuation
+#define RESOLVE_TASK_STACK 4096
+
+// Diagnostics drain: formats DIAG_* records onto Serial (diag.h). Lowest app
+// priority, so it only runs when the network task has nothing to do.
+#define DIAG_TASK_CORE 0
+#define DIAG_TASK_PRIORITY 1
+#define DIAG_TASK_STACK 3072
+#define DIAG_DRAIN_PERIOD_MS 50
+
+// Actuation: Arduino loop task (core 1, priority 1, CONFIG_ARDUINO_LOOP_STACK_SIZE).
+// Also the timeout pass cadence of the resolve task; both wake early on work.
+#define PROXIMITY_PERIOD_MS 50
+
+// Measures the gap between consecutive iterations of a task loop
+struct LoopTiming {
+    volatile uint32_t lastRun = 0;
+    volatile uint32_t lastGapMs = 0;
+    volatile uint32_t maxGapMs = 0;
+    volatile uint32_t iterations = 0;
+
+    void tick() {
+        uint32_t now = millis();
+        if (iterations > 0) {
+            lastGapMs = now - lastRun;
+            if (lastGapMs > maxGapMs) maxGapMs = lastGapMs;
+        }
+        lastRun = now;
+        iterations++;
+    }
+};
+
+#endif // TASK_CONFIG_H
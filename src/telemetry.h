@@ -0,0 +1,288 @@
+/*
+ * Telemetry Module - Per-task CPU/stack and heap history
+ * Sampled every TELEMETRY_PERIOD_MS from the network task (one
+ * uxTaskGetSystemState() pass, no allocation; needs the trace facility,
+ * which the Arduino-ESP32 SDK config enables). Keeps a rolling heap/CPU
+ * history in RAM, served by GET /api/telemetry and printed on serial.
+ *
+ * CPU load: per-task from FreeRTOS run-time stats when the SDK enables
+ * them (configGENERATE_RUN_TIME_STATS), otherwise per-core only, estimated
+ * from idle-hook wakeups (each tick the idle task sees counts as idle).
+ *
+ * The last sample survives a watchdog reset in RTC memory and is printed
+ * on the next boot.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include <esp_attr.h>
+#include <esp_system.h>
+#include <esp_freertos_hooks.h>
+
+#define TELEMETRY_PERIOD_MS 5000
+#define TELEMETRY_HISTORY 60            // 5 min of samples
+#define TELEMETRY_MAX_TASKS 24
+#define TELEMETRY_SERIAL_MS 60000       // Summary line on serial
+#define TELEMETRY_CPU_UNKNOWN 255
+
+struct HeapSample {
+    uint32_t uptimeS;
+    uint32_t freeHeap;
+    uint32_t minFreeHeap;               // Lowest ever since boot
+    uint32_t largestBlock;
+    uint8_t fragPct;                    // 100 - largest block / free heap
+    uint8_t cpuPct[2];                  // Per core, TELEMETRY_CPU_UNKNOWN until measured
+    uint8_t reserved;
+};
+
+struct TaskSample {
+    char name[16];
+    uint8_t core;                       // 0, 1 or 2 = no affinity
+    uint8_t priority;
+    uint8_t cpuPct;                     // TELEMETRY_CPU_UNKNOWN without run-time stats
+    uint8_t state;                      // eTaskState
+    uint32_t stackFree;                 // High-water mark (bytes)
+};
+
+// Survives a software/watchdog reset (not power loss)
+#define TELEMETRY_CRASH_MAGIC 0x544C4D31  // "TLM1"
+struct TelemetryCrashRecord {
+    uint32_t magic;
+    HeapSample last;
+    char lowestStackTask[16];
+    uint32_t lowestStackFree;
+};
+static RTC_NOINIT_ATTR TelemetryCrashRecord telemetryCrashRecord;
+
+class Telemetry {
+private:
+    HeapSample history[TELEMETRY_HISTORY];
+    int historyHead = 0;
+    int historyCount = 0;
+
+    TaskSample tasks[TELEMETRY_MAX_TASKS];
+    int taskCount = 0;
+
+    // Scratch for uxTaskGetSystemState() (kept off the network task stack)
+    TaskStatus_t status[TELEMETRY_MAX_TASKS];
+    uint32_t prevRunTime[TELEMETRY_MAX_TASKS];
+    UBaseType_t prevTaskNumber[TELEMETRY_MAX_TASKS];
+    int prevCount = 0;
+    uint32_t prevTotalRunTime = 0;
+
+    uint32_t prevIdleCalls[2] = {0, 0};
+    TickType_t prevTick = 0;
+
+    uint32_t lastSample = 0;
+    uint32_t lastSerial = 0;
+    uint32_t sampleUs = 0;              // Cost of the last sample
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+
+    static volatile uint32_t* idleCalls() {
+        static volatile uint32_t calls[2] = {0, 0};
+        return calls;
+    }
+
+    // Idle hooks: returning true lets the idle task sleep until the next
+    // interrupt, so the count is roughly "ticks spent idle"
+    static bool onIdle0() {
+        idleCalls()[0]++;
+        return true;
+    }
+
+    static bool onIdle1() {
+        idleCalls()[1]++;
+        return true;
+    }
+
+    void sample() {
+        uint32_t start = micros();
+        HeapSample h;
+        h.uptimeS = millis() / 1000;
+        h.freeHeap = ESP.getFreeHeap();
+        h.minFreeHeap = ESP.getMinFreeHeap();
+        h.largestBlock = ESP.getMaxAllocHeap();
+        h.fragPct = h.freeHeap ? 100 - (uint8_t)((uint64_t)h.largestBlock * 100 / h.freeHeap) : 0;
+        h.reserved = 0;
+
+        // Per-core load from idle wakeups per elapsed tick
+        TickType_t tick = xTaskGetTickCount();
+        TickType_t elapsed = tick - prevTick;
+        for (int c = 0; c < 2; c++) {
+            uint32_t calls = idleCalls()[c];
+            uint32_t idle = calls - prevIdleCalls[c];
+            prevIdleCalls[c] = calls;
+            if (prevTick == 0 || elapsed == 0) {
+                h.cpuPct[c] = TELEMETRY_CPU_UNKNOWN;
+            } else {
+                uint32_t idlePct = min((uint32_t)100, idle * 100 / elapsed);
+                h.cpuPct[c] = 100 - idlePct;
+            }
+        }
+        prevTick = tick;
+
+        uint32_t totalRunTime = 0;
+        int n = uxTaskGetSystemState(status, TELEMETRY_MAX_TASKS, &totalRunTime);
+        uint32_t totalDelta = totalRunTime - prevTotalRunTime;
+
+        TaskSample fresh[TELEMETRY_MAX_TASKS];
+        int lowest = -1;
+        for (int i = 0; i < n; i++) {
+            TaskSample& t = fresh[i];
+            strncpy(t.name, status[i].pcTaskName, sizeof(t.name) - 1);
+            t.name[sizeof(t.name) - 1] = '\0';
+            BaseType_t affinity = xTaskGetAffinity(status[i].xHandle);
+            t.core = (affinity == 0 || affinity == 1) ? affinity : 2;
+            t.priority = status[i].uxCurrentPriority;
+            t.state = status[i].eCurrentState;
+            t.stackFree = status[i].usStackHighWaterMark;   // Bytes on ESP32 (StackType_t = uint8_t)
+            t.cpuPct = TELEMETRY_CPU_UNKNOWN;
+
+#if configGENERATE_RUN_TIME_STATS
+            // Run-time counters are per core; a pinned task's share of one core
+            for (int p = 0; p < prevCount; p++) {
+                if (prevTaskNumber[p] == status[i].xTaskNumber && totalDelta > 0) {
+                    uint32_t delta = status[i].ulRunTimeCounter - prevRunTime[p];
+                    t.cpuPct = min((uint64_t)100, (uint64_t)delta * 100 / totalDelta);
+                    break;
+                }
+            }
+#endif
+            if (lowest < 0 || t.stackFree < fresh[lowest].stackFree) lowest = i;
+        }
+
+        for (int i = 0; i < n; i++) {
+            prevTaskNumber[i] = status[i].xTaskNumber;
+            prevRunTime[i] = status[i].ulRunTimeCounter;
+        }
+        prevCount = n;
+        prevTotalRunTime = totalRunTime;
+
+        portENTER_CRITICAL(&mux);
+        memcpy(tasks, fresh, n * sizeof(TaskSample));
+        taskCount = n;
+        history[historyHead] = h;
+        historyHead = (historyHead + 1) % TELEMETRY_HISTORY;
+        if (historyCount < TELEMETRY_HISTORY) historyCount++;
+        portEXIT_CRITICAL(&mux);
+
+        telemetryCrashRecord.last = h;
+        if (lowest >= 0) {
+            memcpy(telemetryCrashRecord.lowestStackTask, fresh[lowest].name, sizeof(fresh[lowest].name));
+            telemetryCrashRecord.lowestStackFree = fresh[lowest].stackFree;
+        }
+        telemetryCrashRecord.magic = TELEMETRY_CRASH_MAGIC;
+
+        sampleUs = micros() - start;
+    }
+
+    static void formatCpu(char* buf, size_t size, uint8_t pct) {
+        if (pct == TELEMETRY_CPU_UNKNOWN) snprintf(buf, size, "--");
+        else snprintf(buf, size, "%u%%", pct);
+    }
+
+    static void printCpu(uint8_t pct) {
+        char text[8];
+        formatCpu(text, sizeof(text), pct);
+        Serial.print(text);
+    }
+
+public:
+    // Call once early in setup(); reports the sample saved before a watchdog reset
+    void begin() {
+        esp_register_freertos_idle_hook_for_cpu(onIdle0, 0);
+        esp_register_freertos_idle_hook_for_cpu(onIdle1, 1);
+
+        esp_reset_reason_t reason = esp_reset_reason();
+        bool wdt = reason == ESP_RST_TASK_WDT || reason == ESP_RST_INT_WDT || reason == ESP_RST_WDT;
+        if (wdt && telemetryCrashRecord.magic == TELEMETRY_CRASH_MAGIC) {
+            const HeapSample& h = telemetryCrashRecord.last;
+            telemetryCrashRecord.lowestStackTask[15] = '\0';
+            Serial.printf("Watchdog reset - last telemetry at %lus: heap %lu free, %lu min, %lu block (%u%% frag), "
+                          "CPU %u%%/%u%%, lowest stack %s (%lu bytes)\n",
+                (unsigned long)h.uptimeS, (unsigned long)h.freeHeap, (unsigned long)h.minFreeHeap,
+                (unsigned long)h.largestBlock, h.fragPct, h.cpuPct[0], h.cpuPct[1],
+                telemetryCrashRecord.lowestStackTask, (unsigned long)telemetryCrashRecord.lowestStackFree);
+        }
+        telemetryCrashRecord.magic = 0;
+    }
+
+    // Called from the network task; samples when due
+    void update() {
+        uint32_t now = millis();
+        if (lastSample != 0 && now - lastSample < TELEMETRY_PERIOD_MS) return;
+        lastSample = now;
+        sample();
+
+        if (now - lastSerial >= TELEMETRY_SERIAL_MS) {
+            lastSerial = now;
+            printSummary();
+        }
+    }
+
+    // One line: heap, fragmentation, per-core CPU. Formatted on the stack:
+    // Serial.printf() mallocs for lines over 64 bytes and this runs periodically.
+    void printSummary() {
+        HeapSample h;
+        if (!getLatest(h)) return;
+        char cpu0[8], cpu1[8];
+        formatCpu(cpu0, sizeof(cpu0), h.cpuPct[0]);
+        formatCpu(cpu1, sizeof(cpu1), h.cpuPct[1]);
+        char line[128];
+        snprintf(line, sizeof(line), "TLM heap %lu free / %lu min / %lu block (%u%% frag), CPU %s/%s, sample %luus\n",
+            (unsigned long)h.freeHeap, (unsigned long)h.minFreeHeap, (unsigned long)h.largestBlock, h.fragPct,
+            cpu0, cpu1, (unsigned long)sampleUs);
+        Serial.print(line);
+    }
+
+    // Full task table
+    void printTasks() {
+        TaskSample copy[TELEMETRY_MAX_TASKS];
+        int n = getTasks(copy, TELEMETRY_MAX_TASKS);
+        Serial.println("TLM task             core prio  cpu  stack free");
+        for (int i = 0; i < n; i++) {
+            Serial.printf("TLM %-16s %4s %4u ", copy[i].name,
+                copy[i].core == 2 ? "-" : (copy[i].core ? "1" : "0"), copy[i].priority);
+            printCpu(copy[i].cpuPct);
+            Serial.printf(" %6lu\n", (unsigned long)copy[i].stackFree);
+        }
+    }
+
+    bool getLatest(HeapSample& out) {
+        portENTER_CRITICAL(&mux);
+        bool have = historyCount > 0;
+        if (have) out = history[(historyHead + TELEMETRY_HISTORY - 1) % TELEMETRY_HISTORY];
+        portEXIT_CRITICAL(&mux);
+        return have;
+    }
+
+    int getTasks(TaskSample* out, int maxTasks) {
+        portENTER_CRITICAL(&mux);
+        int n = min(taskCount, maxTasks);
+        memcpy(out, tasks, n * sizeof(TaskSample));
+        portEXIT_CRITICAL(&mux);
+        return n;
+    }
+
+    // Oldest first
+    int getHistory(HeapSample* out, int maxSamples) {
+        portENTER_CRITICAL(&mux);
+        int n = min(historyCount, maxSamples);
+        int first = (historyHead + TELEMETRY_HISTORY - n) % TELEMETRY_HISTORY;
+        for (int i = 0; i < n; i++) {
+            out[i] = history[(first + i) % TELEMETRY_HISTORY];
+        }
+        portEXIT_CRITICAL(&mux);
+        return n;
+    }
+
+    uint32_t getSampleUs() {
+        return sampleUs;
+    }
+};
+
+extern Telemetry telemetry;
+
+#endif // TELEMETRY_H
@@ -0,0 +1,146 @@
+/*
+ * Trace Module - Hot-path latency tracing into a lock-free RAM ring
+ * Each event is one fetch_add plus a 16-byte store, stamped with the
+ * CPU cycle counter of the core it ran on. Dumped by GET /api/trace,
+ * turned into per-stage percentiles / a Chrome trace by
+ * tools/trace_report.py.
+ *
+ * Cycle counters are per core and wrap every 2^32 cycles (~17.9 s at
+ * 240 MHz). Each core therefore emits a TRACE_SYNC record (cycles paired
+ * with esp_timer microseconds) at least every TRACE_SYNC_INTERVAL_MS,
+ * which the decoder uses to put both cores on one timeline.
+ *
+ * Build with -DTRACE_ENABLED=0 to compile all trace points out.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <esp_timer.h>
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+#define TRACE_RING_SIZE 512             // Records, power of two (8 KB)
+#define TRACE_SYNC_INTERVAL_MS 4000     // Well inside the cycle counter wrap
+
+enum TraceEvent {
+    TRACE_SYNC,             // arg = esp_timer_get_time() low 32 bits
+    TRACE_GAP_CB,           // Scan callback entry (RPA candidates only)
+    TRACE_PREFILTER,        // Pre-filter exit, advert is an RPA candidate
+    TRACE_QUEUE_DROP,       // Ingest queue full, the candidate is dropped
+    TRACE_DEQUEUE,          // Resolve task takes the oldest queued candidate
+    TRACE_RPA_START,        // verifyRPA() entry
+    TRACE_RPA_END,          // verifyRPA() exit, arg = device index + 1 (0 = no match)
+    TRACE_PROXIMITY,        // Decision, arg = device << 8 | TraceDecision
+    TRACE_KEY_POWER,        // activateKeyPower() switched the fob on
+    TRACE_UNLOCK_EDGE,      // Unlock pin rising edge
+    TRACE_LOCK_EDGE,        // Lock pin rising edge
+    TRACE_NVS_START,        // Log write start
+    TRACE_NVS_END,          // Log write end
+    TRACE_EVENT_COUNT
+};
+
+enum TraceDecision {
+    TRACE_DECIDE_UNLOCK = 1,    // First strong signal -> unlock sequence
+    TRACE_DECIDE_NEARBY,        // Strong/mid signal, state unchanged
+    TRACE_DECIDE_WEAK,          // Weak signal counted
+    TRACE_DECIDE_GONE           // Weak hysteresis or timeout -> lock scheduled
+};
+
+static const char* const TRACE_EVENT_NAMES[TRACE_EVENT_COUNT] = {
+    "sync", "gap_cb", "prefilter", "queue_drop", "dequeue", "rpa_start", "rpa_end", "proximity",
+    "key_power", "unlock_edge", "lock_edge", "nvs_start", "nvs_end"
+};
+
+struct TraceRecord {
+    uint32_t index;         // Global sequence; written last, validates the slot
+    uint32_t cycles;
+    uint32_t arg;
+    uint8_t event;
+    uint8_t core;
+    uint16_t reserved;
+};
+
+class Trace {
+private:
+    TraceRecord ring[TRACE_RING_SIZE];
+    std::atomic<uint32_t> head{0};
+    volatile TickType_t lastSync[2] = {0, 0};
+
+    void store(uint8_t event, uint32_t cycles, uint32_t arg, uint8_t core) {
+        uint32_t index = head.fetch_add(1, std::memory_order_relaxed);
+        TraceRecord& r = ring[index & (TRACE_RING_SIZE - 1)];
+        r.index = UINT32_MAX;   // Mark in-flight for concurrent readers
+        std::atomic_thread_fence(std::memory_order_release);
+        r.cycles = cycles;
+        r.arg = arg;
+        r.event = event;
+        r.core = core;
+        std::atomic_thread_fence(std::memory_order_release);
+        r.index = index;
+    }
+
+public:
+    static uint32_t now() {
+        return ESP.getCycleCount();
+    }
+
+    // Record with an already-captured timestamp (see scan callback)
+    void recordAt(TraceEvent event, uint32_t cycles, uint32_t arg = 0) {
+#if TRACE_ENABLED
+        uint8_t core = xPortGetCoreID();
+        TickType_t tick = xTaskGetTickCount();
+        if (tick - lastSync[core] >= pdMS_TO_TICKS(TRACE_SYNC_INTERVAL_MS) || lastSync[core] == 0) {
+            lastSync[core] = tick ? tick : 1;
+            store(TRACE_SYNC, now(), (uint32_t)esp_timer_get_time(), core);
+        }
+        store(event, cycles, arg, core);
+#endif
+    }
+
+    void record(TraceEvent event, uint32_t arg = 0) {
+#if TRACE_ENABLED
+        recordAt(event, now(), arg);
+#endif
+    }
+
+    uint32_t getHead() {
+        return head.load(std::memory_order_acquire);
+    }
+
+    // Copy out records with index >= since (oldest first); skips slots a
+    // later lap overwrote and stops at one not written yet, leaving *next on
+    // it so the next read picks it up. Returns the number copied.
+    int readSince(uint32_t since, TraceRecord* out, int maxRecords, uint32_t* next) {
+        uint32_t end = getHead();
+        if (since > end) since = 0;     // Cursor from before a reboot
+        uint32_t first = (end - since > TRACE_RING_SIZE) ? end - TRACE_RING_SIZE : since;
+        int n = 0;
+        uint32_t i = first;
+        for (; i != end && n < maxRecords; i++) {
+            const TraceRecord& slot = ring[i & (TRACE_RING_SIZE - 1)];
+            uint32_t before = slot.index;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            TraceRecord copy = slot;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint32_t after = slot.index;
+            if (before == i && after == i) {
+                out[n++] = copy;
+                continue;
+            }
+            // Changed under the copy, or already holding a later lap's index
+            bool overwritten = before == i || (before != UINT32_MAX && (int32_t)(before - i) > 0);
+            if (!overwritten) break;
+        }
+        *next = i;
+        return n;
+    }
+};
+
+extern Trace trace;
+
+#endif // TRACE_H
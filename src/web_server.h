@@ -7,343 +7,775 @@
 #define WEB_SERVER_H
 
 #include <WebServer.h>
+#include <stdarg.h>
 #include "storage.h"
 #include "audit_log.h"
 #include "wifi_manager.h"
+#include "coex.h"
+#include "api_router.h"
+#include "event_stream.h"
+#include "web_assets.h"
+#include "task_config.h"
+#include "metrics.h"
+#include "pipeline.h"
+#include "trace.h"
+#include "telemetry.h"
+#include "rssi_series.h"
+#include "diag.h"
 
-// External references to global settings variables in main.cpp
-extern int RSSI_UNLOCK_THRESHOLD;
-extern int RSSI_LOCK_THRESHOLD;
-extern unsigned long PROXIMITY_TIMEOUT;
-extern int WEAK_SIGNAL_THRESHOLD;
-
-// HTML Dashboard (minified, stored in PROGMEM)
-const char DASHBOARD_HTML[] PROGMEM = R"rawliteral(
-<!DOCTYPE html>
-<html><head>
-<meta charset="UTF-8">
-<meta name="viewport" content="width=device-width,initial-scale=1">
-<title>ESP32 Keyless</title>
-<style>
-*{box-sizing:border-box;margin:0;padding:0}
-body{font-family:system-ui,-apple-system,sans-serif;background:#1a1a2e;color:#eee;padding:16px;max-width:600px;margin:0 auto}
-h1{font-size:1.4em;margin-bottom:16px;color:#4cc9f0}
-h2{font-size:1.1em;margin:20px 0 10px;color:#7b2cbf}
-.card{background:#16213e;border-radius:8px;padding:12px;margin-bottom:12px}
-.device{display:flex;justify-content:space-between;align-items:center;padding:8px 0;border-bottom:1px solid #0f3460}
-.device:last-child{border:none}
-.device-name{flex:1}
-.device-name input{background:#0f3460;border:1px solid #4cc9f0;color:#eee;padding:4px 8px;border-radius:4px;width:140px}
-.btn{background:#4cc9f0;color:#1a1a2e;border:none;padding:6px 12px;border-radius:4px;cursor:pointer;font-size:0.9em;margin-left:6px}
-.btn:hover{background:#3aa8d8}
-.btn-del{background:#e63946}
-.btn-del:hover{background:#c92a36}
-.btn-save{background:#2d6a4f}
-.btn-save:hover{background:#1e4d3a}
-.log-entry{display:flex;padding:6px 0;border-bottom:1px solid #0f3460;font-size:0.9em}
-.log-entry:last-child{border:none}
-.log-time{width:70px;color:#888}
-.log-device{flex:1}
-.log-action{width:60px;text-align:center;border-radius:4px;padding:2px 6px}
-.log-unlock{background:#2d6a4f;color:#fff}
-.log-lock{background:#9d0208;color:#fff}
-.log-rssi{width:50px;text-align:right;color:#888}
-.status{display:flex;gap:16px;font-size:0.85em;color:#888;margin-bottom:16px}
-.status span{background:#0f3460;padding:4px 10px;border-radius:4px}
-.empty{color:#666;font-style:italic;padding:10px 0}
-#msg{position:fixed;bottom:20px;left:50%;transform:translateX(-50%);background:#2d6a4f;padding:10px 20px;border-radius:8px;display:none}
-.setting{margin:12px 0}
-.setting label{display:block;margin-bottom:4px;font-size:0.9em}
-.setting input[type=range]{width:100%;margin:4px 0}
-.setting .val{float:right;color:#4cc9f0;font-weight:bold}
-.setting small{color:#666;font-size:0.8em}
-</style>
-</head><body>
-<h1>ESP32 Keyless Dashboard</h1>
-<div class="status">
-<span id="wifi">WiFi: --</span>
-<span id="uptime">Uptime: --</span>
-</div>
-<h2>Devices</h2>
-<div class="card" id="devices"><div class="empty">Loading...</div></div>
-<h2>Settings</h2>
-<div class="card" id="settings">
-<div class="setting">
-<label>Unlock RSSI Threshold <span class="val" id="v1">-90</span> dBm</label>
-<input type="range" id="s1" min="-100" max="-50" value="-90" oninput="$('v1').textContent=this.value">
-<small>Signal strength to trigger unlock (lower = longer range)</small>
-</div>
-<div class="setting">
-<label>Lock RSSI Threshold <span class="val" id="v2">-80</span> dBm</label>
-<input type="range" id="s2" min="-100" max="-50" value="-80" oninput="$('v2').textContent=this.value">
-<small>Signal strength to trigger lock (higher = must be further away)</small>
-</div>
-<div class="setting">
-<label>Lock Timeout <span class="val" id="v3">10</span> sec</label>
-<input type="range" id="s3" min="5" max="60" value="10" oninput="$('v3').textContent=this.value">
-<small>Time after last detection before locking</small>
-</div>
-<div class="setting">
-<label>Weak Signal Count <span class="val" id="v4">3</span></label>
-<input type="range" id="s4" min="1" max="10" value="3" oninput="$('v4').textContent=this.value">
-<small>Number of weak signals before triggering lock</small>
-</div>
-<button class="btn btn-save" onclick="saveSettings()" style="width:100%;margin-top:8px">Save Settings</button>
-</div>
-<h2>Activity Log</h2>
-<div class="card" id="log"><div class="empty">Loading...</div></div>
-<div id="msg"></div>
-<script>
-function $(s){return document.getElementById(s)}
-function msg(t){let m=$('msg');m.textContent=t;m.style.display='block';setTimeout(()=>m.style.display='none',2000)}
-function load(){
-fetch('/api/status').then(r=>r.json()).then(d=>{
-$('wifi').textContent='WiFi: '+(d.wifi?d.ip:'Offline');
-$('uptime').textContent='Uptime: '+d.uptime;
-});
-fetch('/api/devices').then(r=>r.json()).then(d=>{
-let h='';
-d.devices.forEach((dev,i)=>{
-if(dev.active){
-h+='<div class="device"><div class="device-name"><input id="n'+i+'" value="'+dev.name+'" maxlength="19"></div>';
-h+='<button class="btn" onclick="rename('+i+')">Save</button>';
-h+='<button class="btn btn-del" onclick="del('+i+')">X</button></div>';
-}
-});
-$('devices').innerHTML=h||'<div class="empty">No devices paired</div>';
-});
-fetch('/api/log').then(r=>r.json()).then(d=>{
-let h='';
-d.log.slice().reverse().forEach(e=>{
-h+='<div class="log-entry"><span class="log-time">'+e.time+'</span>';
-h+='<span class="log-device">'+e.device+'</span>';
-h+='<span class="log-action log-'+e.action.toLowerCase()+'">'+e.action+'</span>';
-h+='<span class="log-rssi">'+e.rssi+'dB</span></div>';
-});
-$('log').innerHTML=h||'<div class="empty">No activity yet</div>';
-});
-fetch('/api/settings').then(r=>r.json()).then(d=>{
-$('s1').value=d.rssiUnlock;$('v1').textContent=d.rssiUnlock;
-$('s2').value=d.rssiLock;$('v2').textContent=d.rssiLock;
-$('s3').value=d.timeout;$('v3').textContent=d.timeout;
-$('s4').value=d.weakCount;$('v4').textContent=d.weakCount;
-});
-}
-function rename(i){
-let n=$('n'+i).value;
-fetch('/api/devices/'+i+'/name',{method:'POST',headers:{'Content-Type':'application/x-www-form-urlencoded'},body:'name='+encodeURIComponent(n)})
-.then(r=>{if(r.ok)msg('Saved!');else msg('Error');load();});
-}
-function del(i){
-if(!confirm('Delete this device?'))return;
-fetch('/api/devices/'+i,{method:'DELETE'}).then(r=>{if(r.ok)msg('Deleted');load();});
-}
-function saveSettings(){
-let body='rssiUnlock='+$('s1').value+'&rssiLock='+$('s2').value+'&timeout='+$('s3').value+'&weakCount='+$('s4').value;
-fetch('/api/settings',{method:'POST',headers:{'Content-Type':'application/x-www-form-urlencoded'},body:body})
-.then(r=>{if(r.ok)msg('Settings saved!');else msg('Error');});
-}
-load();setInterval(load,10000);
-</script>
-</body></html>
-)rawliteral";
+// Proximity thresholds in main.cpp: a lock-free snapshot, changed only
+// through applyProximityConfig()
+ProximityConfig proximityConfig();
+const char* applyProximityConfig(const ProximityConfig& cfg);
+
+// Per-device usage aggregates (rollup.h) in main.cpp
+extern Rollup rollup;
+
+// Device deletion in main.cpp: the loop task deletes, then restarts
+bool requestDeviceDelete(int index);
+bool deviceDeletePending();
+
+// Log entries copied per storage read in /api/log
+#define LOG_READ_CHUNK 10
+
+// Trace records copied per ring read in /api/trace
+#define TRACE_READ_CHUNK 32
+
+// Task loop timing from main.cpp
+extern LoopTiming netTiming;
+extern LoopTiming scanTiming;
+extern LoopTiming resolveTiming;
+extern LoopTiming proximityTiming;
+
+// Task handles for stack high-water marks
+extern TaskHandle_t netTaskHandle;
+extern TaskHandle_t scanTaskHandle;
+extern TaskHandle_t resolveTaskHandle;
+extern TaskHandle_t diagTaskHandle;
+extern TaskHandle_t loopTaskHandle;   // Arduino core
+
+// Buffers text fragments into chunked HTTP writes
+class ChunkWriter {
+private:
+    WebServer& server;
+    char buffer[512];
+    size_t used = 0;
+
+public:
+    ChunkWriter(WebServer& s) : server(s) {}
+
+    void operator()(const char* text) {
+        size_t len = strlen(text);
+        if (used + len > sizeof(buffer)) flush();
+        if (len > sizeof(buffer)) {
+            server.sendContent(text, len);
+            return;
+        }
+        memcpy(buffer + used, text, len);
+        used += len;
+    }
+
+    // Formatted fragment (up to 160 bytes), no heap
+    void printf(const char* format, ...) {
+        char text[160];
+        va_list args;
+        va_start(args, format);
+        vsnprintf(text, sizeof(text), format, args);
+        va_end(args);
+        (*this)(text);
+    }
+
+    void flush() {
+        if (used > 0) server.sendContent(buffer, used);
+        used = 0;
+    }
+};
+
+// WebServer that can let go of the current request's connection. An SSE
+// client never closes its end, and a server that waits for the close
+// (HC_WAIT_CLOSE, up to HTTP_MAX_CLOSE_WAIT = 2 s) accepts nobody else
+// meanwhile. The socket stays open while EventStream holds its WiFiClient.
+class HandoffWebServer : public WebServer {
+public:
+    HandoffWebServer(int port) : WebServer(port) {}
+
+    void releaseClient() {
+        _currentClient = WiFiClient();
+    }
+};
 
 class DashboardServer {
 private:
-    WebServer server;
+    HandoffWebServer server;
+    ApiRouter<DashboardServer> router;
     Storage* storage;
     AuditLog* auditLog;
     WifiManager* wifiManager;
+    EventStream* events;
     unsigned long startTime;
 
 public:
     DashboardServer() : server(80) {}
 
-    void begin(Storage* storagePtr, AuditLog* logPtr, WifiManager* wifiPtr) {
+    void begin(Storage* storagePtr, AuditLog* logPtr, WifiManager* wifiPtr, EventStream* eventsPtr) {
         storage = storagePtr;
         auditLog = logPtr;
         wifiManager = wifiPtr;
+        events = eventsPtr;
         startTime = millis();
 
-        // Dashboard
+        // Dashboard (gzip from flash, revalidated via ETag)
         server.on("/", HTTP_GET, [this]() {
-            server.send_P(200, "text/html", DASHBOARD_HTML);
+            sendStaticAsset(server, DASHBOARD_ASSET);
         });
 
-        // API: Get all devices
-        server.on("/api/devices", HTTP_GET, [this]() {
-            String json = "{\"devices\":[";
-            for (int i = 0; i < storage->deviceCount; i++) {
-                if (i > 0) json += ",";
-                json += "{\"id\":";
-                json += i;
-                json += ",\"name\":\"";
-                json += storage->devices[i].name;
-                json += "\",\"active\":";
-                json += storage->devices[i].active ? "true" : "false";
-                json += "}";
+        // API routes (single handler, path parameters instead of per-device URIs)
+        router.begin(this);
+        router.on(HTTP_GET, "/api/devices", &DashboardServer::handleGetDevices);
+        router.on(HTTP_POST, "/api/devices/{id}/name", &DashboardServer::handleRename);
+        router.on(HTTP_DELETE, "/api/devices/{id}", &DashboardServer::handleDelete);
+        router.on(HTTP_GET, "/api/devices/{id}/rssi", &DashboardServer::handleDeviceRssi);
+        router.on(HTTP_GET, "/api/log", &DashboardServer::handleGetLog);
+        router.on(HTTP_GET, "/api/log/export", &DashboardServer::handleExportLog);
+        router.on(HTTP_GET, "/api/settings", &DashboardServer::handleGetSettings);
+        router.on(HTTP_POST, "/api/settings", &DashboardServer::handleSaveSettings);
+        router.on(HTTP_GET, "/api/status", &DashboardServer::handleStatus);
+        router.on(HTTP_GET, "/api/stats", &DashboardServer::handleStats);
+        router.on(HTTP_GET, "/api/events", &DashboardServer::handleEvents);
+        router.on(HTTP_GET, "/metrics", &DashboardServer::handleMetrics);
+        router.on(HTTP_GET, "/api/trace", &DashboardServer::handleTrace);
+        router.on(HTTP_GET, "/api/telemetry", &DashboardServer::handleTelemetry);
+        router.on(HTTP_GET, "/api/diag", &DashboardServer::handleDiag);
+        router.onHandled([](uint32_t us) { metrics.httpHandler.observe(us); });
+        server.addHandler(&router);
+
+        collectStaticAssetHeaders(server);
+        server.begin();
+        Serial.printf("Web server started on port 80 (%d API routes, %u bytes)\n",
+            router.getRouteCount(), (unsigned)router.getMemoryFootprint());
+    }
+
+    void handleClient() {
+        server.handleClient();
+        events->update();
+    }
+
+private:
+    // API: Get all devices
+    void handleGetDevices(const RouteParams& params) {
+        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server.send(200, "application/json", "");
+
+        ChunkWriter out(server);
+        out("{\"devices\":[");
+        ProximityConfig cfg = proximityConfig();
+        for (int i = 0; i < storage->deviceCount; i++) {
+            const StoredDevice& dev = storage->devices[i];
+            int offset = dev.profile.offsetFor(cfg);
+            out.printf("%s{\"id\":%d,\"name\":\"%s\",\"active\":%s,\"sessions\":%u,\"learned\":%s,"
+                       "\"unlockRssi\":%d,\"lockRssi\":%d}", i > 0 ? "," : "",
+                i, dev.name, dev.active ? "true" : "false", (unsigned)dev.profile.sessions,
+                dev.profile.boundary ? "true" : "false", cfg.unlockRssi + offset, cfg.lockRssi + offset);
+        }
+        out("]}");
+        out.flush();
+        server.sendContent("");  // Terminating chunk
+    }
+
+    // API: Rename device
+    void handleRename(const RouteParams& params) {
+        int index = params.values[0];
+        if (server.hasArg("name")) {
+            String newName = server.arg("name");
+            if (storage->renameDevice(index, newName.c_str())) {
+                server.send(200, "application/json", "{\"success\":true}");
+                Serial.printf("Device %d renamed to: %s\n", index, newName.c_str());
+            } else {
+                server.send(400, "application/json", "{\"error\":\"Invalid index\"}");
             }
-            json += "]}";
-            server.send(200, "application/json", json);
-        });
+        } else {
+            server.send(400, "application/json", "{\"error\":\"Missing name\"}");
+        }
+    }
+
+    // API: Delete device. Device indices key every per-device table, so the
+    // loop task deletes it and restarts the unit (back in a few seconds).
+    void handleDelete(const RouteParams& params) {
+        int index = params.values[0];
+        if (deviceDeletePending()) {
+            server.send(409, "application/json", "{\"error\":\"Delete in progress\"}");
+            return;
+        }
+        if (requestDeviceDelete(index)) {
+            server.send(200, "application/json", "{\"success\":true,\"restarting\":true}");
+            Serial.printf("Device %d delete queued\n", index);
+        } else {
+            server.send(400, "application/json", "{\"error\":\"Invalid index\"}");
+        }
+    }
+
+    // API: Recent RSSI of one device, ?tier=raw|fine|coarse (default all).
+    // raw: per-advert age (ms) and RSSI; fine / coarse: min/max/mean per
+    // `step` ms, oldest first, the last bucket started `age` ms ago (null =
+    // not heard). `unix` (0 before NTP sync) places log entries on the axis.
+    void handleDeviceRssi(const RouteParams& params) {
+        if (deviceDeletePending()) {
+            // Indices shift on delete; the series are rebuilt after the restart
+            server.send(503, "application/json", "{\"error\":\"Restarting after a device delete\"}");
+            return;
+        }
+        int index = params.values[0];
+        if (index < 0 || index >= storage->deviceCount) {
+            server.send(400, "application/json", "{\"error\":\"Invalid index\"}");
+            return;
+        }
+        String tier = server.hasArg("tier") ? server.arg("tier") : String("");
+        if (tier.length() && tier != "raw" && tier != "fine" && tier != "coarse") {
+            server.send(400, "application/json", "{\"error\":\"tier must be raw, fine or coarse\"}");
+            return;
+        }
+
+        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server.send(200, "application/json", "");
+
+        ChunkWriter out(server);
+        uint32_t now = millis();
+        out.printf("{\"device\":%d,\"now\":%lu,\"unix\":%lu", index, (unsigned long)now,
+            (unsigned long)auditLog->unixNow());
+        if (!tier.length() || tier == "raw") {
+            uint32_t ages[RSSI_SERIES_RAW];
+            int8_t rssi[RSSI_SERIES_RAW];
+            int n = rssiSeries.readRaw(index, now, ages, rssi, RSSI_SERIES_RAW);
+            out(",\"raw\":{\"age\":[");
+            for (int k = 0; k < n; k++) out.printf("%s%lu", k ? "," : "", (unsigned long)ages[k]);
+            out("],\"rssi\":[");
+            for (int k = 0; k < n; k++) out.printf("%s%d", k ? "," : "", rssi[k]);
+            out("]}");
+        }
+        RssiTierView view;
+        if ((!tier.length() || tier == "fine") && rssiSeries.readTier(index, RSSI_TIER_FINE, now, &view)) {
+            writeRssiTier(out, "fine", view);
+        }
+        if ((!tier.length() || tier == "coarse") && rssiSeries.readTier(index, RSSI_TIER_COARSE, now, &view)) {
+            writeRssiTier(out, "coarse", view);
+        }
+        out("}");
+        out.flush();
+        server.sendContent("");  // Terminating chunk
+    }
+
+    static void writeRssiTier(ChunkWriter& out, const char* name, const RssiTierView& view) {
+        out.printf(",\"%s\":{\"step\":%lu,\"age\":%lu,\"min\":[", name, (unsigned long)view.stepMs,
+            (unsigned long)view.currentAgeMs);
+        for (int k = 0; k < view.count; k++) {
+            if (view.buckets[k].count) out.printf("%s%d", k ? "," : "", view.buckets[k].min);
+            else out(k ? ",null" : "null");
+        }
+        out("],\"max\":[");
+        for (int k = 0; k < view.count; k++) {
+            if (view.buckets[k].count) out.printf("%s%d", k ? "," : "", view.buckets[k].max);
+            else out(k ? ",null" : "null");
+        }
+        out("],\"mean\":[");
+        for (int k = 0; k < view.count; k++) {
+            if (view.buckets[k].count) out.printf("%s%d", k ? "," : "", view.buckets[k].mean());
+            else out(k ? ",null" : "null");
+        }
+        out("]}");
+    }
+
+    // API: Get log, incremental via ?since=<seq>&limit=<n>
+    // Returns entries with seq > since (oldest first) and the cursor for the next call
+    void handleGetLog(const RouteParams& params) {
+        if (server.hasArg("device") || server.hasArg("action") || server.hasArg("from") || server.hasArg("to") ||
+            server.hasArg("before")) {
+            handleQueryLog();
+            return;
+        }
+
+        uint32_t nextSeq = storage->getNextSeq();
+        uint32_t oldest = storage->getOldestSeq();
+
+        uint32_t since = 0;
+        if (server.hasArg("since")) since = strtoul(server.arg("since").c_str(), NULL, 10);
+        int limit = MAX_LOG_ENTRIES;
+        if (server.hasArg("limit")) limit = constrain(server.arg("limit").toInt(), 1, MAX_LOG_ENTRIES);
 
-        // API: Rename device
-        server.on("/api/devices/0/name", HTTP_POST, [this]() { handleRename(0); });
-        server.on("/api/devices/1/name", HTTP_POST, [this]() { handleRename(1); });
-        server.on("/api/devices/2/name", HTTP_POST, [this]() { handleRename(2); });
-        server.on("/api/devices/3/name", HTTP_POST, [this]() { handleRename(3); });
-        server.on("/api/devices/4/name", HTTP_POST, [this]() { handleRename(4); });
-        server.on("/api/devices/5/name", HTTP_POST, [this]() { handleRename(5); });
-        server.on("/api/devices/6/name", HTTP_POST, [this]() { handleRename(6); });
-        server.on("/api/devices/7/name", HTTP_POST, [this]() { handleRename(7); });
-        server.on("/api/devices/8/name", HTTP_POST, [this]() { handleRename(8); });
-        server.on("/api/devices/9/name", HTTP_POST, [this]() { handleRename(9); });
-
-        // API: Delete device
-        server.on("/api/devices/0", HTTP_DELETE, [this]() { handleDelete(0); });
-        server.on("/api/devices/1", HTTP_DELETE, [this]() { handleDelete(1); });
-        server.on("/api/devices/2", HTTP_DELETE, [this]() { handleDelete(2); });
-        server.on("/api/devices/3", HTTP_DELETE, [this]() { handleDelete(3); });
-        server.on("/api/devices/4", HTTP_DELETE, [this]() { handleDelete(4); });
-        server.on("/api/devices/5", HTTP_DELETE, [this]() { handleDelete(5); });
-        server.on("/api/devices/6", HTTP_DELETE, [this]() { handleDelete(6); });
-        server.on("/api/devices/7", HTTP_DELETE, [this]() { handleDelete(7); });
-        server.on("/api/devices/8", HTTP_DELETE, [this]() { handleDelete(8); });
-        server.on("/api/devices/9", HTTP_DELETE, [this]() { handleDelete(9); });
-
-        // API: Get log
-        server.on("/api/log", HTTP_GET, [this]() {
-            LogEntry entries[MAX_LOG_ENTRIES];
-            int count = storage->getLogEntries(entries, MAX_LOG_ENTRIES);
-
-            String json = "{\"log\":[";
-            for (int i = 0; i < count; i++) {
-                if (i > 0) json += ",";
-
-                char entryJson[128];
+        // Cursor from a wiped log: restart from the current end
+        uint32_t cursor = min(since, nextSeq - 1);
+        // Entries the caller can no longer get (rolled out of the ring)
+        uint32_t missed = (cursor + 1 < oldest) ? oldest - cursor - 1 : 0;
+
+        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server.send(200, "application/json", "");
+
+        ChunkWriter out(server);
+        out("{\"log\":[");
+        LogEntry chunk[LOG_READ_CHUNK];
+        int sent = 0;
+        while (sent < limit) {
+            int n = storage->readLogSince(cursor, chunk, min(LOG_READ_CHUNK, limit - sent));
+            if (n == 0) break;
+
+            for (int i = 0; i < n; i++) {
+                if (sent + i > 0) out(",");
+
+                char entryJson[144];
                 const char* deviceName = "Unknown";
-                if (entries[i].deviceIndex < storage->deviceCount) {
-                    deviceName = storage->devices[entries[i].deviceIndex].name;
+                if (chunk[i].deviceIndex < storage->deviceCount) {
+                    deviceName = storage->devices[chunk[i].deviceIndex].name;
                 }
-                auditLog->getLogEntryJson(&entries[i], entryJson, sizeof(entryJson), deviceName);
-                json += entryJson;
+                auditLog->getLogEntryJson(&chunk[i], entryJson, sizeof(entryJson), deviceName);
+                out(entryJson);
             }
-            json += "]}";
-            server.send(200, "application/json", json);
-        });
+            cursor = chunk[n - 1].seq;
+            sent += n;
+        }
+        if (cursor + 1 < oldest) cursor = oldest - 1;
 
-        // API: Get settings
-        server.on("/api/settings", HTTP_GET, [this]() {
-            String json = "{";
-            json += "\"rssiUnlock\":";
-            json += storage->settings.rssiUnlockThreshold;
-            json += ",\"rssiLock\":";
-            json += storage->settings.rssiLockThreshold;
-            json += ",\"timeout\":";
-            json += storage->settings.proximityTimeout;
-            json += ",\"weakCount\":";
-            json += storage->settings.weakSignalThreshold;
-            json += "}";
-            server.send(200, "application/json", json);
-        });
+        out.printf("],\"next\":%lu,\"more\":%s,\"missed\":%lu}", (unsigned long)cursor,
+            (cursor + 1 < storage->getNextSeq()) ? "true" : "false", (unsigned long)missed);
+        out.flush();
+        server.sendContent("");  // Terminating chunk
+    }
 
-        // API: Save settings
-        server.on("/api/settings", HTTP_POST, [this]() {
-            bool changed = false;
+    // API: Filtered log, ?device=<id>&action=lock|unlock&from=<unix>&to=<unix>
+    // (inclusive, seconds)&limit=<n>&before=<seq>. Newest first; pass `next`
+    // as `before` for the following page. Answered from the log index, so
+    // the work follows the matching entries, not the log size.
+    void handleQueryLog() {
+        LogQuery q = {LOG_ANY, LOG_ANY, 0, 0, UINT32_MAX};
+        if (server.hasArg("device")) q.device = server.arg("device").toInt();
+        if (server.hasArg("action")) {
+            String action = server.arg("action");
+            if (action == "unlock") q.action = ACTION_UNLOCK;
+            else if (action == "lock") q.action = ACTION_LOCK;
+            else {
+                server.send(400, "application/json", "{\"error\":\"action must be lock or unlock\"}");
+                return;
+            }
+        }
+        if (server.hasArg("from")) q.from = strtoul(server.arg("from").c_str(), NULL, 10);
+        if (server.hasArg("to")) q.to = strtoul(server.arg("to").c_str(), NULL, 10);
+        if (server.hasArg("before")) q.before = strtoul(server.arg("before").c_str(), NULL, 10);
+        int limit = MAX_LOG_ENTRIES;
+        if (server.hasArg("limit")) limit = constrain(server.arg("limit").toInt(), 1, MAX_LOG_ENTRIES);
 
-            if (server.hasArg("rssiUnlock")) {
-                storage->settings.rssiUnlockThreshold = server.arg("rssiUnlock").toInt();
-                changed = true;
+        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server.send(200, "application/json", "");
+
+        ChunkWriter out(server);
+        out("{\"log\":[");
+        LogEntry chunk[LOG_READ_CHUNK];
+        LogQueryStats stats = {0, 0, false};
+        uint32_t examined = 0;
+        int sent = 0;
+        while (sent < limit) {
+            int n = storage->queryLog(q, chunk, min(LOG_READ_CHUNK, limit - sent), &stats);
+            examined += stats.examined;
+            for (int i = 0; i < n; i++) {
+                if (sent + i > 0) out(",");
+
+                char entryJson[144];
+                const char* deviceName = "Unknown";
+                if (chunk[i].deviceIndex < storage->deviceCount) {
+                    deviceName = storage->devices[chunk[i].deviceIndex].name;
+                }
+                auditLog->getLogEntryJson(&chunk[i], entryJson, sizeof(entryJson), deviceName);
+                out(entryJson);
             }
-            if (server.hasArg("rssiLock")) {
-                storage->settings.rssiLockThreshold = server.arg("rssiLock").toInt();
-                changed = true;
+            sent += n;
+            if (stats.next == 0) break;
+            q.before = stats.next;
+        }
+
+        out.printf("],\"next\":%lu,\"more\":%s,\"examined\":%lu,\"indexed\":%s}", (unsigned long)stats.next,
+            stats.next ? "true" : "false", (unsigned long)examined, stats.chain ? "true" : "false");
+        out.flush();
+        server.sendContent("");  // Terminating chunk
+    }
+
+    // API: Binary log export (format in log_export.h), optional ?since=<seq>
+    // Streams fixed-width records straight from storage, no JSON or strftime
+    void handleExportLog(const RouteParams& params) {
+        uint32_t end = storage->getNextSeq();
+        uint32_t since = 0;
+        if (server.hasArg("since")) since = strtoul(server.arg("since").c_str(), NULL, 10);
+        uint32_t first = max(min(since, end - 1) + 1, storage->getOldestSeq());
+        uint32_t count = end - first;
+
+        LogExportHeader header;
+        memcpy(header.magic, LOG_EXPORT_MAGIC, 4);
+        header.version = LOG_EXPORT_VERSION;
+        header.recordSize = sizeof(LogExportRecord);
+        header.flags = auditLog->isNtpSynced() ? LOG_EXPORT_NTP_SYNCED : 0;
+        header.count = count;
+        header.nextCursor = end - 1;
+
+        server.sendHeader("Content-Disposition", "attachment; filename=\"keyless-log.klg\"");
+        server.setContentLength(sizeof(header) + count * sizeof(LogExportRecord));
+        server.send(200, "application/octet-stream", "");
+        server.sendContent((const char*)&header, sizeof(header));
+
+        LogEntry chunk[LOG_READ_CHUNK];
+        LogExportRecord records[LOG_READ_CHUNK];
+        uint32_t cursor = first - 1;
+        uint32_t sent = 0;
+        while (sent < count) {
+            int want = min((uint32_t)LOG_READ_CHUNK, count - sent);
+            int n = storage->readLogSince(cursor, chunk, want, end);
+            for (int i = 0; i < n; i++) {
+                auditLog->getLogEntryRecord(&chunk[i], &records[i]);
             }
-            if (server.hasArg("timeout")) {
-                storage->settings.proximityTimeout = server.arg("timeout").toInt();
-                changed = true;
+            if (n > 0) {
+                cursor = chunk[n - 1].seq;
+            } else {
+                // Entries overwritten mid-export: pad to the announced length (seq 0 = skip)
+                n = want;
+                memset(records, 0, n * sizeof(LogExportRecord));
+            }
+            server.sendContent((const char*)records, n * sizeof(LogExportRecord));
+            sent += n;
+        }
+    }
+
+    // API: Get settings
+    void handleGetSettings(const RouteParams& params) {
+        KeylessSettings settings = proximityConfig().toSettings();
+        char json[96];
+        snprintf(json, sizeof(json), "{\"rssiUnlock\":%d,\"rssiLock\":%d,\"timeout\":%u,\"weakCount\":%u}",
+            settings.rssiUnlockThreshold, settings.rssiLockThreshold,
+            settings.proximityTimeout, settings.weakSignalThreshold);
+        server.send(200, "application/json", json);
+    }
+
+    // API: Save settings. Validated as a whole before anything is applied
+    // or stored; out-of-range values answer 400 and change nothing.
+    void handleSaveSettings(const RouteParams& params) {
+        bool changed = false;
+        ProximityConfig cfg = proximityConfig();
+
+        if (server.hasArg("rssiUnlock")) {
+            cfg.unlockRssi = server.arg("rssiUnlock").toInt();
+            changed = true;
+        }
+        if (server.hasArg("rssiLock")) {
+            cfg.lockRssi = server.arg("rssiLock").toInt();
+            changed = true;
+        }
+        if (server.hasArg("timeout")) {
+            long timeout = server.arg("timeout").toInt();
+            cfg.timeoutMs = timeout > 0 ? timeout * 1000UL : 0;
+            changed = true;
+        }
+        if (server.hasArg("weakCount")) {
+            cfg.weakThreshold = server.arg("weakCount").toInt();
+            changed = true;
+        }
+
+        if (!changed) {
+            server.send(400, "application/json", "{\"error\":\"No settings provided\"}");
+            return;
+        }
+
+        const char* error = applyProximityConfig(cfg);
+        if (error) {
+            char json[64];
+            snprintf(json, sizeof(json), "{\"error\":\"%s\"}", error);
+            server.send(400, "application/json", json);
+            return;
+        }
+
+        storage->settings = cfg.toSettings();
+        storage->saveSettings();
+        Serial.printf("Settings applied: Unlock=%d, Lock=%d, Timeout=%lums, WeakThr=%d\n",
+            cfg.unlockRssi,
+            cfg.lockRssi,
+            cfg.timeoutMs,
+            cfg.weakThreshold);
+        server.send(200, "application/json", "{\"success\":true}");
+    }
+
+    // API: System status
+    void handleStatus(const RouteParams& params) {
+        unsigned long uptime = (millis() - startTime) / 1000;
+        unsigned long hours = uptime / 3600;
+        unsigned long minutes = (uptime % 3600) / 60;
+
+        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server.send(200, "application/json", "");
+
+        ChunkWriter out(server);
+        out.printf("{\"wifi\":%s,\"ip\":\"%s\",\"wifiConnectMs\":%lu,\"wifiFastPath\":%s,\"uptime\":\"%luh %lum\"",
+            wifiManager->isConnected() ? "true" : "false", wifiManager->ipAddress.c_str(),
+            (unsigned long)wifiManager->getLastConnectMs(), wifiManager->wasLastConnectFast() ? "true" : "false",
+            hours, minutes);
+        out.printf(",\"devices\":%d,\"logEntries\":%d,\"ntpSynced\":%s,\"ntpSyncs\":%lu,\"ntpDriftMs\":%ld",
+            storage->deviceCount, auditLog->getEntryCount(), auditLog->isNtpSynced() ? "true" : "false",
+            (unsigned long)auditLog->getNtpSyncCount(), (long)auditLog->getLastDriftMs());
+        out.printf(",\"routerBytes\":%u,\"dispatchUs\":%lu,\"dispatchMaxUs\":%lu,\"eventClients\":%d,\"eventsDropped\":%lu",
+            (unsigned)router.getMemoryFootprint(), (unsigned long)router.getLastDispatchUs(),
+            (unsigned long)router.getMaxDispatchUs(), events->getClientCount(), (unsigned long)events->getDroppedCount());
+        out.printf(",\"webGapMs\":%lu,\"webGapMaxMs\":%lu,\"scanGapMaxMs\":%lu,\"proximityGapMs\":%lu,\"proximityGapMaxMs\":%lu",
+            (unsigned long)netTiming.lastGapMs, (unsigned long)netTiming.maxGapMs, (unsigned long)scanTiming.maxGapMs,
+            (unsigned long)proximityTiming.lastGapMs, (unsigned long)proximityTiming.maxGapMs);
+        out.printf(",\"resolveGapMaxMs\":%lu,\"ingestQueued\":%lu,\"ingestDropped\":%lu",
+            (unsigned long)resolveTiming.maxGapMs, (unsigned long)ingestQueue.size(),
+            (unsigned long)ingestQueue.getDropped());
+
+        uint32_t advertRate = coex.getAdvertRateX100(coex.getPolicy());
+        out.printf(",\"coexPolicy\":\"%s\",\"advertsPerSec\":%lu.%02lu}", coex.getProfile().name,
+            (unsigned long)(advertRate / 100), (unsigned long)(advertRate % 100));
+        out.flush();
+        server.sendContent("");  // Terminating chunk
+    }
+
+    // Prometheus scrape endpoint
+    void handleMetrics(const RouteParams& params) {
+        static const char* const taskNames[] = {"network", "bleScan", "resolve", "loop", "diag"};
+        TaskHandle_t tasks[] = {netTaskHandle, scanTaskHandle, resolveTaskHandle, loopTaskHandle, diagTaskHandle};
+
+        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server.send(200, "text/plain; version=0.0.4", "");
+
+        ChunkWriter out(server);
+        metrics.render(out, storage->deviceCount, tasks, taskNames, 5);
+        Metrics::writeHelp(out, "keyless_ingest_dropped_total", "counter", "RPA candidates dropped on a full ingest queue");
+        Metrics::writeValue(out, "keyless_ingest_dropped_total", "", ingestQueue.getDropped());
+#if STRESS_INJECT
+        Metrics::writeHelp(out, "keyless_inject_dropped_total", "counter", "Injected adverts dropped on a full inject queue");
+        Metrics::writeValue(out, "keyless_inject_dropped_total", "", injectQueue.getDropped());
+#endif
+        Metrics::writeGauge(out, "keyless_ingest_queue_high_water", "Most adverts waiting for the resolve task at once",
+                            ingestQueue.getHighWater());
+        Metrics::writeGauge(out, "keyless_decision_queue_high_water", "Most decisions waiting for the loop task at once",
+                            decisionQueue.getHighWater());
+        coex.render(out);
+        out.flush();
+        server.sendContent("");  // Terminating chunk
+    }
+
+    // API: Usage per device, ?tier=hour|day|week (default day)&device=<id>
+    // (default all). Columns oldest first from `start`, `step` seconds apart,
+    // UTC; rssi is the average at unlock (null without unlocks). Copies the
+    // rollup buckets, so the cost is fixed whatever the log holds.
+    void handleStats(const RouteParams& params) {
+        RollupTier tier = ROLLUP_DAY;
+        if (server.hasArg("tier")) {
+            String name = server.arg("tier");
+            if (name == "hour") tier = ROLLUP_HOUR;
+            else if (name == "week") tier = ROLLUP_WEEK;
+            else if (name != "day") {
+                server.send(400, "application/json", "{\"error\":\"tier must be hour, day or week\"}");
+                return;
             }
-            if (server.hasArg("weakCount")) {
-                storage->settings.weakSignalThreshold = server.arg("weakCount").toInt();
-                changed = true;
+        }
+        int first = 0, last = storage->deviceCount - 1;
+        if (server.hasArg("device")) {
+            first = last = server.arg("device").toInt();
+            if (first < 0 || first >= storage->deviceCount) {
+                server.send(400, "application/json", "{\"error\":\"Invalid device\"}");
+                return;
             }
+        }
 
-            if (changed) {
-                storage->saveSettings();
+        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server.send(200, "application/json", "");
 
-                // Apply settings to global variables immediately
-                RSSI_UNLOCK_THRESHOLD = storage->settings.rssiUnlockThreshold;
-                RSSI_LOCK_THRESHOLD = storage->settings.rssiLockThreshold;
-                PROXIMITY_TIMEOUT = storage->settings.proximityTimeout * 1000UL;
-                WEAK_SIGNAL_THRESHOLD = storage->settings.weakSignalThreshold;
+        ChunkWriter out(server);
+        static const char* const TIER_NAMES[] = {"hour", "day", "week"};
+        uint32_t now = auditLog->unixNow();
+        out.printf("{\"tier\":\"%s\",\"now\":%lu,\"devices\":[", TIER_NAMES[tier], (unsigned long)now);
+        RollupSeries series;
+        for (int d = first; d <= last; d++) {
+            out.printf("%s{\"device\":%d,\"name\":\"%s\"", d > first ? "," : "", d, storage->devices[d].name);
+            if (rollup.getSeries(d, tier, now, &series)) {
+                out.printf(",\"start\":%lu,\"step\":%lu,\"presence\":[", (unsigned long)series.firstStart,
+                    (unsigned long)series.step);
+                for (int k = 0; k < series.count; k++) {
+                    out.printf("%s%lu", k ? "," : "", (unsigned long)series.buckets[k].presenceS);
+                }
+                out("],\"unlocks\":[");
+                for (int k = 0; k < series.count; k++) out.printf("%s%u", k ? "," : "", series.buckets[k].unlocks);
+                out("],\"locks\":[");
+                for (int k = 0; k < series.count; k++) out.printf("%s%u", k ? "," : "", series.buckets[k].locks);
+                out("],\"rssi\":[");
+                for (int k = 0; k < series.count; k++) {
+                    const RollupBucket& b = series.buckets[k];
+                    if (b.unlocks) out.printf("%s%ld", k ? "," : "", (long)(b.rssiSum / (int32_t)b.unlocks));
+                    else out(k ? ",null" : "null");
+                }
+                out("]");
+            }
+            // Before the first NTP sync of this boot: not yet in any bucket
+            RollupBucket pending = rollup.getPending(d);
+            out.printf(",\"unattributed\":{\"presence\":%lu,\"unlocks\":%u,\"locks\":%u}}",
+                (unsigned long)pending.presenceS, pending.unlocks, pending.locks);
+        }
+        out("]}");
+        out.flush();
+        server.sendContent("");  // Terminating chunk
+    }
 
-                Serial.printf("Settings applied: Unlock=%d, Lock=%d, Timeout=%lums, WeakThr=%d\n",
-                    RSSI_UNLOCK_THRESHOLD,
-                    RSSI_LOCK_THRESHOLD,
-                    PROXIMITY_TIMEOUT,
-                    WEAK_SIGNAL_THRESHOLD);
-                server.send(200, "application/json", "{\"success\":true}");
-            } else {
-                server.send(400, "application/json", "{\"error\":\"No settings provided\"}");
+    // API: Diagnostics ring (diag.h), ?since=<seq>&level=<1-4> (default all)
+    // lines: [seq, ms, "E|W|I|D", text], oldest first; pass `next` as `since`.
+    // `lost` counts records overwritten before this read got to them.
+    void handleDiag(const RouteParams& params) {
+        uint32_t since = 0;
+        if (server.hasArg("since")) since = strtoul(server.arg("since").c_str(), NULL, 10);
+        int maxLevel = DIAG_LEVEL_DEBUG;
+        if (server.hasArg("level")) maxLevel = constrain(server.arg("level").toInt(), DIAG_LEVEL_ERROR, DIAG_LEVEL_DEBUG);
+
+        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server.send(200, "application/json", "");
+
+        ChunkWriter out(server);
+        out("{\"lines\":[");
+        DiagRecord chunk[8];
+        char text[DIAG_LINE_MAX];
+        char escaped[DIAG_LINE_MAX * 2];
+        uint32_t cursor = since, lost = 0;
+        int sent = 0;
+        for (;;) {
+            uint32_t next;
+            int n = diag.readSince(cursor, chunk, 8, &next);
+            // A cursor from before a reboot restarts at the oldest record
+            uint32_t expected = cursor <= diag.getHead() ? cursor : 0;
+            for (int k = 0; k < n; k++) {
+                if (chunk[k].seq > expected) lost += chunk[k].seq - expected;
+                expected = chunk[k].seq + 1;
+                if (chunk[k].level > maxLevel) continue;
+                DiagLog::format(chunk[k], text, sizeof(text));
+                jsonEscape(text, escaped, sizeof(escaped));
+                out.printf("%s[%lu,%lu,\"%c\",\"", sent ? "," : "", (unsigned long)chunk[k].seq,
+                    (unsigned long)chunk[k].ms, DIAG_LEVEL_CHARS[chunk[k].level]);
+                out(escaped);
+                out("\"]");
+                sent++;
             }
-        });
+            cursor = next;
+            if (n == 0) break;
+        }
+        out.printf("],\"next\":%lu,\"lost\":%lu}", (unsigned long)cursor, (unsigned long)lost);
+        out.flush();
+        server.sendContent("");  // Terminating chunk
+    }
 
-        // API: System status
-        server.on("/api/status", HTTP_GET, [this]() {
-            unsigned long uptime = (millis() - startTime) / 1000;
-            unsigned long hours = uptime / 3600;
-            unsigned long minutes = (uptime % 3600) / 60;
-
-            String json = "{";
-            json += "\"wifi\":";
-            json += wifiManager->isConnected() ? "true" : "false";
-            json += ",\"ip\":\"";
-            json += wifiManager->ipAddress;
-            json += "\",\"uptime\":\"";
-            json += hours;
-            json += "h ";
-            json += minutes;
-            json += "m\",\"devices\":";
-            json += storage->deviceCount;
-            json += ",\"logEntries\":";
-            json += auditLog->getEntryCount();
-            json += ",\"ntpSynced\":";
-            json += auditLog->isNtpSynced() ? "true" : "false";
-            json += "}";
-
-            server.send(200, "application/json", json);
-        });
+    // JSON string body without the quotes; control characters become spaces
+    static void jsonEscape(const char* text, char* out, size_t size) {
+        size_t used = 0;
+        for (const char* p = text; *p && used + 2 < size; p++) {
+            if (*p == '"' || *p == '\\') out[used++] = '\\';
+            out[used++] = (unsigned char)*p < 0x20 ? ' ' : *p;
+        }
+        out[used] = '\0';
+    }
 
-        server.begin();
-        Serial.println("Web server started on port 80");
+    // API: Task table and heap/CPU history (oldest first)
+    // history rows: [uptimeS, freeHeap, minFreeHeap, largestBlock, fragPct, cpu0, cpu1]
+    void handleTelemetry(const RouteParams& params) {
+        TaskSample tasks[TELEMETRY_MAX_TASKS];
+        int taskCount = telemetry.getTasks(tasks, TELEMETRY_MAX_TASKS);
+
+        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server.send(200, "application/json", "");
+
+        ChunkWriter out(server);
+        char line[112];
+        snprintf(line, sizeof(line), "{\"periodMs\":%d,\"sampleUs\":%lu,\"tasks\":[",
+            TELEMETRY_PERIOD_MS, (unsigned long)telemetry.getSampleUs());
+        out(line);
+        for (int i = 0; i < taskCount; i++) {
+            char cpu[8];
+            formatPct(cpu, sizeof(cpu), tasks[i].cpuPct);
+            snprintf(line, sizeof(line), "%s{\"name\":\"%s\",\"core\":%d,\"prio\":%u,\"cpu\":%s,\"stack\":%lu}",
+                i ? "," : "", tasks[i].name, tasks[i].core == 2 ? -1 : tasks[i].core,
+                tasks[i].priority, cpu, (unsigned long)tasks[i].stackFree);
+            out(line);
+        }
+        out("],\"history\":[");
+
+        HeapSample history[TELEMETRY_HISTORY];
+        int n = telemetry.getHistory(history, TELEMETRY_HISTORY);
+        for (int i = 0; i < n; i++) {
+            char cpu0[8], cpu1[8];
+            formatPct(cpu0, sizeof(cpu0), history[i].cpuPct[0]);
+            formatPct(cpu1, sizeof(cpu1), history[i].cpuPct[1]);
+            snprintf(line, sizeof(line), "%s[%lu,%lu,%lu,%lu,%u,%s,%s]", i ? "," : "",
+                (unsigned long)history[i].uptimeS, (unsigned long)history[i].freeHeap,
+                (unsigned long)history[i].minFreeHeap, (unsigned long)history[i].largestBlock,
+                history[i].fragPct, cpu0, cpu1);
+            out(line);
+        }
+        out("]}");
+        out.flush();
+        server.sendContent("");  // Terminating chunk
     }
 
-    void handleClient() {
-        server.handleClient();
+    static void formatPct(char* buf, size_t size, uint8_t pct) {
+        if (pct == TELEMETRY_CPU_UNKNOWN) snprintf(buf, size, "null");
+        else snprintf(buf, size, "%u", pct);
     }
 
-private:
-    void handleRename(int index) {
-        if (server.hasArg("name")) {
-            String newName = server.arg("name");
-            if (storage->renameDevice(index, newName.c_str())) {
-                server.send(200, "application/json", "{\"success\":true}");
-                Serial.printf("Device %d renamed to: %s\n", index, newName.c_str());
-            } else {
-                server.send(400, "application/json", "{\"error\":\"Invalid index\"}");
+    // API: Trace ring dump (format in trace.h), optional ?since=<index>
+    // Records are [index, core, event, cycles, arg]; decode with tools/trace_report.py
+    void handleTrace(const RouteParams& params) {
+        uint32_t since = 0;
+        if (server.hasArg("since")) since = strtoul(server.arg("since").c_str(), NULL, 10);
+
+        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server.send(200, "application/json", "");
+
+        ChunkWriter out(server);
+        char line[96];
+        snprintf(line, sizeof(line), "{\"cpuMhz\":%lu,\"ringSize\":%d,\"events\":[",
+            (unsigned long)getCpuFrequencyMhz(), TRACE_RING_SIZE);
+        out(line);
+        for (int i = 0; i < TRACE_EVENT_COUNT; i++) {
+            snprintf(line, sizeof(line), "%s\"%s\"", i ? "," : "", TRACE_EVENT_NAMES[i]);
+            out(line);
+        }
+        out("],\"records\":[");
+
+        TraceRecord chunk[TRACE_READ_CHUNK];
+        uint32_t cursor = since;
+        uint32_t end = trace.getHead();
+        bool first = true;
+        while (cursor != end) {
+            uint32_t next;
+            int n = trace.readSince(cursor, chunk, TRACE_READ_CHUNK, &next);
+            for (int i = 0; i < n; i++) {
+                snprintf(line, sizeof(line), "%s[%lu,%u,%u,%lu,%lu]", first ? "" : ",",
+                    (unsigned long)chunk[i].index, chunk[i].core, chunk[i].event,
+                    (unsigned long)chunk[i].cycles, (unsigned long)chunk[i].arg);
+                out(line);
+                first = false;
             }
-        } else {
-            server.send(400, "application/json", "{\"error\":\"Missing name\"}");
+            if (next == cursor) break;
+            cursor = next;
+            // Stop at the head seen on entry; later records go to the next call
+            if ((int32_t)(cursor - end) >= 0) break;
         }
+
+        snprintf(line, sizeof(line), "],\"next\":%lu}", (unsigned long)cursor);
+        out(line);
+        out.flush();
+        server.sendContent("");  // Terminating chunk
     }
 
-    void handleDelete(int index) {
-        if (storage->deleteDevice(index)) {
-            server.send(200, "application/json", "{\"success\":true}");
-            Serial.printf("Device %d deleted\n", index);
-        } else {
-            server.send(400, "application/json", "{\"error\":\"Invalid index\"}");
+    // API: Live event stream (Server-Sent Events), optional ?rate=<ms> for RSSI
+    void handleEvents(const RouteParams& params) {
+        uint16_t rate = EVENT_RSSI_INTERVAL_MS;
+        if (server.hasArg("rate")) {
+            rate = constrain(server.arg("rate").toInt(), 0, 60000);
+        }
+
+        if (!events->addClient(server.client(), rate)) {
+            server.send(503, "application/json", "{\"error\":\"Too many event clients\"}");
+            return;
         }
+        // Handed off: serve the next request right away
+        server.releaseClient();
     }
 };
 
@@ -2,6 +2,9 @@
  * WiFi Manager - WiFi client with AP setup mode and NTP sync
  * First boot: Creates AP "ESP32-Keyless-Setup" for WiFi configuration
  * After config: Connects as client to configured network
+ * Reconnects try the last good BSSID/channel first (no scan), reusing the
+ * DHCP lease as a static config while it is young enough (no DHCP), and
+ * fall back to a full scan + DHCP.
  */
 
 #ifndef WIFI_MANAGER_H
@@ -13,109 +16,72 @@
 #include <Preferences.h>
 #include <time.h>
 #include <esp_task_wdt.h>
+#include <esp_sntp.h>
 #include "audit_log.h"
+#include "web_assets.h"
 
 // AP Configuration
 #define AP_SSID "ESP32-Keyless-Setup"
 #define AP_PASS "keyless123"
 
-// NTP configuration
+// NTP configuration (override NTP_SERVER with -DNTP_SERVER=\"192.168.1.10\" for a local server)
+#ifndef NTP_SERVER
 #define NTP_SERVER "pool.ntp.org"
+#endif
 #define GMT_OFFSET_SEC 3600      // UTC+1 (Germany)
 #define DAYLIGHT_OFFSET_SEC 3600 // Daylight saving time
+#define NTP_RESYNC_INTERVAL_MS 3600000  // Periodic drift correction (1h)
 
 // Reconnect settings
-#define WIFI_RECONNECT_INTERVAL 30000
-#define WIFI_CONNECT_TIMEOUT 15000
-
-// Setup portal HTML
-const char SETUP_HTML[] PROGMEM = R"rawliteral(
-<!DOCTYPE html>
-<html><head>
-<meta charset="UTF-8">
-<meta name="viewport" content="width=device-width,initial-scale=1">
-<title>ESP32 Keyless - WiFi Setup</title>
-<style>
-*{box-sizing:border-box;margin:0;padding:0}
-body{font-family:system-ui,-apple-system,sans-serif;background:#1a1a2e;color:#eee;padding:20px;max-width:400px;margin:0 auto}
-h1{font-size:1.3em;margin-bottom:20px;color:#4cc9f0;text-align:center}
-.card{background:#16213e;border-radius:8px;padding:16px;margin-bottom:16px}
-label{display:block;margin-bottom:6px;font-size:0.9em;color:#888}
-input,select{width:100%;padding:10px;margin-bottom:12px;border:1px solid #4cc9f0;border-radius:4px;background:#0f3460;color:#eee;font-size:1em}
-select{cursor:pointer}
-.btn{width:100%;background:#4cc9f0;color:#1a1a2e;border:none;padding:12px;border-radius:4px;cursor:pointer;font-size:1em;font-weight:bold}
-.btn:hover{background:#3aa8d8}
-.btn:disabled{background:#666;cursor:not-allowed}
-.info{font-size:0.8em;color:#666;text-align:center;margin-top:16px}
-.scanning{color:#4cc9f0;text-align:center;padding:20px}
-.network{padding:8px;margin:4px 0;background:#0f3460;border-radius:4px;cursor:pointer;display:flex;justify-content:space-between}
-.network:hover{background:#1a3a6e}
-.signal{color:#4cc9f0;font-size:0.9em}
-#status{margin-top:12px;padding:10px;border-radius:4px;text-align:center;display:none}
-.success{background:#2d6a4f;display:block!important}
-.error{background:#9d0208;display:block!important}
-</style>
-</head><body>
-<h1>ESP32 Keyless<br>WiFi Setup</h1>
-<div class="card">
-<div id="networks"><div class="scanning">Scanning networks...</div></div>
-</div>
-<div class="card">
-<form id="form" onsubmit="return save()">
-<label>WiFi Network (SSID)</label>
-<input type="text" id="ssid" required placeholder="Select from list or type manually">
-<label>Password</label>
-<input type="password" id="pass" placeholder="WiFi password">
-<button type="submit" class="btn" id="btn">Connect</button>
-<div id="status"></div>
-</form>
-</div>
-<div class="info">After connecting, the device will restart<br>and connect to your WiFi network.</div>
-<script>
-function scan(){
-fetch('/scan').then(r=>r.json()).then(d=>{
-let h='';
-d.networks.forEach(n=>{
-h+='<div class="network" onclick="sel(\''+n.ssid+'\')"><span>'+n.ssid+'</span><span class="signal">'+n.rssi+' dBm</span></div>';
-});
-document.getElementById('networks').innerHTML=h||'<div class="scanning">No networks found</div>';
-}).catch(()=>{
-document.getElementById('networks').innerHTML='<div class="scanning">Scan failed - refresh page</div>';
-});
-}
-function sel(s){document.getElementById('ssid').value=s;}
-function save(){
-let ssid=document.getElementById('ssid').value;
-let pass=document.getElementById('pass').value;
-let btn=document.getElementById('btn');
-let status=document.getElementById('status');
-btn.disabled=true;btn.textContent='Connecting...';
-status.className='';status.style.display='none';
-fetch('/save',{method:'POST',headers:{'Content-Type':'application/x-www-form-urlencoded'},
-body:'ssid='+encodeURIComponent(ssid)+'&pass='+encodeURIComponent(pass)})
-.then(r=>r.json()).then(d=>{
-if(d.success){
-status.textContent='Connected! Restarting...';
-status.className='success';
-}else{
-status.textContent='Connection failed: '+d.error;
-status.className='error';
-btn.disabled=false;btn.textContent='Connect';
-}
-}).catch(()=>{
-status.textContent='Error - try again';
-status.className='error';
-btn.disabled=false;btn.textContent='Connect';
-});
-return false;
-}
-scan();
-</script>
-</body></html>
-)rawliteral";
+#define WIFI_RECONNECT_INTERVAL 8000      // Backoff cap between attempts
+#define WIFI_RECONNECT_MIN_MS 500         // First retry after a drop
+#define WIFI_CONNECT_TIMEOUT 15000        // Full scan + DHCP
+#define WIFI_FAST_CONNECT_TIMEOUT 2000    // Cached BSSID/channel/IP
+#define WIFI_FULL_SCAN_EVERY 4            // Full attempt after this many failed fast ones
+#define WIFI_LEASE_REUSE_MAX_S 43200      // Cached lease reused for 12 h (typical leases: 24 h+)
+
+// Optional static IP, e.g. -DWIFI_STATIC_IP=\"192.168.1.50\" (overrides the cached lease)
+#ifdef WIFI_STATIC_IP
+#ifndef WIFI_STATIC_GATEWAY
+#error "WIFI_STATIC_IP requires WIFI_STATIC_GATEWAY"
+#endif
+#ifndef WIFI_STATIC_SUBNET
+#define WIFI_STATIC_SUBNET "255.255.255.0"
+#endif
+#ifndef WIFI_STATIC_DNS
+#define WIFI_STATIC_DNS WIFI_STATIC_GATEWAY
+#endif
+#endif
+
+// Setup portal: background scan cache and connect state machine
+#define PORTAL_MAX_NETWORKS 20
+#define PORTAL_SCAN_MAX_AGE_MS 15000    // Rescan when the cache is older
+#define PORTAL_RESTART_DELAY_MS 2000    // Let the page see "connected" first
+
+enum PortalConnectState {
+    PORTAL_IDLE,
+    PORTAL_PENDING,      // Waiting for a running scan to finish
+    PORTAL_CONNECTING,
+    PORTAL_CONNECTED,    // Credentials saved, restart scheduled
+    PORTAL_FAILED
+};
 
 class WifiManager {
 private:
+    // Instance that receives SNTP callbacks (plain function pointer API)
+    static WifiManager*& ntpOwner() {
+        static WifiManager* owner = nullptr;
+        return owner;
+    }
+
+    // Runs in the lwIP task after each successful SNTP sync
+    static void onTimeSync(struct timeval* tv) {
+        WifiManager* self = ntpOwner();
+        if (self && self->auditLog) {
+            self->auditLog->setNtpSync(tv->tv_sec, tv->tv_usec);
+        }
+    }
+
     Preferences wifiPrefs;
     AuditLog* auditLog;
     WebServer* setupServer = nullptr;
@@ -124,7 +90,9 @@ private:
     bool configured = false;
     bool connected = false;
     bool apMode = false;
-    bool ntpInitialized = false;
+    bool ntpStarted = false;
+    bool ntpPending = false;            // Connected, NTP start not yet allowed
+    bool deferNonUrgent = false;        // BLE has the radio (see coex.h)
     unsigned long lastReconnectAttempt = 0;
     unsigned long connectStartTime = 0;
     bool connecting = false;
@@ -132,6 +100,117 @@ private:
     String storedSSID = "";
     String storedPass = "";
 
+    // Last good association, persisted as NVS blob "wificreds"/"fast"
+    struct FastConnectCache {
+        uint8_t bssid[6];
+        uint8_t channel;            // 0 = no cache
+        uint8_t reserved;
+        uint32_t ip;                // 0 = DHCP
+        uint32_t gateway;
+        uint32_t subnet;
+        uint32_t dns;
+        uint32_t leaseUnix;         // Wall time DHCP granted `ip`, 0 = unknown
+    };
+    FastConnectCache fastCache = {};
+    bool fastAttempt = false;           // Current attempt uses the cache
+    bool leaseReused = false;           // Current attempt/connection runs on the cached lease
+    bool leaseUndated = false;          // DHCP lease taken before NTP, at leaseAtMs
+    uint32_t leaseAtMs = 0;
+    uint8_t fastFailures = 0;           // Consecutive fast-path timeouts
+    unsigned long reconnectDelay = WIFI_RECONNECT_MIN_MS;
+    uint32_t lastConnectMs = 0;
+    bool lastConnectFast = false;
+
+    // Setup portal state (AP mode only)
+    struct PortalNetwork {
+        char ssid[33];
+        int8_t rssi;
+        bool secure;
+    };
+    PortalNetwork portalNetworks[PORTAL_MAX_NETWORKS];
+    int portalNetworkCount = 0;
+    unsigned long portalScanTime = 0;     // millis() of the cached result (0 = none)
+    bool portalScanning = false;
+
+    PortalConnectState portalState = PORTAL_IDLE;
+    String portalSSID = "";
+    String portalPass = "";
+    unsigned long portalStateTime = 0;
+
+    static void appendJsonEscaped(String& json, const char* text) {
+        for (const char* c = text; *c; c++) {
+            if (*c == '"' || *c == '\\') json += '\\';
+            if ((uint8_t)*c >= 0x20) json += *c;
+        }
+    }
+
+    void startPortalScan() {
+        if (portalScanning || portalState == PORTAL_CONNECTING) return;
+        if (WiFi.scanNetworks(true) == WIFI_SCAN_RUNNING) {
+            portalScanning = true;
+        }
+    }
+
+    // Poll background scan and connect attempt (called from update())
+    void updatePortal() {
+        if (portalScanning) {
+            int16_t n = WiFi.scanComplete();
+            if (n >= 0) {
+                portalNetworkCount = min((int)n, PORTAL_MAX_NETWORKS);
+                for (int i = 0; i < portalNetworkCount; i++) {
+                    strncpy(portalNetworks[i].ssid, WiFi.SSID(i).c_str(), sizeof(portalNetworks[i].ssid) - 1);
+                    portalNetworks[i].ssid[sizeof(portalNetworks[i].ssid) - 1] = '\0';
+                    portalNetworks[i].rssi = WiFi.RSSI(i);
+                    portalNetworks[i].secure = WiFi.encryptionType(i) != WIFI_AUTH_OPEN;
+                }
+                WiFi.scanDelete();
+                portalScanTime = millis();
+                portalScanning = false;
+            } else if (n == WIFI_SCAN_FAILED) {
+                portalScanning = false;
+            }
+        }
+
+        switch (portalState) {
+            case PORTAL_PENDING:
+                if (!portalScanning) {
+                    Serial.printf("Trying to connect to: %s\n", portalSSID.c_str());
+                    WiFi.begin(portalSSID.c_str(), portalPass.c_str());  // AP stays up (AP+STA)
+                    portalState = PORTAL_CONNECTING;
+                    portalStateTime = millis();
+                }
+                break;
+
+            case PORTAL_CONNECTING: {
+                wl_status_t status = WiFi.status();
+                if (status == WL_CONNECTED) {
+                    Serial.printf("Connected! IP: %s\n", WiFi.localIP().toString().c_str());
+                    saveCredentials(portalSSID, portalPass);
+                    portalPass = "";
+                    portalState = PORTAL_CONNECTED;
+                    portalStateTime = millis();
+                } else if (status == WL_CONNECT_FAILED || status == WL_NO_SSID_AVAIL ||
+                           millis() - portalStateTime > WIFI_CONNECT_TIMEOUT) {
+                    Serial.println("Connection failed");
+                    WiFi.disconnect(false);
+                    portalPass = "";
+                    portalState = PORTAL_FAILED;
+                    portalStateTime = millis();
+                }
+                break;
+            }
+
+            case PORTAL_CONNECTED:
+                if (millis() - portalStateTime > PORTAL_RESTART_DELAY_MS) {
+                    ESP.restart();
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+
     void loadCredentials() {
         wifiPrefs.begin("wificreds", true);  // Read-only
         storedSSID = wifiPrefs.getString("ssid", "");
@@ -140,17 +219,170 @@ private:
 
         configured = (storedSSID.length() > 0);
         Serial.printf("WiFi credentials %s\n", configured ? "found" : "not found");
+
+        wifiPrefs.begin("wificreds", true);
+        if (wifiPrefs.getBytesLength("fast") != sizeof(fastCache) ||
+            wifiPrefs.getBytes("fast", &fastCache, sizeof(fastCache)) != sizeof(fastCache)) {
+            memset(&fastCache, 0, sizeof(fastCache));
+        }
+        wifiPrefs.end();
+        if (fastCache.channel) {
+            Serial.printf("WiFi fast-connect cache: channel %u, BSSID %02X:%02X:%02X:%02X:%02X:%02X\n",
+                fastCache.channel, fastCache.bssid[0], fastCache.bssid[1], fastCache.bssid[2],
+                fastCache.bssid[3], fastCache.bssid[4], fastCache.bssid[5]);
+        }
+    }
+
+    void writeFastCache() {
+        wifiPrefs.begin("wificreds", false);
+        wifiPrefs.putBytes("fast", &fastCache, sizeof(fastCache));
+        wifiPrefs.end();
+    }
+
+    // Remember the association that just succeeded; NVS is only written
+    // when something changed (roaming to another AP, new lease).
+    void saveFastCache() {
+        FastConnectCache fresh = {};
+        uint8_t* bssid = WiFi.BSSID();
+        if (!bssid) return;
+        memcpy(fresh.bssid, bssid, sizeof(fresh.bssid));
+        fresh.channel = WiFi.channel();
+        fresh.ip = (uint32_t)WiFi.localIP();
+        fresh.gateway = (uint32_t)WiFi.gatewayIP();
+        fresh.subnet = (uint32_t)WiFi.subnetMask();
+        fresh.dns = (uint32_t)WiFi.dnsIP(0);
+        if (usesDhcp()) {
+            fresh.leaseUnix = auditLog ? auditLog->unixNow() : 0;
+            leaseUndated = fresh.leaseUnix == 0;
+            leaseAtMs = millis();
+        } else {
+            fresh.leaseUnix = fastCache.leaseUnix;
+        }
+
+        if (memcmp(&fresh, &fastCache, sizeof(fresh)) == 0) return;
+        fastCache = fresh;
+        writeFastCache();
+        DIAG_INFO("WiFi fast-connect cache updated (channel %u)", fastCache.channel);
+    }
+
+    // A lease taken before the first NTP sync is dated once the clock is known
+    void dateLease() {
+        if (!leaseUndated || !auditLog || !auditLog->isNtpSynced()) return;
+        leaseUndated = false;
+        fastCache.leaseUnix = auditLog->unixNow() - (millis() - leaseAtMs) / 1000;
+        writeFastCache();
+    }
+
+    // The DHCP server may hand an expired lease's address to another host,
+    // so the cache is only reused while the lease is known to be younger
+    // than WIFI_LEASE_REUSE_MAX_S (not before NTP after a boot)
+    bool cachedLeaseValid() {
+        if (!fastCache.ip || !fastCache.leaseUnix || !auditLog) return false;
+        uint32_t now = auditLog->unixNow();
+        return now && now - fastCache.leaseUnix < WIFI_LEASE_REUSE_MAX_S;
+    }
+
+    // Current attempt/connection gets its address from DHCP
+    bool usesDhcp() {
+#ifdef WIFI_STATIC_IP
+        return false;
+#else
+        return !leaseReused;
+#endif
+    }
+
+    // Static IP from build flags, else the cached lease while valid (fast
+    // path only), else DHCP
+    void applyIpConfig(bool useCachedLease) {
+        leaseReused = false;
+#ifdef WIFI_STATIC_IP
+        IPAddress ip, gateway, subnet, dns;
+        ip.fromString(WIFI_STATIC_IP);
+        gateway.fromString(WIFI_STATIC_GATEWAY);
+        subnet.fromString(WIFI_STATIC_SUBNET);
+        dns.fromString(WIFI_STATIC_DNS);
+        WiFi.config(ip, gateway, subnet, dns);
+#else
+        if (useCachedLease && cachedLeaseValid()) {
+            leaseReused = true;
+            WiFi.config(IPAddress(fastCache.ip), IPAddress(fastCache.gateway),
+                        IPAddress(fastCache.subnet), IPAddress(fastCache.dns));
+        } else {
+            WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));  // DHCP
+        }
+#endif
+    }
+
+    void beginAttempt(bool fast) {
+        fastAttempt = fast;
+        applyIpConfig(fast);
+        if (fast) {
+            Serial.printf("Connecting to WiFi '%s' (fast, channel %u%s)...\n", storedSSID.c_str(), fastCache.channel,
+                          usesDhcp() ? ", DHCP" : "");
+            WiFi.begin(storedSSID.c_str(), storedPass.c_str(), fastCache.channel, fastCache.bssid);
+        } else {
+            Serial.printf("Connecting to WiFi '%s'...\n", storedSSID.c_str());
+            WiFi.begin(storedSSID.c_str(), storedPass.c_str());
+        }
+        connecting = true;
+        connectStartTime = millis();
+    }
+
+    void onConnected() {
+        if (connected) return;
+        connected = true;
+
+        if (connecting) {
+            lastConnectMs = millis() - connectStartTime;
+            lastConnectFast = fastAttempt;
+            (fastAttempt ? metrics.wifiConnectFast : metrics.wifiConnectFull).observeMs(lastConnectMs);
+        }
+        connecting = false;
+        fastFailures = 0;
+        reconnectDelay = WIFI_RECONNECT_MIN_MS;
+
+        ipAddress = WiFi.localIP().toString();
+        uint32_t ip = (uint32_t)WiFi.localIP();
+        DIAG_INFO("WiFi connected in %lums (%s)! IP: %u.%u.%u.%u", (unsigned long)lastConnectMs,
+            lastConnectFast ? "fast" : "full", ip & 0xFF, (ip >> 8) & 0xFF, (ip >> 16) & 0xFF, ip >> 24);
+        saveFastCache();
+        ntpPending = true;
+    }
+
+    // Attempt timed out: fast path falls through to a full scan every
+    // WIFI_FULL_SCAN_EVERY failures (AP moved channel or was replaced);
+    // otherwise wait out the backoff and retry.
+    void onAttemptTimeout() {
+        connecting = false;
+        WiFi.disconnect(false);
+
+        if (fastAttempt) {
+            metrics.wifiFastFallbacks.inc();
+            if (++fastFailures >= WIFI_FULL_SCAN_EVERY && !deferNonUrgent) {
+                DIAG_WARN("WiFi fast connect timeout, trying full scan");
+                connect();
+                return;
+            }
+            DIAG_WARN("WiFi fast connect timeout");
+        } else {
+            DIAG_WARN("WiFi connection timeout");
+        }
+
+        lastReconnectAttempt = millis();
+        reconnectDelay = min((unsigned long)WIFI_RECONNECT_INTERVAL, reconnectDelay * 2);
     }
 
     void saveCredentials(const String& ssid, const String& pass) {
         wifiPrefs.begin("wificreds", false);
         wifiPrefs.putString("ssid", ssid);
         wifiPrefs.putString("pass", pass);
+        wifiPrefs.remove("fast");
         wifiPrefs.end();
 
         storedSSID = ssid;
         storedPass = pass;
         configured = true;
+        memset(&fastCache, 0, sizeof(fastCache));  // Filled again on first connect
         Serial.printf("WiFi credentials saved for: %s\n", ssid.c_str());
     }
 
@@ -158,7 +390,8 @@ private:
         apMode = true;
         Serial.println("Starting WiFi Setup AP...");
 
-        WiFi.mode(WIFI_AP);
+        // AP+STA so background scans and connect attempts keep the portal up
+        WiFi.mode(WIFI_AP_STA);
         WiFi.softAP(AP_SSID, AP_PASS);
 
         IPAddress apIP = WiFi.softAPIP();
@@ -174,24 +407,35 @@ private:
         setupServer = new WebServer(80);
 
         setupServer->on("/", HTTP_GET, [this]() {
-            setupServer->send_P(200, "text/html", SETUP_HTML);
+            sendStaticAsset(*setupServer, SETUP_ASSET);
         });
 
+        // Cached scan results; a background rescan starts when they are stale
         setupServer->on("/scan", HTTP_GET, [this]() {
+            if (portalScanTime == 0 || millis() - portalScanTime > PORTAL_SCAN_MAX_AGE_MS) {
+                startPortalScan();
+            }
+
             String json = "{\"networks\":[";
-            int n = WiFi.scanNetworks();
-            for (int i = 0; i < n; i++) {
+            for (int i = 0; i < portalNetworkCount; i++) {
                 if (i > 0) json += ",";
                 json += "{\"ssid\":\"";
-                json += WiFi.SSID(i);
+                appendJsonEscaped(json, portalNetworks[i].ssid);
                 json += "\",\"rssi\":";
-                json += WiFi.RSSI(i);
+                json += portalNetworks[i].rssi;
+                json += ",\"secure\":";
+                json += portalNetworks[i].secure ? "true" : "false";
                 json += "}";
             }
-            json += "]}";
+            json += "],\"age\":";
+            json += portalScanTime ? (long)(millis() - portalScanTime) : -1L;
+            json += ",\"scanning\":";
+            json += portalScanning ? "true" : "false";
+            json += "}";
             setupServer->send(200, "application/json", json);
         });
 
+        // Start a connect attempt; the page polls /status for the outcome
         setupServer->on("/save", HTTP_POST, [this]() {
             String ssid = setupServer->arg("ssid");
             String pass = setupServer->arg("pass");
@@ -200,33 +444,28 @@ private:
                 setupServer->send(200, "application/json", "{\"success\":false,\"error\":\"SSID required\"}");
                 return;
             }
-
-            // Try to connect
-            Serial.printf("Trying to connect to: %s\n", ssid.c_str());
-            WiFi.mode(WIFI_STA);
-            WiFi.begin(ssid.c_str(), pass.c_str());
-
-            int attempts = 0;
-            while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-                esp_task_wdt_reset();  // Feed watchdog during connection
-                delay(500);
-                Serial.print(".");
-                attempts++;
+            if (portalState == PORTAL_CONNECTING || portalState == PORTAL_PENDING) {
+                setupServer->send(200, "application/json", "{\"success\":false,\"error\":\"Already connecting\"}");
+                return;
             }
-            Serial.println();
-
-            if (WiFi.status() == WL_CONNECTED) {
-                Serial.printf("Connected! IP: %s\n", WiFi.localIP().toString().c_str());
-                saveCredentials(ssid, pass);
-                setupServer->send(200, "application/json", "{\"success\":true}");
-                delay(1000);
-                ESP.restart();
-            } else {
-                Serial.println("Connection failed");
-                WiFi.mode(WIFI_AP);
-                WiFi.softAP(AP_SSID, AP_PASS);
-                setupServer->send(200, "application/json", "{\"success\":false,\"error\":\"Could not connect\"}");
+
+            portalSSID = ssid;
+            portalPass = pass;
+            portalState = PORTAL_PENDING;
+            portalStateTime = millis();
+            setupServer->send(200, "application/json", "{\"success\":true,\"state\":\"connecting\"}");
+        });
+
+        setupServer->on("/status", HTTP_GET, [this]() {
+            static const char* const names[] = {"idle", "connecting", "connecting", "connected", "failed"};
+            String json = "{\"state\":\"";
+            json += names[portalState];
+            json += "\"";
+            if (portalState == PORTAL_FAILED) {
+                json += ",\"error\":\"Could not connect\"";
             }
+            json += "}";
+            setupServer->send(200, "application/json", json);
         });
 
         // Captive portal - redirect all requests
@@ -235,7 +474,9 @@ private:
             setupServer->send(302, "text/plain", "");
         });
 
+        collectStaticAssetHeaders(*setupServer);
         setupServer->begin();
+        startPortalScan();  // Results are usually ready when the page loads
         Serial.println("Setup portal started");
     }
 
@@ -249,8 +490,9 @@ public:
         if (!configured) {
             startAPMode();
         } else {
+            WiFi.persistent(false);         // Credentials live in our own NVS namespace
             WiFi.mode(WIFI_STA);
-            WiFi.setAutoReconnect(true);
+            WiFi.setAutoReconnect(false);   // Reconnects go through the fast path below
             Serial.printf("WiFi manager ready for: %s\n", storedSSID.c_str());
         }
     }
@@ -259,25 +501,19 @@ public:
         if (apMode) return;  // Don't connect in AP mode
 
         if (WiFi.status() == WL_CONNECTED) {
-            if (!connected) {
-                connected = true;
-                ipAddress = WiFi.localIP().toString();
-                Serial.printf("WiFi connected! IP: %s\n", ipAddress.c_str());
-                syncNTP();
-            }
+            onConnected();
             return;
         }
 
         if (!connecting && configured) {
-            Serial.printf("Connecting to WiFi '%s'...\n", storedSSID.c_str());
-            WiFi.begin(storedSSID.c_str(), storedPass.c_str());
-            connecting = true;
-            connectStartTime = millis();
-        }
-
-        if (connecting && (millis() - connectStartTime > WIFI_CONNECT_TIMEOUT)) {
-            connecting = false;
-            Serial.println("WiFi connection timeout");
+            bool full = !fastCache.channel || fastFailures >= WIFI_FULL_SCAN_EVERY;
+            if (full && deferNonUrgent) {
+                // An all-channel scan would starve BLE; stick to the cached channel
+                if (!fastCache.channel) return;
+                full = false;
+            }
+            if (full) fastFailures = 0;
+            beginAttempt(!full);
         }
     }
 
@@ -286,58 +522,65 @@ public:
         if (apMode) {
             if (dnsServer) dnsServer->processNextRequest();
             if (setupServer) setupServer->handleClient();
+            updatePortal();
             return;
         }
 
         // Handle client mode
         if (WiFi.status() == WL_CONNECTED) {
-            if (!connected) {
-                connected = true;
-                connecting = false;
-                ipAddress = WiFi.localIP().toString();
-                Serial.printf("WiFi connected! IP: %s\n", ipAddress.c_str());
-                syncNTP();
-            }
-        } else {
-            if (connected) {
-                connected = false;
-                ipAddress = "";
-                Serial.println("WiFi disconnected");
+            onConnected();
+            dateLease();
+            if (leaseReused && !cachedLeaseValid() && !deferNonUrgent) {
+                // The reused lease has aged out: reconnect, this time through DHCP
+                DIAG_INFO("WiFi cached lease too old, reconnecting with DHCP");
+                WiFi.disconnect(false);
+                return;
             }
-
-            if (!connecting && (millis() - lastReconnectAttempt > WIFI_RECONNECT_INTERVAL)) {
-                lastReconnectAttempt = millis();
-                connect();
+            if (ntpPending && !deferNonUrgent) {
+                ntpPending = false;
+                startNTP();
             }
+            return;
         }
-    }
-
-    void syncNTP() {
-        if (ntpInitialized || !auditLog) return;
 
-        Serial.println("Syncing NTP time...");
-        configTime(GMT_OFFSET_SEC, DAYLIGHT_OFFSET_SEC, NTP_SERVER);
+        if (connected) {
+            connected = false;
+            ipAddress = "";
+            DIAG_WARN("WiFi disconnected");
+            // Retry almost immediately: a drop is usually the car leaving,
+            // and the first fast attempt is cheap (one channel, no DHCP)
+            reconnectDelay = WIFI_RECONNECT_MIN_MS;
+            lastReconnectAttempt = millis();
+        }
 
-        struct tm timeinfo;
-        int retries = 0;
-        while (!getLocalTime(&timeinfo) && retries < 10) {
-            esp_task_wdt_reset();  // Feed watchdog during NTP sync
-            delay(500);
-            retries++;
+        if (connecting) {
+            unsigned long limit = (fastAttempt && !usesDhcp()) ? WIFI_FAST_CONNECT_TIMEOUT : WIFI_CONNECT_TIMEOUT;
+            if (millis() - connectStartTime > limit) onAttemptTimeout();
+        } else if (millis() - lastReconnectAttempt > reconnectDelay) {
+            lastReconnectAttempt = millis();
+            connect();
         }
+    }
 
-        if (retries < 10) {
-            time_t now;
-            time(&now);
-            auditLog->setNtpSync(now);
-            ntpInitialized = true;
+    // Start background SNTP; never blocks. The lwIP SNTP client retries on
+    // its own and resyncs every NTP_RESYNC_INTERVAL_MS, each sync landing in
+    // onTimeSync() -> AuditLog::setNtpSync().
+    void startNTP() {
+        if (!auditLog) return;
 
-            char timeStr[32];
-            strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", &timeinfo);
-            Serial.printf("NTP synced: %s\n", timeStr);
-        } else {
-            Serial.println("NTP sync failed");
+        if (ntpStarted) {
+            // Reconnected before the first sync: retry right away
+            if (!auditLog->isNtpSynced()) sntp_restart();
+            return;
         }
+
+        ntpOwner() = this;
+        sntp_set_time_sync_notification_cb(onTimeSync);
+        sntp_set_sync_interval(NTP_RESYNC_INTERVAL_MS);
+        configTime(GMT_OFFSET_SEC, DAYLIGHT_OFFSET_SEC, NTP_SERVER);
+        ntpStarted = true;
+        Serial.printf("NTP started (server %s, resync every %lus)\n",
+            NTP_SERVER, (unsigned long)(NTP_RESYNC_INTERVAL_MS / 1000));
     }
 
     bool isConnected() {
@@ -352,6 +595,21 @@ public:
         return WiFi.RSSI();
     }
 
+    // Set by the network task from the coexistence policy: while true, NTP
+    // start and full-scan reconnects wait
+    void setDeferNonUrgent(bool defer) {
+        deferNonUrgent = defer;
+    }
+
+    // Duration of the last successful connect (WiFi.begin() to got-IP)
+    uint32_t getLastConnectMs() {
+        return lastConnectMs;
+    }
+
+    bool wasLastConnectFast() {
+        return lastConnectFast;
+    }
+
     // Clear stored credentials (for reset)
     void clearCredentials() {
         wifiPrefs.begin("wificreds", false);
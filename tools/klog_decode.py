@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+"""
+Decode the binary log export (GET /api/log/export) to CSV or JSON.
+
+Usage:
+  klog_decode.py http://192.168.1.50/api/log/export > log.csv
+  klog_decode.py keyless-log.klg --format json
+  klog_decode.py http://car-1/api/log/export?since=1200 --format json
+
+Format: see src/log_export.h (16-byte header, 16-byte records, little-endian).
+"""
+
+import argparse
+import csv
+import datetime
+import json
+import struct
+import sys
+import urllib.request
+
+HEADER = struct.Struct("<4sBBHII")
+RECORD = struct.Struct("<QIBBbB")
+
+NTP_SYNCED = 0x0001
+REC_ABSOLUTE = 0x01
+REC_PREV_BOOT = 0x02
+
+ACTIONS = {0: "lock", 1: "unlock"}
+
+
+def read_source(source):
+    if source.startswith("http://") or source.startswith("https://"):
+        with urllib.request.urlopen(source, timeout=30) as resp:
+            return resp.read()
+    if source == "-":
+        return sys.stdin.buffer.read()
+    with open(source, "rb") as f:
+        return f.read()
+
+
+def decode(data):
+    if len(data) < HEADER.size:
+        raise ValueError("short export: %d bytes" % len(data))
+
+    magic, version, record_size, flags, count, next_cursor = HEADER.unpack_from(data, 0)
+    if magic != b"KLG1":
+        raise ValueError("bad magic %r" % magic)
+    if version != 1 or record_size < RECORD.size:
+        raise ValueError("unsupported version %d / record size %d" % (version, record_size))
+
+    records = []
+    offset = HEADER.size
+    for _ in range(count):
+        if offset + record_size > len(data):
+            raise ValueError("truncated export after %d records" % len(records))
+        time_ms, seq, device, action, rssi, rflags = RECORD.unpack_from(data, offset)
+        offset += record_size
+        if seq == 0:
+            continue  # Padding for entries overwritten during export
+
+        if rflags & REC_ABSOLUTE:
+            ts = datetime.datetime.fromtimestamp(time_ms / 1000, datetime.timezone.utc)
+            time_str, clock = ts.isoformat(timespec="milliseconds"), "utc"
+        elif rflags & REC_PREV_BOOT:
+            time_str, clock = "", "previous-boot"
+        else:
+            time_str, clock = "+%.3fs" % (time_ms / 1000), "uptime"
+
+        records.append({
+            "seq": seq,
+            "time": time_str,
+            "time_ms": time_ms,
+            "clock": clock,
+            "device": device,
+            "action": ACTIONS.get(action, str(action)),
+            "rssi": rssi,
+        })
+
+    meta = {"ntp_synced": bool(flags & NTP_SYNCED), "next": next_cursor, "count": len(records)}
+    return meta, records
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source", help="URL, file path or - for stdin")
+    parser.add_argument("--format", choices=["csv", "json"], default="csv")
+    args = parser.parse_args()
+
+    meta, records = decode(read_source(args.source))
+
+    if args.format == "json":
+        json.dump({"meta": meta, "log": records}, sys.stdout, indent=1)
+        sys.stdout.write("\n")
+    else:
+        writer = csv.DictWriter(sys.stdout, fieldnames=["seq", "time", "time_ms", "clock", "device", "action", "rssi"])
+        writer.writeheader()
+        writer.writerows(records)
+
+    print("decoded %d records, next cursor %d" % (meta["count"], meta["next"]), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+"""
+Minimal SNTP server for testing the firmware's background time sync.
+
+Usage:
+  sudo tools/ntp_standin.py                    # serve system time on UDP 123
+  tools/ntp_standin.py --port 1123 --offset 2.5 --drift 50
+
+Build the firmware against it with
+  build_flags = -DNTP_SERVER=\\"<this host's IP>\\"
+(the ESP32 SNTP client always uses port 123, so --port is for local tests).
+
+--offset shifts the served time by a fixed number of seconds; --drift adds
+N ms per minute since start, which shows up as ntpDriftMs in /api/status
+after each periodic resync.
+"""
+
+import argparse
+import socket
+import struct
+import time
+
+NTP_EPOCH_DELTA = 2208988800  # 1900-01-01 -> 1970-01-01
+
+
+def to_ntp(t):
+    secs = int(t)
+    frac = int((t - secs) * (1 << 32))
+    return secs + NTP_EPOCH_DELTA, frac
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--bind", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=123)
+    parser.add_argument("--offset", type=float, default=0.0, help="seconds added to served time")
+    parser.add_argument("--drift", type=float, default=0.0, help="ms added per minute since start")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind((args.bind, args.port))
+    start = time.time()
+    print("SNTP stand-in on %s:%d" % (args.bind, args.port))
+
+    while True:
+        data, addr = sock.recvfrom(512)
+        if len(data) < 48:
+            continue
+        now = time.time()
+        served = now + args.offset + (now - start) / 60.0 * args.drift / 1000.0
+
+        recv_s, recv_f = to_ntp(served)
+        # LI=0, VN=4, Mode=4 (server), stratum 1, poll copied, precision -20
+        reply = struct.pack("!BBbb", 0x24, 1, data[2], -20)
+        reply += struct.pack("!II", 0, 0)            # root delay / dispersion
+        reply += b"LOCL"                              # reference id
+        reply += struct.pack("!II", recv_s, recv_f)  # reference timestamp
+        reply += data[40:48]                          # originate = client transmit
+        reply += struct.pack("!II", recv_s, recv_f)  # receive timestamp
+        reply += struct.pack("!II", *to_ntp(served)) # transmit timestamp
+        sock.sendto(reply, addr)
+        print("%s -> %s" % (addr[0], time.strftime("%Y-%m-%d %H:%M:%S", time.gmtime(served))))
+
+
+if __name__ == "__main__":
+    main()
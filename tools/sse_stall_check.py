@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""
+Measure how long an SSE connect holds up the dashboard's other requests.
+
+Usage:
+  tools/sse_stall_check.py http://<ESP32-IP>
+  tools/sse_stall_check.py http://<ESP32-IP> --rounds 10 --limit 0.5
+
+Each round opens /api/events, waits for the stream's headers, then times a
+GET /api/status on a second connection while the stream stays open. The
+web server handles one connection at a time, so a server that keeps the
+handed-off SSE socket as its current client (waiting up to 2 s for the
+browser to close it) shows up as a ~2 s status request. Exits 1 if the
+slowest round is above --limit seconds.
+"""
+
+import argparse
+import http.client
+import socket
+import statistics
+import sys
+import time
+from urllib.parse import urlparse
+
+
+def open_stream(host, port, timeout):
+    sock = socket.create_connection((host, port), timeout=timeout)
+    sock.sendall(b"GET /api/events HTTP/1.1\r\nHost: %s\r\nAccept: text/event-stream\r\n\r\n" % host.encode())
+    data = b""
+    while b"\r\n\r\n" not in data:
+        chunk = sock.recv(512)
+        if not chunk:
+            raise RuntimeError("stream closed before its headers")
+        data += chunk
+    status = data.split(b"\r\n", 1)[0].decode(errors="replace")
+    if " 200 " not in status + " ":
+        raise RuntimeError("/api/events answered %s" % status)
+    return sock
+
+
+def timed_status(host, port, timeout):
+    start = time.monotonic()
+    conn = http.client.HTTPConnection(host, port, timeout=timeout)
+    conn.request("GET", "/api/status")
+    resp = conn.getresponse()
+    resp.read()
+    conn.close()
+    if resp.status != 200:
+        raise RuntimeError("/api/status answered %d" % resp.status)
+    return time.monotonic() - start
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("url", help="dashboard base URL, e.g. http://192.168.1.50")
+    parser.add_argument("--rounds", type=int, default=5)
+    parser.add_argument("--limit", type=float, default=1.0, help="max seconds for the status request")
+    parser.add_argument("--timeout", type=float, default=10.0)
+    args = parser.parse_args()
+
+    url = urlparse(args.url)
+    host, port = url.hostname, url.port or 80
+
+    baseline = timed_status(host, port, args.timeout)
+    print("status alone:        %6.0f ms" % (baseline * 1000))
+
+    times = []
+    for r in range(args.rounds):
+        stream = open_stream(host, port, args.timeout)
+        try:
+            times.append(timed_status(host, port, args.timeout))
+        finally:
+            stream.close()
+        print("round %2d, stream on: %6.0f ms" % (r + 1, times[-1] * 1000))
+        time.sleep(0.5)     # Let the device notice the closed stream and free its slot
+
+    print("median %.0f ms, max %.0f ms (limit %.0f ms)" %
+          (statistics.median(times) * 1000, max(times) * 1000, args.limit * 1000))
+    return 1 if max(times) > args.limit else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,234 @@
+#!/usr/bin/env python3
+"""
+Turn the hot-path trace ring (GET /api/trace) into per-stage latency
+percentiles and a Chrome trace timeline (chrome://tracing, Perfetto).
+
+Usage:
+  trace_report.py http://192.168.1.50/api/trace
+  trace_report.py http://car-1/api/trace --poll 2 --duration 120 --chrome unlock.json
+  trace_report.py dump1.json dump2.json --chrome trace.json
+
+The ring only holds the last few hundred events; --poll fetches with the
+?since= cursor so a longer session can be collected without gaps.
+
+Format: see src/trace.h. Records are [index, core, event, cycles, arg];
+cycles are per-core CPU cycle counts, put on one timeline with the
+periodic "sync" records (cycles + esp_timer microseconds).
+"""
+
+import argparse
+import json
+import sys
+import time
+import urllib.request
+
+DECISIONS = {1: "unlock", 2: "nearby", 3: "weak", 4: "gone"}
+
+# (name, from event, to event) measured within one advert chain. The chain
+# starts on the scan callback's core and, through the ingest queue (FIFO),
+# continues on the resolve task's core from "dequeue".
+CHAIN_STAGES = [
+    ("gap_cb->prefilter", "gap_cb", "prefilter"),
+    ("prefilter->dequeue (queue wait)", "prefilter", "dequeue"),
+    ("dequeue->rpa_start", "dequeue", "rpa_start"),
+    ("rpa (AES)", "rpa_start", "rpa_end"),
+    ("rpa_end->decision", "rpa_end", "proximity"),
+]
+
+
+def fetch(source, since=None):
+    if source.startswith("http://") or source.startswith("https://"):
+        url = source
+        if since is not None:
+            url += ("&" if "?" in url else "?") + "since=%d" % since
+        with urllib.request.urlopen(url, timeout=30) as resp:
+            return json.loads(resp.read())
+    if source == "-":
+        return json.load(sys.stdin)
+    with open(source, "r", encoding="utf-8") as f:
+        return json.load(f)
+
+
+def collect(args):
+    dumps = []
+    if args.poll and len(args.sources) == 1:
+        cursor = None
+        deadline = time.time() + args.duration
+        while time.time() < deadline:
+            dump = fetch(args.sources[0], cursor)
+            dumps.append(dump)
+            cursor = dump["next"]
+            time.sleep(args.poll)
+    else:
+        dumps = [fetch(s) for s in args.sources]
+
+    meta = dumps[0]
+    records = {}
+    for dump in dumps:
+        for rec in dump["records"]:
+            records[rec[0]] = rec  # De-duplicate overlapping dumps by index
+    return meta, [records[i] for i in sorted(records)]
+
+
+def to_timeline(meta, records):
+    """Return [(time_us, core, event_name, arg, index)] on a common clock."""
+    mhz = float(meta["cpuMhz"])
+    names = meta["events"]
+
+    # Sync points per core, with the 32-bit esp_timer value unwrapped
+    syncs = {}
+    last_us = None
+    wraps = 0
+    for index, core, event, cycles, arg in records:
+        if names[event] != "sync":
+            continue
+        if last_us is not None and arg < last_us:
+            wraps += 1
+        last_us = arg
+        syncs.setdefault(core, []).append((index, cycles, arg + (wraps << 32)))
+
+    timeline = []
+    for index, core, event, cycles, arg in records:
+        points = syncs.get(core)
+        if not points or names[event] == "sync":
+            continue
+        # Nearest sync at or before this record, else the first one after it
+        ref = points[0]
+        for p in points:
+            if p[0] > index:
+                break
+            ref = p
+        delta = ((cycles - ref[1] + (1 << 31)) % (1 << 32)) - (1 << 31)
+        timeline.append((ref[2] + delta / mhz, core, names[event], arg, index))
+
+    timeline.sort()
+    return timeline
+
+
+def measure(timeline):
+    stages = {name: [] for name, _, _ in CHAIN_STAGES}
+    stages.update({"nvs write": [], "key_power->unlock_edge": [],
+                   "gap_cb->key_power": [], "gap_cb->unlock_edge (end-to-end)": []})
+    spans = []      # (name, start, dur, core, args) for the Chrome trace
+
+    chain = {}          # core -> {event: time} for the advert being processed
+    queued = []         # Chains in the ingest queue, oldest first
+    nvs_start = {}      # core -> time
+    unlock_gap = None   # gap_cb time of the advert that decided to unlock
+    key_power = None
+
+    for t, core, name, arg, _ in timeline:
+        if name == "gap_cb":
+            chain[core] = {"gap_cb": t}
+        elif name == "prefilter" and core in chain:
+            c = chain.pop(core)
+            c["prefilter"] = t
+            queued.append(c)
+        elif name == "queue_drop" and queued:
+            c = queued.pop()  # The candidate just pre-filtered
+            spans.append(("advert (dropped)", c["gap_cb"], t - c["gap_cb"], core, {}))
+        elif name == "dequeue":
+            if queued:
+                c = queued.pop(0)
+                c["dequeue"] = t
+                chain[core] = c
+            else:
+                chain.pop(core, None)  # Enqueued before the dump started
+        elif name in ("rpa_start", "rpa_end", "proximity") and core in chain:
+            chain[core][name] = t
+            if name == "proximity":
+                c = chain.pop(core)
+                for stage, a, b in CHAIN_STAGES:
+                    if a in c and b in c:
+                        stages[stage].append(c[b] - c[a])
+                spans.append(("advert", c["gap_cb"], t - c["gap_cb"], core,
+                              {"device": arg >> 8, "decision": DECISIONS.get(arg & 0xFF, arg & 0xFF)}))
+                if arg & 0xFF == 1:
+                    unlock_gap = c["gap_cb"]
+            elif name == "rpa_end" and arg == 0:
+                c = chain.pop(core)  # No match, the chain ends here
+                spans.append(("advert (no match)", c["gap_cb"], t - c["gap_cb"], core, {}))
+        elif name == "nvs_start":
+            nvs_start[core] = t
+        elif name == "nvs_end" and core in nvs_start:
+            start = nvs_start.pop(core)
+            stages["nvs write"].append(t - start)
+            spans.append(("nvs write", start, t - start, core, {}))
+        elif name == "key_power":
+            key_power = t
+            if unlock_gap is not None:
+                stages["gap_cb->key_power"].append(t - unlock_gap)
+        elif name == "unlock_edge":
+            if key_power is not None:
+                stages["key_power->unlock_edge"].append(t - key_power)
+            if unlock_gap is not None:
+                stages["gap_cb->unlock_edge (end-to-end)"].append(t - unlock_gap)
+            unlock_gap = key_power = None
+
+    return stages, spans
+
+
+def percentile(values, p):
+    values = sorted(values)
+    k = (len(values) - 1) * p / 100.0
+    lo = int(k)
+    hi = min(lo + 1, len(values) - 1)
+    return values[lo] + (values[hi] - values[lo]) * (k - lo)
+
+
+def fmt_us(us):
+    return "%.1fms" % (us / 1000) if us >= 1000 else "%.1fus" % us
+
+
+def print_report(stages, out):
+    out.write("%-36s %6s %10s %10s %10s %10s\n" % ("stage", "n", "p50", "p90", "p99", "max"))
+    for name, values in stages.items():
+        if not values:
+            out.write("%-36s %6d\n" % (name, 0))
+            continue
+        out.write("%-36s %6d %10s %10s %10s %10s\n" % (
+            name, len(values), fmt_us(percentile(values, 50)), fmt_us(percentile(values, 90)),
+            fmt_us(percentile(values, 99)), fmt_us(max(values))))
+
+
+def chrome_trace(timeline, spans):
+    events = [{"name": "thread_name", "ph": "M", "pid": 0, "tid": core,
+               "args": {"name": "core %d" % core}} for core in (0, 1)]
+    for name, start, dur, core, args in spans:
+        events.append({"name": name, "ph": "X", "pid": 0, "tid": core,
+                       "ts": start, "dur": max(dur, 0.1), "args": args})
+    for t, core, name, arg, index in timeline:
+        if name in ("key_power", "unlock_edge", "lock_edge"):
+            events.append({"name": name, "ph": "i", "s": "g", "pid": 0, "tid": core,
+                           "ts": t, "args": {"index": index}})
+    return {"traceEvents": events, "displayTimeUnit": "ms"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("sources", nargs="+", help="URL of /api/trace, dump file(s) or - for stdin")
+    parser.add_argument("--poll", type=float, default=0, help="fetch every N seconds using the since cursor")
+    parser.add_argument("--duration", type=float, default=60, help="polling duration in seconds")
+    parser.add_argument("--chrome", help="write a Chrome trace JSON timeline to this file")
+    parser.add_argument("--save", help="write the merged raw dump to this file")
+    args = parser.parse_args()
+
+    meta, records = collect(args)
+    if args.save:
+        with open(args.save, "w", encoding="utf-8") as f:
+            json.dump(dict(meta, records=records), f)
+
+    timeline = to_timeline(meta, records)
+    stages, spans = measure(timeline)
+
+    sys.stdout.write("%d records, %d events on the timeline\n" % (len(records), len(timeline)))
+    print_report(stages, sys.stdout)
+
+    if args.chrome:
+        with open(args.chrome, "w", encoding="utf-8") as f:
+            json.dump(chrome_trace(timeline, spans), f)
+        sys.stdout.write("Chrome trace written to %s\n" % args.chrome)
+
+
+if __name__ == "__main__":
+    main()